@@ -0,0 +1,164 @@
+#pragma once
+
+#include <functional>
+#include <string_view>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <atomic>
+
+
+namespace bench {
+
+    /**
+     *  Prevent the compiler from optimizing away a value
+     *
+     *  @param  value   The value that must be computed
+     */
+    template <typename T>
+    void do_not_optimize(const T& value) noexcept
+    {
+        #if defined(__GNUC__)
+            asm volatile("" : : "r,m"(value) : "memory");
+        #else
+            static volatile const void* sink;
+            sink = &value;
+        #endif
+    }
+
+    /**
+     *  The formats the results can be reported in
+     */
+    enum class format
+    {
+        text,   // aligned columns, for reading
+        csv     // comma-separated values, for comparing runs
+    };
+
+    /**
+     *  Retrieve the format to report the results in
+     *
+     *  @return The format, which can be changed
+     */
+    inline format& output_format() noexcept
+    {
+        static format current{ format::text };
+        return current;
+    }
+
+    /**
+     *  Retrieve the name of the group that is running
+     *
+     *  @return The group name, which can be changed
+     */
+    inline std::string& current_group()
+    {
+        static std::string current;
+        return current;
+    }
+
+    /**
+     *  Retrieve the number of memory allocations made so far,
+     *  this is counted by the allocation functions in main.cpp
+     *
+     *  @return The allocation counter
+     */
+    std::atomic<std::size_t>& allocations() noexcept;
+
+    /**
+     *  Report the result of a benchmark
+     *
+     *  @param  name        The name of the benchmark
+     *  @param  nanoseconds The time per operation
+     *  @param  allocated   The number of allocations per operation
+     */
+    inline void report(std::string_view name, double nanoseconds, double allocated)
+    {
+        if (output_format() == format::csv) {
+            // quote the name, doubling any quotes inside it
+            std::string quoted;
+
+            for (char character : name) {
+                quoted += character;
+
+                if (character == '"') {
+                    quoted += character;
+                }
+            }
+
+            std::printf("%s,\"%s\",%.1f,%.2f\n", current_group().c_str(), quoted.c_str(), nanoseconds, allocated);
+        } else {
+            std::printf("%-60.*s %12.1f ns/op %8.2f allocs/op\n", static_cast<int>(name.size()), name.data(), nanoseconds, allocated);
+        }
+    }
+
+    /**
+     *  Run an operation repeatedly and report its cost
+     *
+     *  The number of iterations is scaled up until the
+     *  run takes long enough to give a stable result.
+     *
+     *  @param  name        The name of the benchmark
+     *  @param  operation   The operation to measure
+     *  @param  items       The number of items handled by one operation, the cost is reported per item
+     */
+    template <typename callable>
+    void measure(std::string_view name, callable&& operation, std::size_t items = 1)
+    {
+        using clock = std::chrono::steady_clock;
+
+        // start with a single iteration and grow from there
+        for (std::size_t iterations{ 1 };; iterations *= 2) {
+            // time a run of the operation, counting the allocations
+            auto allocated  = allocations().load(std::memory_order_relaxed);
+            auto start      = clock::now();
+
+            for (std::size_t i{ 0 }; i < iterations; ++i) {
+                operation();
+            }
+
+            auto elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+            allocated = allocations().load(std::memory_order_relaxed) - allocated;
+
+            // is the measurement long enough to be reliable?
+            if (elapsed > 1e8 || iterations >= (std::size_t{ 1 } << 30)) {
+                // the number of items handled in the run
+                double count = static_cast<double>(iterations) * static_cast<double>(items);
+
+                report(name, elapsed / count, static_cast<double>(allocated) / count);
+                return;
+            }
+        }
+    }
+
+    /**
+     *  Retrieve all registered benchmark groups
+     *
+     *  @return The registered groups
+     */
+    inline std::vector<std::pair<std::string, std::function<void()>>>& groups()
+    {
+        static std::vector<std::pair<std::string, std::function<void()>>> groups;
+        return groups;
+    }
+
+    /**
+     *  Helper for registering a group of benchmarks
+     */
+    struct group
+    {
+        /**
+         *  Constructor
+         *
+         *  @param  name    The name of the group
+         *  @param  run     The function running the benchmarks
+         */
+        group(std::string name, std::function<void()> run)
+        {
+            groups().emplace_back(std::move(name), std::move(run));
+        }
+    };
+
+}
@@ -0,0 +1,140 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+
+
+namespace bench {
+
+    /**
+     *  Retrieve the number of memory allocations made so far
+     *
+     *  @return The allocation counter
+     */
+    std::atomic<std::size_t>& allocations() noexcept
+    {
+        static std::atomic<std::size_t> count{ 0 };
+        return count;
+    }
+
+    /**
+     *  Allocate memory and count the allocation
+     *
+     *  @param  size        The number of bytes to allocate
+     *  @param  alignment   The alignment required, zero for the default
+     *  @return The allocated memory, or a nullptr if none is available
+     */
+    void* allocate(std::size_t size, std::size_t alignment) noexcept
+    {
+        // count the allocation
+        allocations().fetch_add(1, std::memory_order_relaxed);
+
+        // malloc may return a nullptr for an empty allocation
+        if (alignment == 0) {
+            return std::malloc(size == 0 ? 1 : size);
+        }
+
+        // aligned_alloc needs at least the alignment of a pointer,
+        // and a size that is a multiple of the alignment
+        alignment   = std::max(alignment, sizeof(void*));
+        size        = (std::max<std::size_t>(size, 1) + alignment - 1) & ~(alignment - 1);
+
+        return std::aligned_alloc(alignment, size);
+    }
+
+}
+
+/**
+ *  Count all allocations, so the benchmarks can report them
+ *
+ *  The array versions are not replaced, by default they use these. The
+ *  aligned versions are used for types like the slots of the route cache.
+ *
+ *  @param  size        The number of bytes to allocate
+ *  @param  alignment   The alignment required
+ *  @return The allocated memory, or a nullptr for the nothrow versions
+ */
+void* operator new(std::size_t size)
+{
+    if (auto* result = bench::allocate(size, 0); result != nullptr) {
+        return result;
+    }
+
+    throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (auto* result = bench::allocate(size, static_cast<std::size_t>(alignment)); result != nullptr) {
+        return result;
+    }
+
+    throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return bench::allocate(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return bench::allocate(size, static_cast<std::size_t>(alignment));
+}
+
+/**
+ *  Release memory allocated by the counting operator new, the memory
+ *  is released in the same way for every version
+ *
+ *  @param  pointer The memory to release
+ */
+void operator delete(void* pointer) noexcept                                                    { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept                                       { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept                                  { std::free(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept                     { std::free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept                             { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept           { std::free(pointer); }
+
+int main(int argc, const char* argv[])
+{
+    // the groups selected on the command line
+    std::vector<std::string_view> selected;
+
+    // parse the options and the group names
+    for (int i{ 1 }; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--csv") == 0) {
+            bench::output_format() = bench::format::csv;
+        } else {
+            selected.emplace_back(argv[i]);
+        }
+    }
+
+    // the csv output starts with the column names
+    if (bench::output_format() == bench::format::csv) {
+        std::printf("group,benchmark,ns_per_op,allocs_per_op\n");
+    }
+
+    // run all groups, or only those given on the command line
+    for (const auto& [name, run] : bench::groups()) {
+        // check whether the group was selected
+        bool enabled = selected.empty();
+
+        for (auto group : selected) {
+            enabled |= name == group;
+        }
+
+        if (!enabled) {
+            continue;
+        }
+
+        // the text output has a header for every group
+        if (bench::output_format() == bench::format::text) {
+            std::printf("%s\n", name.c_str());
+        }
+
+        bench::current_group() = name;
+        run();
+    }
+}
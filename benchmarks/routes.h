@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+namespace bench {
+
+    /**
+     *  A set of routes, with endpoints to route with them
+     */
+    struct route_set
+    {
+        std::string                 name;           // the name of the set
+        std::vector<std::string>    patterns;       // the patterns to add
+        std::vector<std::string>    static_hits;    // endpoints matching a route without slugs
+        std::vector<std::string>    slug_hits;      // endpoints matching a route with slugs
+        std::vector<std::string>    misses;         // endpoints sharing a long prefix with a route, but not matching
+    };
+
+    /**
+     *  A REST api modeled after the one from GitHub
+     *
+     *  @return The route set
+     */
+    inline route_set github()
+    {
+        // the slugs used by the routes
+        const std::string name      { "{[^/]+}"         };
+        const std::string number    { "{\\d+}"          };
+        const std::string sha       { "{[0-9a-f]{40}}"  };
+        const std::string repo      { "/repos/" + name + "/" + name };
+
+        route_set result{ "github", {
+            "/user", "/user/repos", "/user/orgs", "/user/keys", "/user/emails",
+            "/users/" + name, "/users/" + name + "/repos", "/users/" + name + "/followers", "/users/" + name + "/following", "/users/" + name + "/gists",
+            "/orgs/" + name, "/orgs/" + name + "/repos", "/orgs/" + name + "/members", "/orgs/" + name + "/teams", "/orgs/" + name + "/hooks/" + number,
+            repo, repo + "/issues", repo + "/issues/" + number, repo + "/issues/" + number + "/comments", repo + "/issues/" + number + "/labels",
+            repo + "/pulls", repo + "/pulls/" + number, repo + "/pulls/" + number + "/files", repo + "/pulls/" + number + "/commits", repo + "/pulls/" + number + "/reviews",
+            repo + "/commits", repo + "/commits/" + sha, repo + "/commits/" + sha + "/comments", repo + "/branches", repo + "/branches/" + name,
+            repo + "/tags", repo + "/releases", repo + "/releases/latest", repo + "/releases/" + number, repo + "/contents/{.+}",
+            repo + "/git/refs", repo + "/git/trees/" + sha, repo + "/hooks", repo + "/hooks/" + number, repo + "/collaborators",
+            repo + "/stargazers", repo + "/forks", "/gists", "/gists/public", "/gists/starred",
+            "/gists/" + name, "/gists/" + name + "/comments", "/notifications", "/search/repositories", "/search/issues",
+            "/search/users", "/search/code", "/emojis", "/meta", "/rate_limit", "/events", "/feeds",
+        }, {}, {}, {} };
+
+        result.static_hits = {
+            "/user", "/user/repos", "/meta", "/rate_limit", "/gists/public", "/search/issues", "/emojis", "/notifications",
+        };
+
+        result.slug_hits = {
+            "/repos/omartijn/cpprouter/issues/42", "/users/octocat/repos", "/repos/omartijn/cpprouter/pulls/7/files",
+            "/repos/omartijn/cpprouter/commits/0123456789abcdef0123456789abcdef01234567", "/orgs/github/teams",
+            "/gists/aa5a315d61ae9438b18d", "/repos/omartijn/cpprouter/contents/include/router/table.h", "/repos/omartijn/cpprouter/releases/latest",
+        };
+
+        result.misses = {
+            "/repos/omartijn/cpprouter/issues/42/unknown", "/repos/omartijn/cpprouter/pulls/x/files", "/users/octocat/repos/extra",
+            "/orgs/github/teams/x/y", "/repos/omartijn/cpprouter/commits/0123456789abcdef", "/search/repositories/x",
+            "/repos/omartijn/cpprouter/git/trees/xyz", "/gists/aa5a315d61ae9438b18d/forks",
+        };
+
+        return result;
+    }
+
+    /**
+     *  A large number of generated routes, spread over many tenants
+     *
+     *  @param  count   The number of routes to generate
+     *  @return The route set
+     */
+    inline route_set synthetic(std::size_t count)
+    {
+        route_set result{ "synthetic " + std::to_string(count), {}, {}, {}, {} };
+
+        for (std::size_t i{ 0 }; i < count; ++i) {
+            // the tenant the route belongs to
+            auto tenant = std::to_string(i * 7919 % count);
+
+            switch (i % 3) {
+                case 0:  result.patterns.push_back("/tenant/" + tenant + "/status");                       break;
+                case 1:  result.patterns.push_back("/tenant/" + tenant + "/users/{\\d+}");                break;
+                default: result.patterns.push_back("/tenant/" + tenant + "/items/{[0-9a-f]{24}}/{\\w+}"); break;
+            }
+        }
+
+        // pick endpoints spread over all tenants, every tenant has a
+        // single route, depending on the position it was generated at
+        for (std::size_t i{ 0 }; i < 8; ++i) {
+            // the tenants with a static route and with a user route
+            auto status = std::to_string(i * 3 * 7919 % count);
+            auto users  = std::to_string((i * 3 + 1) * 7919 % count);
+
+            result.static_hits.push_back("/tenant/" + status + "/status");
+            result.slug_hits.push_back("/tenant/" + users + "/users/" + std::to_string(i * 1234));
+            result.misses.push_back("/tenant/" + users + "/users/" + std::to_string(i * 1234) + "x");
+        }
+
+        return result;
+    }
+
+    /**
+     *  Routes without a literal prefix, which can not be told apart
+     *  until the slugs are matched, so all of them have to be tried
+     *
+     *  @param  count   The number of routes to generate
+     *  @return The route set
+     */
+    inline route_set prefixless(std::size_t count)
+    {
+        route_set result{ "prefixless " + std::to_string(count), {}, {}, {}, {} };
+
+        for (std::size_t i{ 0 }; i < count; ++i) {
+            result.patterns.push_back("/{[a-z]{2}}/section" + std::to_string(i) + "/{\\d+}");
+        }
+
+        // a few static routes, which are not affected
+        result.patterns.push_back("/");
+        result.patterns.push_back("/health");
+
+        result.static_hits  = { "/", "/health" };
+        result.slug_hits    = { "/en/section0/1", "/nl/section" + std::to_string(count / 2) + "/42", "/de/section" + std::to_string(count - 1) + "/7" };
+        result.misses       = { "/en/section0/x", "/english/section1/1", "/nl/section" + std::to_string(count) + "/1" };
+
+        return result;
+    }
+
+}
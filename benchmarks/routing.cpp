@@ -0,0 +1,200 @@
+#include "benchmark.h"
+#include "routes.h"
+
+#include <router/table.h>
+#include <router/variables.h>
+
+
+namespace {
+
+    /**
+     *  The callback used for all routes
+     */
+    std::size_t callback() { return 1; }
+
+    /**
+     *  The table type to route with
+     */
+    using table_type = router::table<std::size_t()>;
+
+    /**
+     *  Check that the endpoints of a route set are routed as expected,
+     *  so that a broken route set does not silently measure misses
+     *
+     *  @param  set     The route set
+     *  @param  table   The table holding the routes
+     */
+    void check(const bench::route_set& set, const table_type& table)
+    {
+        for (const auto* endpoints : { &set.static_hits, &set.slug_hits }) {
+            for (const auto& endpoint : *endpoints) {
+                if (!table.routable(endpoint)) {
+                    std::fprintf(stderr, "%s: %s is not routed\n", set.name.c_str(), endpoint.c_str());
+                }
+            }
+        }
+
+        for (const auto& endpoint : set.misses) {
+            if (table.routable(endpoint)) {
+                std::fprintf(stderr, "%s: %s is routed\n", set.name.c_str(), endpoint.c_str());
+            }
+        }
+    }
+
+    /**
+     *  Measure matching a list of endpoints
+     *
+     *  @param  name        The name of the benchmark
+     *  @param  table       The table to match with
+     *  @param  endpoints   The endpoints to match
+     */
+    void lookup(const std::string& name, const table_type& table, const std::vector<std::string>& endpoints)
+    {
+        bench::measure(name, [&]() {
+            for (const auto& endpoint : endpoints) {
+                auto match = table.match(endpoint);
+                bench::do_not_optimize(match);
+            }
+        }, endpoints.size());
+    }
+
+    /**
+     *  Run all benchmarks for a route set
+     *
+     *  @param  set The route set to benchmark
+     */
+    void run(const bench::route_set& set)
+    {
+        // the routes to add at once
+        std::vector<table_type::route_type> routes;
+
+        for (const auto& pattern : set.patterns) {
+            routes.push_back(table_type::make_route<&callback>(pattern));
+        }
+
+        // building the table, reported per route
+        bench::measure(set.name + ": add", [&]() {
+            table_type table;
+
+            for (const auto& pattern : set.patterns) {
+                table.add<&callback>(pattern);
+            }
+
+            bench::do_not_optimize(table);
+        }, set.patterns.size());
+
+        bench::measure(set.name + ": add_all", [&]() {
+            table_type table;
+            table.add_all(begin(routes), end(routes));
+            bench::do_not_optimize(table);
+        }, set.patterns.size());
+
+        // the table to route with
+        table_type table;
+        table.add_all(begin(routes), end(routes));
+        check(set, table);
+
+        lookup(set.name + ": static hit",   table, set.static_hits);
+        lookup(set.name + ": slug hit",     table, set.slug_hits);
+        lookup(set.name + ": deep miss",    table, set.misses);
+    }
+
+    bench::group routing{ "routing", []() {
+        run(bench::github());
+        run(bench::synthetic(10000));
+        run(bench::prefixless(1000));
+    } };
+
+    /**
+     *  The methods to dispatch on
+     */
+    enum class method { get, head, post, put, patch, remove };
+
+    /**
+     *  The proxy table to dispatch with
+     */
+    using proxy_table = router::table<router::proxy<std::size_t(), method::get, method::head, method::post, method::put, method::patch, method::remove>>;
+
+    /**
+     *  The handler for methods without a callback
+     *
+     *  @param  allowed The methods that do have a callback
+     *  @return The number of allowed methods
+     */
+    std::size_t not_allowed(proxy_table::method_set_type allowed) { return allowed.size(); }
+
+    /**
+     *  A data transfer object for an issue
+     */
+    struct issue
+    {
+        std::string owner;
+        std::string repository;
+        int         number;
+
+        using dto = router::dto<issue>
+            ::bind<&issue::owner>
+            ::bind<&issue::repository>
+            ::bind<&issue::number>;
+    };
+
+    /**
+     *  Callbacks taking the slugs as separate parameters, as a tuple and as a dto
+     */
+    std::size_t parameters(std::string_view owner, std::string_view repository, int number) { return owner.size() + repository.size() + static_cast<std::size_t>(number); }
+    std::size_t tuple(std::tuple<std::string, std::string, int>&& slugs) { return std::get<0>(slugs).size() + static_cast<std::size_t>(std::get<2>(slugs)); }
+    std::size_t object(issue&& slugs) { return slugs.owner.size() + static_cast<std::size_t>(slugs.number); }
+
+    bench::group dispatch{ "dispatch", []() {
+        // the github routes, handling get and head on every route
+        auto set = bench::github();
+
+        proxy_table proxies;
+        proxies.set_not_proxied<&not_allowed>();
+
+        for (const auto& pattern : set.patterns) {
+            proxies.add(pattern).set<&callback>({ method::get, method::head });
+        }
+
+        bench::measure("proxy: github get", [&]() {
+            for (const auto& endpoint : set.slug_hits) {
+                bench::do_not_optimize(proxies.route(endpoint, method::get));
+            }
+        }, set.slug_hits.size());
+
+        bench::measure("proxy: github not allowed", [&]() {
+            for (const auto& endpoint : set.slug_hits) {
+                bench::do_not_optimize(proxies.route(endpoint, method::remove));
+            }
+        }, set.slug_hits.size());
+
+        // converting the slugs for the callback
+        const std::string pattern   { "/repos/{[^/]+}/{[^/]+}/issues/{\\d+}" };
+        const std::string endpoint  { "/repos/omartijn/cpprouter/issues/42" };
+
+        table_type table;
+        table.add<&callback>(pattern);
+
+        router::table<std::size_t()> converted[3];
+        converted[0].add<&parameters>(pattern);
+        converted[1].add<&tuple>(pattern);
+        converted[2].add<&object>(pattern);
+
+        bench::measure("slugs: none", [&]() {
+            bench::do_not_optimize(table.route(endpoint));
+        });
+
+        bench::measure("slugs: parameters", [&]() {
+            bench::do_not_optimize(converted[0].route(endpoint));
+        });
+
+        bench::measure("slugs: tuple", [&]() {
+            bench::do_not_optimize(converted[1].route(endpoint));
+        });
+
+        bench::measure("slugs: dto", [&]() {
+            bench::do_not_optimize(converted[2].route(endpoint));
+        });
+    } };
+
+}
@@ -0,0 +1,72 @@
+#include "benchmark.h"
+
+#include <router/slug.h>
+
+
+namespace {
+
+    /**
+     *  Compare a slug against the regular expression it replaces
+     *
+     *  @param  expression  The slug expression
+     *  @param  input       The input to match
+     */
+    void compare(std::string_view expression, std::string_view input)
+    {
+        // create the slug from the expression
+        std::string         pattern { "{" + std::string{ expression } + "}" };
+        std::string_view    data    { pattern };
+        router::slug        slug    { data };
+        std::regex          regex   { begin(expression), end(expression) };
+
+        // the label to print for the benchmarks
+        std::string label{ std::string{ expression } + " on \"" + std::string{ input } + "\"" };
+
+        bench::measure("regex   " + label, [&]() {
+            std::match_results<std::string_view::const_iterator> matches;
+            bool matched = std::regex_search(begin(input), end(input), matches, regex) && matches.position(0) == 0;
+            bench::do_not_optimize(matched);
+        });
+
+        bench::measure("slug    " + label, [&]() {
+            std::string_view remaining  { input };
+            std::string_view output     {};
+            bool matched = slug.match(remaining, output);
+            bench::do_not_optimize(matched);
+            bench::do_not_optimize(output);
+        });
+    }
+
+    /**
+     *  Measure a slug failing to match a long input
+     *
+     *  @param  pattern The slug pattern, including the braces
+     */
+    void long_miss(std::string_view pattern)
+    {
+        // create the slug and an input that does not match
+        std::string_view    data    { pattern           };
+        router::slug        slug    { data              };
+        std::string         input   ( 4096, 'a'         );
+
+        bench::measure("slug    " + std::string{ pattern } + " missing on 4 KB", [&]() {
+            std::string_view remaining  { input };
+            std::string_view output     {};
+            bool matched = slug.match(remaining, output);
+            bench::do_not_optimize(matched);
+        });
+    }
+
+    bench::group slugs{ "slug", []() {
+        compare("\\d+",             "1234567/items");
+        compare("\\w+",             "hello_world/items");
+        compare("[^/]+",            "some-segment/items");
+        compare("[0-9a-f]{24}",     "5f1d7c3b2a9e8f7d6c5b4a3b/items");
+        compare("[a-z0-9-]+",       "a-slug-123/items");
+        compare("\\d+",             "not-a-number/items");
+        compare("\\d+|[a-z]+",      "1234567/items");
+        long_miss("{a+b|c}");
+        long_miss("{*64:a+b|c}");
+    } };
+
+}
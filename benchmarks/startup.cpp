@@ -0,0 +1,87 @@
+#include "benchmark.h"
+
+#include <router/table.h>
+
+
+namespace {
+
+    /**
+     *  The callback used for all routes
+     */
+    std::size_t callback() { return 1; }
+
+    /**
+     *  The table type to build
+     */
+    using table_type = router::table<std::size_t()>;
+
+    /**
+     *  Compare adding routes one by one against adding them at once
+     *
+     *  @param  count       The number of routes to add
+     *  @param  expressions The number of distinct regular expressions to use, or zero for none
+     */
+    void compare(std::size_t count, std::size_t expressions = 0)
+    {
+        // generate the patterns, a mix of static routes and routes with
+        // slugs, spread over many tenants so the prefixes are not sorted
+        std::vector<std::string> patterns;
+
+        for (std::size_t i{ 0 }; i < count; ++i) {
+            // the tenant the route belongs to
+            auto tenant = std::to_string(i * 7919 % count);
+
+            // some of the routes need a regular expression
+            if (expressions > 0 && i % 3 == 0) {
+                patterns.push_back("/tenant/" + tenant + "/codes/{[a-z]{" + std::to_string(i / 3 % expressions + 1) + "}-\\d+}");
+                continue;
+            }
+
+            switch (i % 3) {
+                case 0:  patterns.push_back("/tenant/" + tenant + "/status");                       break;
+                case 1:  patterns.push_back("/tenant/" + tenant + "/users/{\\d+}");                break;
+                default: patterns.push_back("/tenant/" + tenant + "/items/{[0-9a-f]{24}}/{\\w+}"); break;
+            }
+        }
+
+        // the label for the route set
+        auto label = std::to_string(count) + " routes" + (expressions > 0 ? ", " + std::to_string(expressions) + " regexes" : "");
+
+        // the routes to add at once
+        std::vector<table_type::route_type> routes;
+
+        for (const auto& pattern : patterns) {
+            routes.push_back(table_type::make_route<&callback>(pattern));
+        }
+
+        bench::measure("add     " + label, [&]() {
+            table_type table;
+
+            for (const auto& pattern : patterns) {
+                table.add<&callback>(pattern);
+            }
+
+            bench::do_not_optimize(table);
+        });
+
+        bench::measure("add_all " + label, [&]() {
+            table_type table;
+            table.add_all(begin(routes), end(routes));
+            bench::do_not_optimize(table);
+        });
+
+        bench::measure("add_all " + label + ", 4 threads", [&]() {
+            table_type table;
+            table.add_all(begin(routes), end(routes), 4);
+            bench::do_not_optimize(table);
+        });
+    }
+
+    bench::group startup{ "startup", []() {
+        compare(1000);
+        compare(10000);
+        compare(100000);
+        compare(10000, 200);
+    } };
+
+}
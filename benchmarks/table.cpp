@@ -0,0 +1,105 @@
+#include "benchmark.h"
+
+#include <router/table.h>
+
+
+namespace {
+
+    /**
+     *  The callback used for all routes
+     */
+    std::size_t callback() { return 1; }
+
+    /**
+     *  Compare routing endpoints one by one against routing them in a batch
+     *
+     *  @param  label       The label to print for the benchmarks
+     *  @param  table       The table to route with
+     *  @param  endpoints   The endpoints to route
+     */
+    void compare(std::string_view label, const router::table<std::size_t()>& table, const std::vector<std::string>& endpoints)
+    {
+        // the matches for the batch
+        std::vector<router::table<std::size_t()>::match_type> matches(endpoints.size());
+
+        // both store the matches, like a caller keeping them for later
+        bench::measure("single  " + std::string{ label }, [&]() {
+            for (std::size_t i{ 0 }; i < endpoints.size(); ++i) {
+                matches[i] = table.match(endpoints[i]);
+            }
+
+            bench::do_not_optimize(matches.data());
+        });
+
+        bench::measure("batch   " + std::string{ label }, [&]() {
+            table.match_batch(begin(endpoints), end(endpoints), begin(matches));
+            bench::do_not_optimize(matches.data());
+        });
+    }
+
+    /**
+     *  Compare routing a small set of hot endpoints with and without a cache
+     *
+     *  @param  table       The table to route with
+     *  @param  endpoints   The endpoints to route
+     */
+    void cached(router::table<std::size_t()>& table, const std::vector<std::string>& endpoints)
+    {
+        bench::measure("uncached " + std::to_string(endpoints.size()) + " hot endpoints", [&]() {
+            for (const auto& endpoint : endpoints) {
+                auto match = table.match(endpoint);
+                bench::do_not_optimize(match);
+            }
+        });
+
+        // now route with the cache enabled
+        table.enable_cache(64);
+
+        bench::measure("cached   " + std::to_string(endpoints.size()) + " hot endpoints", [&]() {
+            for (const auto& endpoint : endpoints) {
+                auto match = table.match(endpoint);
+                bench::do_not_optimize(match);
+            }
+        });
+
+        table.enable_cache(0);
+    }
+
+    bench::group tables{ "table", []() {
+        // a table with a mix of static routes and routes with slugs
+        router::table<std::size_t()> table;
+
+        for (std::size_t i{ 0 }; i < 1000; ++i) {
+            table.add<&callback>("/static/" + std::to_string(i));
+            table.add<&callback>("/users/" + std::to_string(i) + "/{\\d+}");
+        }
+
+        // a batch of endpoints, interleaving both kinds of routes
+        std::vector<std::string> endpoints;
+
+        for (std::size_t i{ 0 }; i < 256; ++i) {
+            endpoints.push_back("/static/" + std::to_string(i * 7 % 1000));
+            endpoints.push_back("/users/" + std::to_string(i * 13 % 1000) + "/42");
+        }
+
+        compare("512 endpoints", table, endpoints);
+
+        // a few endpoints that receive most of the traffic
+        std::vector<std::string> hot;
+
+        for (std::size_t i{ 0 }; i < 20; ++i) {
+            hot.push_back("/users/" + std::to_string(i * 37) + "/" + std::to_string(i));
+        }
+
+        cached(table, hot);
+
+        // the same batch using the frozen layout
+        table.freeze();
+        compare("512 endpoints, frozen", table, endpoints);
+
+        // the same batch using the compiled automaton
+        table.compile();
+        compare("512 endpoints, compiled", table, endpoints);
+    } };
+
+}
@@ -2,3 +2,4 @@
 
 
 #include "router/table.h"
+#include "router/live_table.h"
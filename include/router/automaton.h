@@ -0,0 +1,493 @@
+#pragma once
+
+#include <unordered_map>
+#include <string_view>
+#include <algorithm>
+#include <optional>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <array>
+#include "path.h"
+
+
+namespace router {
+
+    /**
+     *  A deterministic automaton matching a set of paths at once
+     *
+     *  The paths are given in order of priority. Every path is turned
+     *  into a small deterministic program (literal characters and slug
+     *  scanners), and all programs are merged into a single automaton
+     *  using the subset construction. Matching then only walks over each
+     *  character of the input once, and reports the path with the highest
+     *  priority that matched.
+     *
+     *  Slugs are matched greedily, without backtracking, exactly like
+     *  path::match does. Only paths whose slugs all use a scanner can be
+     *  compiled, slugs requiring a regular expression cannot be merged.
+     */
+    class automaton
+    {
+        public:
+            /**
+             *  Value returned when no path matched
+             */
+            constexpr static std::size_t npos = static_cast<std::size_t>(-1);
+
+            /**
+             *  Try to build an automaton for a set of paths
+             *
+             *  @param  paths       The paths to compile, in order of priority
+             *  @param  max_states  The maximum number of states to create
+             *  @return The automaton, or nothing if the paths cannot be compiled
+             */
+            static std::optional<automaton> compile(const std::vector<const path*>& paths, std::size_t max_states)
+            {
+                // the automaton to build
+                automaton result{};
+
+                // the programs for all the paths
+                std::vector<program> programs;
+                programs.reserve(paths.size());
+
+                // create a program for every path
+                for (const auto* path : paths) {
+                    // can the path be compiled?
+                    if (auto compiled = program::create(*path); compiled) {
+                        programs.push_back(std::move(*compiled));
+                    } else {
+                        return std::nullopt;
+                    }
+                }
+
+                // determine which characters behave identically
+                result.partition(programs);
+
+                // build the states from the programs
+                if (!result.build(programs, max_states)) {
+                    return std::nullopt;
+                }
+
+                return result;
+            }
+
+            /**
+             *  Get the number of states in the automaton
+             *
+             *  @return The number of states, including the dead state
+             */
+            std::size_t size() const noexcept
+            {
+                return _accept.size();
+            }
+
+            /**
+             *  Match the automaton against the given input
+             *
+             *  @param  input   The input to match
+             *  @return The index of the matching path with the highest priority, or npos
+             */
+            std::size_t match(std::string_view input) const noexcept
+            {
+                // start in the initial state
+                std::uint32_t state{ _start };
+
+                // walk over every character in the input
+                for (char character : input) {
+                    // move to the next state
+                    state = _transitions[state * _classes + _class[static_cast<unsigned char>(character)]];
+
+                    // once dead, the automaton can never match anymore
+                    if (state == dead) {
+                        return npos;
+                    }
+                }
+
+                // the accepting path is stored with an offset of one
+                return static_cast<std::size_t>(_accept[state]) - 1;
+            }
+        private:
+            /**
+             *  The dead state, which never leads to a match
+             */
+            constexpr static std::uint32_t dead = 0;
+
+            /**
+             *  Alias for a set of characters
+             */
+            using character_set = std::array<std::uint64_t, 4>;
+
+            /**
+             *  The deterministic program for a single path
+             */
+            struct program
+            {
+                /**
+                 *  An element in the program, either a literal
+                 *  character or a repeated character class
+                 */
+                struct element
+                {
+                    const scanner*  matcher;    // the scanner for a slug, or nullptr for a literal
+                    char            literal;    // the literal character
+                    std::uint32_t   min;        // the minimum number of characters for a slug
+                    std::uint32_t   max;        // the maximum number of characters for a slug, or unbounded
+                };
+
+                /**
+                 *  A state inside the program, consisting of the element index and,
+                 *  for slugs, the number of characters matched so far
+                 */
+                using state = std::uint64_t;
+
+                /**
+                 *  The maximum repetition we are willing to unroll
+                 */
+                constexpr static std::size_t max_repetition = 256;
+
+                /**
+                 *  Value for a slug without maximum length
+                 */
+                constexpr static std::uint32_t unbounded = static_cast<std::uint32_t>(-1);
+
+                /**
+                 *  Create the program for a path
+                 *
+                 *  @param  path    The path to create the program for
+                 *  @return The program, or nothing if the path cannot be compiled
+                 */
+                static std::optional<program> create(const path& path)
+                {
+                    // the program to fill
+                    program result{};
+
+                    // add the literal characters from the prefix
+                    result.add(path.prefix());
+
+                    // add all the slugs and their suffixes
+                    for (const auto& [slug, suffix] : path.edges()) {
+                        // we need a scanner, we cannot compile a regex
+                        auto* matcher = slug.matcher();
+
+                        if (matcher == nullptr) {
+                            return std::nullopt;
+                        }
+
+                        // the slug may not look at more than the maximum length
+                        std::size_t max = std::min(matcher->max(), slug.max_length());
+
+                        // we cannot unroll large repetitions
+                        if (max != scanner::unbounded && max > max_repetition) {
+                            return std::nullopt;
+                        }
+
+                        // a slug that requires more than it may look at never matches
+                        if (matcher->min() > max || matcher->min() > max_repetition) {
+                            return std::nullopt;
+                        }
+
+                        result.elements.push_back(element{
+                            matcher, '\0',
+                            static_cast<std::uint32_t>(matcher->min()),
+                            max == scanner::unbounded ? unbounded : static_cast<std::uint32_t>(max)
+                        });
+
+                        result.add(suffix);
+                    }
+
+                    return result;
+                }
+
+                /**
+                 *  Add literal data to the program
+                 *
+                 *  @param  data    The literal data to add
+                 */
+                void add(std::string_view data)
+                {
+                    for (char character : data) {
+                        elements.push_back(element{ nullptr, character, 0, 0 });
+                    }
+                }
+
+                /**
+                 *  Create a state from its components
+                 *
+                 *  @param  index   The element index
+                 *  @param  count   The number of characters matched by a slug
+                 *  @return The combined state
+                 */
+                static state make(std::size_t index, std::size_t count) noexcept
+                {
+                    return (static_cast<state>(index) << 32) | count;
+                }
+
+                /**
+                 *  Process a character
+                 *
+                 *  @param  current     The current state
+                 *  @param  character   The character to process
+                 *  @return The next state, or nothing if the program fails
+                 */
+                std::optional<state> step(state current, unsigned char character) const noexcept
+                {
+                    // split up the state
+                    std::size_t index = current >> 32;
+                    std::size_t count = current & 0xffffffff;
+
+                    // keep going until an element consumes the character
+                    while (index < elements.size()) {
+                        // the element to process
+                        const auto& element = elements[index];
+
+                        // is it a literal character?
+                        if (element.matcher == nullptr) {
+                            if (static_cast<unsigned char>(element.literal) != character) {
+                                return std::nullopt;
+                            }
+
+                            return make(index + 1, 0);
+                        }
+
+                        // can the slug consume the character? note that for unbounded
+                        // repetitions we stop counting once the minimum is reached
+                        if (element.matcher->test(static_cast<char>(character)) && count < element.max) {
+                            return make(index, element.max == unbounded ? std::min<std::size_t>(count + 1, element.min) : count + 1);
+                        }
+
+                        // the slug is complete, did it match enough data?
+                        if (count < element.min) {
+                            return std::nullopt;
+                        }
+
+                        // the next element should process the character
+                        ++index;
+                        count = 0;
+                    }
+
+                    // there is trailing data after the path
+                    return std::nullopt;
+                }
+
+                /**
+                 *  Check whether the program accepts when the input ends
+                 *
+                 *  @param  current The current state
+                 *  @return Whether the input matched the path
+                 */
+                bool accepts(state current) const noexcept
+                {
+                    // split up the state
+                    std::size_t index = current >> 32;
+                    std::size_t count = current & 0xffffffff;
+
+                    // all remaining elements must match the empty string
+                    for (; index < elements.size(); ++index, count = 0) {
+                        if (elements[index].matcher == nullptr || count < elements[index].min) {
+                            return false;
+                        }
+                    }
+
+                    return true;
+                }
+
+                /**
+                 *  Invoke a callback for each set of characters used in the program
+                 *
+                 *  @param  callback    The callback to invoke with each set
+                 */
+                template <typename callable>
+                void sets(callable&& callback) const
+                {
+                    for (const auto& element : elements) {
+                        // the set to report
+                        character_set set{};
+
+                        // build the set for the element
+                        for (unsigned value{ 0 }; value < 256; ++value) {
+                            if (element.matcher == nullptr ? value == static_cast<unsigned char>(element.literal) : element.matcher->test(static_cast<char>(value))) {
+                                set[value / 64] |= std::uint64_t{ 1 } << (value % 64);
+                            }
+                        }
+
+                        callback(set);
+                    }
+                }
+
+                std::vector<element> elements;  // the elements to match
+            };
+
+            /**
+             *  A state in the automaton is the set of path
+             *  programs that are still alive, with their state
+             */
+            using state_set = std::vector<std::pair<std::uint32_t, program::state>>;
+
+            /**
+             *  Hash function for a state set
+             */
+            struct state_set_hash
+            {
+                std::size_t operator()(const state_set& set) const noexcept
+                {
+                    // fnv-1a over the contents of the set
+                    std::uint64_t hash{ 14695981039346656037ull };
+
+                    for (const auto& [index, state] : set) {
+                        hash = (hash ^ index) * 1099511628211ull;
+                        hash = (hash ^ state) * 1099511628211ull;
+                    }
+
+                    return static_cast<std::size_t>(hash);
+                }
+            };
+
+            /**
+             *  Split the characters into classes that
+             *  all programs treat identically
+             *
+             *  @param  programs    The programs to partition for
+             */
+            void partition(const std::vector<program>& programs)
+            {
+                // the sets we already refined with
+                std::vector<character_set> seen;
+
+                // all characters start out in the same class
+                _class.fill(0);
+                _classes = 1;
+
+                for (const auto& program : programs) {
+                    program.sets([this, &seen](const character_set& set) {
+                        // skip sets we already processed
+                        if (std::find(begin(seen), end(seen), set) != end(seen)) {
+                            return;
+                        }
+
+                        seen.push_back(set);
+
+                        // the new class for every combination of old class and membership
+                        std::vector<std::uint32_t> mapping(_classes * 2, 0);
+                        std::uint32_t              classes{ 0 };
+
+                        for (unsigned value{ 0 }; value < 256; ++value) {
+                            // determine the combination for the character
+                            bool    member  = (set[value / 64] >> (value % 64)) & 1;
+                            auto&   target  = mapping[_class[value] * 2 + member];
+
+                            // assign a new class when first encountered
+                            if (target == 0) {
+                                target = ++classes;
+                            }
+
+                            _class[value] = target - 1;
+                        }
+
+                        _classes = classes;
+                    });
+                }
+            }
+
+            /**
+             *  Build the states using the subset construction
+             *
+             *  @param  programs    The programs to combine
+             *  @param  max_states  The maximum number of states to create
+             *  @return Whether the automaton could be built within the limit
+             */
+            bool build(const std::vector<program>& programs, std::size_t max_states)
+            {
+                // a representative character for every class
+                std::vector<unsigned char> representatives(_classes);
+
+                for (unsigned value{ 256 }; value-- > 0;) {
+                    representatives[_class[value]] = static_cast<unsigned char>(value);
+                }
+
+                // the known states and the sets they represent
+                std::unordered_map<state_set, std::uint32_t, state_set_hash>    states;
+                std::vector<state_set>                                          sets;
+
+                // add a state, returning its index
+                auto add = [this, &programs, &states, &sets](state_set&& set) -> std::uint32_t {
+                    // an empty set is the dead state
+                    if (set.empty()) {
+                        return dead;
+                    }
+
+                    // reuse an existing state
+                    if (auto iter = states.find(set); iter != end(states)) {
+                        return iter->second;
+                    }
+
+                    // the new state accepts the first path in the set that
+                    // accepts, since paths are ordered by their priority
+                    std::uint32_t accept{ 0 };
+
+                    for (const auto& [index, state] : set) {
+                        if (programs[index].accepts(state)) {
+                            accept = index + 1;
+                            break;
+                        }
+                    }
+
+                    // register the new state
+                    std::uint32_t id = static_cast<std::uint32_t>(_accept.size());
+                    _accept.push_back(accept);
+                    states.emplace(set, id);
+                    sets.push_back(std::move(set));
+                    return id;
+                };
+
+                // create the dead state, which transitions to itself
+                _accept.push_back(0);
+                sets.emplace_back();
+
+                // the initial state has all programs at their start
+                state_set initial;
+                initial.reserve(programs.size());
+
+                for (std::size_t i{ 0 }; i < programs.size(); ++i) {
+                    initial.emplace_back(static_cast<std::uint32_t>(i), program::make(0, 0));
+                }
+
+                _start = add(std::move(initial));
+
+                // process states until no new states are found
+                for (std::size_t current{ 0 }; current < sets.size(); ++current) {
+                    // do we have too many states?
+                    if (sets.size() > max_states) {
+                        return false;
+                    }
+
+                    // add the transitions for every class
+                    for (std::size_t c{ 0 }; c < _classes; ++c) {
+                        // the next set of states
+                        state_set next;
+
+                        // step every program with the character, since each program
+                        // appears only once and in order, the result remains sorted
+                        for (const auto& [index, state] : sets[current]) {
+                            if (auto following = programs[index].step(state, representatives[c]); following) {
+                                next.emplace_back(index, *following);
+                            }
+                        }
+
+                        // the set may be moved, so we cannot hold a reference into sets
+                        std::uint32_t target = add(std::move(next));
+                        _transitions.push_back(target);
+                    }
+                }
+
+                return true;
+            }
+
+            std::uint32_t                   _start      {};     // the initial state
+            std::array<std::uint32_t, 256>  _class      {};     // the class for every character
+            std::size_t                     _classes    {};     // the number of character classes
+            std::vector<std::uint32_t>      _transitions{};     // the next state for every state and class
+            std::vector<std::uint32_t>      _accept     {};     // the accepted path for every state, plus one
+    };
+
+}
@@ -5,10 +5,84 @@
 #include <system_error>
 #include <type_traits>
 #include <charconv>
+#include <string>
+#include "impl/exceptions.h"
+#include "impl/from_chars.h"
+#include "slug_value.h"
 
 
 namespace router {
 
+    namespace impl {
+
+        /**
+         *  Convert slug data to a number
+         *
+         *  @param  input   The slug data
+         *  @param  output  The number to set
+         *  @return The result of the conversion
+         */
+        template <typename arithmetic>
+        std::from_chars_result convert_field(std::string_view input, arithmetic& output) noexcept
+        {
+            // integers are always decimal
+            if constexpr (std::is_integral_v<arithmetic>) {
+                return std::from_chars(input.data(), std::next(input.data(), input.size()), output, 10);
+            } else {
+                return floating_from_chars(input.data(), std::next(input.data(), input.size()), output);
+            }
+        }
+
+    }
+
+    /**
+     *  Parse a simple string field, without throwing
+     *
+     *  Types that can be parsed without throwing an exception provide an
+     *  overload of this function, which can be found through argument
+     *  dependent lookup. These are used when routing with try_route().
+     *
+     *  @param  input   The slug data
+     *  @param  output  The field to set
+     *  @return Whether the field could be set
+     */
+    inline bool parse_field(std::string_view input, std::string& output)
+    {
+        // the string can hold any data
+        output.assign(input);
+        return true;
+    }
+
+    /**
+     *  Parse a simple string field, without throwing
+     *
+     *  @param  input   The slug data
+     *  @param  output  The field to set
+     *  @return Whether the field could be set
+     */
+    inline bool parse_field(std::string_view input, std::string_view& output) noexcept
+    {
+        output = input;
+        return true;
+    }
+
+    /**
+     *  Parse a field containing numerical data, without throwing
+     *
+     *  @param  input   The slug data
+     *  @param  output  The field to set
+     *  @return Whether all of the data is a number that fits the field
+     */
+    template <typename arithmetic>
+    std::enable_if_t<std::is_arithmetic_v<arithmetic>, bool>
+    parse_field(std::string_view input, arithmetic& output) noexcept
+    {
+        // convert the data, all of which must be used
+        auto result = impl::convert_field(input, output);
+
+        return result.ec == std::errc{} && result.ptr == std::next(input.data(), input.size());
+    }
+
     /**
      *  Process a simple string field
      *
@@ -39,20 +113,20 @@ namespace router {
      *  @param  input   The slug data
      *  @param  output  The field to set
      */
-    template <typename integral>
-    std::enable_if_t<std::is_arithmetic_v<integral>>
-    process_field(std::string_view input, integral& output)
+    template <typename arithmetic>
+    std::enable_if_t<std::is_arithmetic_v<arithmetic>>
+    process_field(std::string_view input, arithmetic& output)
     {
         // first parse the input data
-        auto result = std::from_chars(input.data(), std::next(input.data(), input.size()), output, 10);
+        auto result = impl::convert_field(input, output);
 
         // check whether we successfully parsed the data and whether all of it was parsed
         if (result.ec != std::errc{}) {
             // some of the data was invalid and could not be converted
-            throw std::range_error{ std::make_error_code(result.ec).message() };
+            impl::fail<std::range_error>(std::make_error_code(result.ec).message());
         } else if (result.ptr != std::next(input.data(), input.size())) {
             // part of the data contained numeric input, but not all of it
-            throw std::range_error{ "Input data contains non-numerical data" };
+            impl::fail<std::range_error>("Input data contains non-numerical data");
         }
     }
 
@@ -77,4 +151,205 @@ namespace router {
         >
     >> : std::true_type {};
 
+    /**
+     *  Type trait to check whether a field can be parsed without throwing
+     *
+     *  Default for when no valid match is made
+     */
+    template <typename T, typename = void>
+    struct is_parsable_field : std::false_type {};
+
+    /**
+     *  Match for a field with a parse_field() overload
+     */
+    template <typename T>
+    struct is_parsable_field<T, std::void_t<
+        std::enable_if_t<
+            std::is_same_v<
+                bool,
+                decltype(parse_field(std::string_view{}, std::declval<T&>()))
+            >
+        >
+    >> : std::true_type {};
+
+    namespace impl {
+
+        /**
+         *  Set a field without throwing, using parse_field() when available,
+         *  otherwise process_field() is used and any exception is caught
+         *
+         *  @param  input   The slug data
+         *  @param  output  The field to set
+         *  @return Whether the field could be set
+         */
+        template <typename T>
+        bool try_field(std::string_view input, T& output)
+        {
+            if constexpr (is_parsable_field<T>::value) {
+                return parse_field(input, output);
+            } else {
+                #if defined(ROUTER_EXCEPTIONS)
+                    try {
+                        process_field(input, output);
+                        return true;
+                    } catch (...) {
+                        return false;
+                    }
+                #else
+                    // without exceptions, process_field() cannot report errors
+                    process_field(input, output);
+                    return true;
+                #endif
+            }
+        }
+
+    }
+
+    /**
+     *  A field that takes the slug data with its percent-escapes decoded
+     *
+     *  Other fields are given the slug data as it appears in the endpoint.
+     *  When a table converts the slugs for a callback, the slugs for fields
+     *  of this type are decoded first, so that %20 becomes a space. Slugs
+     *  without escapes are not copied, the others are decoded into a buffer
+     *  that lives as long as the callback runs.
+     *
+     *  @tparam field_type  The type of the field, like std::string_view or int
+     */
+    template <typename field_type>
+    struct decoded
+    {
+        field_type value{}; // the field, set from the decoded data
+
+        /**
+         *  Access the field
+         *
+         *  @return The field
+         */
+        field_type& operator*() noexcept                { return value;     }
+        const field_type& operator*() const noexcept    { return value;     }
+        field_type* operator->() noexcept               { return &value;    }
+        const field_type* operator->() const noexcept   { return &value;    }
+    };
+
+    /**
+     *  Process a field taking decoded data
+     *
+     *  @param  input   The decoded slug data
+     *  @param  output  The field to set
+     */
+    template <typename field_type>
+    auto process_field(std::string_view input, decoded<field_type>& output) -> decltype(process_field(input, output.value))
+    {
+        process_field(input, output.value);
+    }
+
+    /**
+     *  Parse a field taking decoded data, without throwing
+     *
+     *  @param  input   The decoded slug data
+     *  @param  output  The field to set
+     *  @return Whether the field could be set
+     */
+    template <typename field_type>
+    auto parse_field(std::string_view input, decoded<field_type>& output) -> decltype(process_field(input, output.value), bool{})
+    {
+        return impl::try_field(input, output.value);
+    }
+
+    namespace impl {
+
+        /**
+         *  Slug data, with the value it was converted to while matching
+         */
+        struct typed_slug
+        {
+            std::string_view    data;       // the slug data, as it appears in the endpoint
+            std::string_view    unescaped;  // the slug data with its escapes decoded, if needed
+            slug_value          value;      // the value of typed slugs
+        };
+
+        /**
+         *  Process the field for a slug
+         *
+         *  @param  input   The slug data
+         *  @param  output  The field to set
+         */
+        template <typename input_type, typename T>
+        void process_slug(const input_type& input, T& output)
+        {
+            process_field(input, output);
+        }
+
+        /**
+         *  Process the field for a slug, using the value it was converted
+         *  to while matching if it fits the field, and the data otherwise
+         *
+         *  @param  input   The slug data and value
+         *  @param  output  The field to set
+         */
+        template <typename T>
+        void process_slug(const typed_slug& input, T& output)
+        {
+            if (!input.value.get(output)) {
+                process_field(input.data, output);
+            }
+        }
+
+        /**
+         *  Process the field for a slug that takes decoded data
+         *
+         *  @param  input   The slug data and value
+         *  @param  output  The field to set
+         */
+        template <typename T>
+        void process_slug(const typed_slug& input, decoded<T>& output)
+        {
+            if (!input.value.get(output.value)) {
+                process_field(input.unescaped, output.value);
+            }
+        }
+
+        /**
+         *  Set the field for a slug, without throwing
+         *
+         *  @param  input   The slug data
+         *  @param  output  The field to set
+         *  @return Whether the field could be set
+         */
+        template <typename input_type, typename T>
+        bool try_slug(const input_type& input, T& output)
+        {
+            return try_field(input, output);
+        }
+
+        /**
+         *  Set the field for a slug without throwing, using the value it was
+         *  converted to while matching if it fits the field
+         *
+         *  @param  input   The slug data and value
+         *  @param  output  The field to set
+         *  @return Whether the field could be set
+         */
+        template <typename T>
+        bool try_slug(const typed_slug& input, T& output)
+        {
+            return input.value.get(output) || try_field(input.data, output);
+        }
+
+        /**
+         *  Set the field for a slug that takes decoded data, without throwing
+         *
+         *  @param  input   The slug data and value
+         *  @param  output  The field to set
+         *  @return Whether the field could be set
+         */
+        template <typename T>
+        bool try_slug(const typed_slug& input, decoded<T>& output)
+        {
+            return input.value.get(output.value) || try_field(input.unescaped, output.value);
+        }
+
+    }
+
 }
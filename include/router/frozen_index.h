@@ -0,0 +1,336 @@
+#pragma once
+
+#include <string_view>
+#include <type_traits>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <string>
+#include <vector>
+#include "statistics.h"
+#include "scanner.h"
+#include "path.h"
+
+
+namespace router {
+
+    /**
+     *  A compact, read-only copy of the paths and the prefix tree of a map
+     *
+     *  A path owns its prefix, and a vector of slugs and suffixes, which all
+     *  live in separate allocations, as do the labels and child lists in the
+     *  prefix tree. Looking up an endpoint then jumps between many small
+     *  blocks of memory.
+     *
+     *  The frozen index stores all literal data in a single buffer, and all
+     *  other data in a handful of arrays, using indices instead of pointers.
+     *  The data needed to walk the tree and reject a path is kept in separate
+     *  arrays, so that it is packed closely together. Slugs that need a regular
+     *  expression are not copied at all: they are taken from the paths the
+     *  index was created from, which are only touched when such a slug is
+     *  actually matched. The paths are therefore passed to every lookup.
+     */
+    class frozen_index
+    {
+        public:
+            /**
+             *  Value returned when no path matches
+             */
+            constexpr static std::size_t npos = static_cast<std::size_t>(-1);
+
+            /**
+             *  Add a path to the index, paths must be added in the
+             *  order of their index in the map they were taken from
+             *
+             *  @param  path    The path to add
+             */
+            void add_path(const path& path)
+            {
+                // store the prefix and where the edges start
+                _prefix_offset.push_back(literal(path.prefix()));
+                _prefix_length.push_back(static_cast<std::uint32_t>(path.prefix().size()));
+                _edge_begin.push_back(static_cast<std::uint32_t>(_suffix_offset.size()));
+                _edge_count.push_back(static_cast<std::uint32_t>(path.edges().size()));
+
+                // store the data for every edge
+                for (const auto& [slug, suffix] : path.edges()) {
+                    // store the suffix and the length limit
+                    _suffix_offset.push_back(literal(suffix));
+                    _suffix_length.push_back(static_cast<std::uint32_t>(suffix.size()));
+                    _max_length.push_back(static_cast<std::uint32_t>(std::min<std::size_t>(slug.max_length(), unbounded)));
+
+                    // do we have a scanner, or do we need the slug from the path?
+                    if (auto* matcher = slug.matcher(); matcher != nullptr) {
+                        _matcher.push_back(static_cast<std::uint32_t>(_scanners.size()));
+                        _scanners.push_back(*matcher);
+                    } else {
+                        _matcher.push_back(expression_flag);
+                    }
+                }
+            }
+
+            /**
+             *  Add a node of the prefix tree to the index, nodes must be added
+             *  in the order of their index, starting with the root
+             *
+             *  @param  label       The literal data on the edge leading to the node
+             *  @param  children    The first character and index of every child, sorted on the character
+             *  @param  entries     The paths to try at the node, in order of priority
+             */
+            template <typename child_range, typename entry_range>
+            void add_node(std::string_view label, const child_range& children, const entry_range& entries)
+            {
+                // store the label and where the children and paths start
+                _label_offset.push_back(literal(label));
+                _label_length.push_back(static_cast<std::uint32_t>(label.size()));
+                _child_begin.push_back(static_cast<std::uint32_t>(_child_node.size()));
+                _entry_begin.push_back(static_cast<std::uint32_t>(_entries.size()));
+
+                // add all the children
+                for (const auto& [character, index] : children) {
+                    _child_character.push_back(character);
+                    _child_node.push_back(static_cast<std::uint32_t>(index));
+                }
+
+                // and all the paths
+                for (auto index : entries) {
+                    _entries.push_back(static_cast<std::uint32_t>(index));
+                }
+
+                // store where the children and paths end
+                _child_end.push_back(static_cast<std::uint32_t>(_child_node.size()));
+                _entry_end.push_back(static_cast<std::uint32_t>(_entries.size()));
+            }
+
+            /**
+             *  Find the path matching an endpoint
+             *
+             *  This tries the same paths in the same order as the map the
+             *  index was created from, walking down the tree and trying the
+             *  paths at every node, and trying the paths at the root last.
+             *
+             *  @param  endpoint    The endpoint to find
+             *  @param  slugs       The slugs to fill if found
+             *  @param  paths       Callable giving the path the index was created from, by its index
+             *  @return The index of the matching path, or npos
+             */
+            template <typename slug_container, typename path_lookup>
+            std::size_t find(std::string_view endpoint, slug_container& slugs, const path_lookup& paths) const
+            {
+                return find(endpoint, slugs, paths, [](std::size_t, const slug_container&) noexcept { return true; });
+            }
+
+            /**
+             *  Find the path matching an endpoint, which must also be accepted
+             *
+             *  @param  endpoint    The endpoint to find
+             *  @param  slugs       The slugs to fill if found
+             *  @param  paths       Callable giving the path the index was created from, by its index
+             *  @param  accept      Callable invoked with the index and slugs of every matching path
+             *  @return The index of the matching and accepted path, or npos
+             */
+            template <typename slug_container, typename path_lookup, typename acceptor>
+            std::size_t find(std::string_view endpoint, slug_container& slugs, const path_lookup& paths, acceptor&& accept) const
+            {
+                // start at the root, which is only tried at the end
+                std::size_t         node        { 0         };
+                std::string_view    remaining   { endpoint  };
+
+                // walk down the tree as far as the endpoint allows
+                while (!remaining.empty()) {
+                    // find the child that continues with the next character
+                    auto first  = _child_character.begin() + _child_begin[node];
+                    auto last   = _child_character.begin() + _child_end[node];
+                    auto iter   = std::lower_bound(first, last, remaining.front());
+
+                    // stop if there is no such child
+                    if (iter == last || *iter != remaining.front()) {
+                        break;
+                    }
+
+                    // move to the child and check its label
+                    node = _child_node[iter - _child_character.begin()];
+                    auto label = literal(_label_offset[node], _label_length[node]);
+
+                    // stop if the edge does not match
+                    if (remaining.substr(0, label.size()) != label) {
+                        break;
+                    }
+
+                    // consume the edge data
+                    remaining.remove_prefix(label.size());
+
+                    // try all paths with a prefix ending here
+                    if (auto index = find_at(node, endpoint, slugs, paths, accept); index != npos) {
+                        return index;
+                    }
+                }
+
+                // none of the prefixed paths matched, so try
+                // the paths without a known prefix
+                return find_at(0, endpoint, slugs, paths, accept);
+            }
+
+            /**
+             *  Check whether a path matches the given input
+             *
+             *  @param  index       The index of the path
+             *  @param  original    The path the index was created from, for the slugs with a regular expression
+             *  @param  input       The input to test
+             *  @param  output      The matched slug data
+             *  @return Whether the input matches the path
+             */
+            template <typename slug_container>
+            bool match(std::size_t index, const path& original, std::string_view input, slug_container& output) const
+            {
+                // clean the output
+                output.clear();
+
+                // the input must start with the prefix
+                auto prefix = literal(_prefix_offset[index], _prefix_length[index]);
+
+                if (input.substr(0, prefix.size()) != prefix) {
+                    return false;
+                }
+
+                // remove the prefix from the input
+                input.remove_prefix(prefix.size());
+
+                // go over all the edges
+                for (std::size_t edge{ _edge_begin[index] }, last{ edge + _edge_count[index] }; edge < last; ++edge) {
+                    // the matched slug data, and its value
+                    std::string_view    matched_data;
+                    slug_value          value;
+
+                    // does the slug use a regular expression?
+                    if ((_matcher[edge] & expression_flag) != 0) {
+                        // the slug of the path takes care of the length limit
+                        if (!original.edges()[edge - _edge_begin[index]].first.match(input, matched_data, value)) {
+                            return false;
+                        }
+                    } else {
+                        // we never look beyond the maximum length
+                        std::string_view bounded{ _max_length[edge] == unbounded ? input : input.substr(0, _max_length[edge]) };
+
+                        if (!_scanners[_matcher[edge]].match(bounded, matched_data)) {
+                            return false;
+                        }
+
+                        // consume the matched input
+                        input.remove_prefix(matched_data.size());
+                    }
+
+                    // the input must continue with the suffix
+                    auto suffix = literal(_suffix_offset[edge], _suffix_length[edge]);
+
+                    if (input.substr(0, suffix.size()) != suffix) {
+                        return false;
+                    }
+
+                    // remove the suffix from the input and store the matched data
+                    input.remove_prefix(suffix.size());
+
+                    // a slug list keeps the value too
+                    if constexpr (std::is_same_v<slug_container, slug_list>) {
+                        output.push_back(matched_data, value);
+                    } else {
+                        output.push_back(matched_data);
+                    }
+                }
+
+                // all input must be consumed
+                return input.empty();
+            }
+        private:
+            /**
+             *  Value for a slug without a maximum length
+             */
+            constexpr static std::uint32_t unbounded = static_cast<std::uint32_t>(-1);
+
+            /**
+             *  Flag marking an edge whose slug is taken from the path, because it uses a regular expression
+             */
+            constexpr static std::uint32_t expression_flag = std::uint32_t{ 1 } << 31;
+
+            /**
+             *  Store literal data in the buffer
+             *
+             *  @param  data    The data to store
+             *  @return The offset of the data in the buffer
+             */
+            std::uint32_t literal(std::string_view data)
+            {
+                // the data is stored at the end
+                auto offset = static_cast<std::uint32_t>(_literals.size());
+                _literals.append(data);
+
+                return offset;
+            }
+
+            /**
+             *  Retrieve literal data from the buffer
+             *
+             *  @param  offset  The offset of the data
+             *  @param  length  The size of the data
+             *  @return The literal data
+             */
+            std::string_view literal(std::uint32_t offset, std::uint32_t length) const noexcept
+            {
+                return { _literals.data() + offset, length };
+            }
+
+            /**
+             *  Try the paths at a node
+             *
+             *  @param  node        The node to try the paths for
+             *  @param  endpoint    The endpoint to match
+             *  @param  slugs       The slugs to fill if found
+             *  @param  paths       Callable giving the path the index was created from, by its index
+             *  @param  accept      Callable deciding whether a matching path is used
+             *  @return The index of the matching path, or npos
+             */
+            template <typename slug_container, typename path_lookup, typename acceptor>
+            std::size_t find_at(std::size_t node, std::string_view endpoint, slug_container& slugs, const path_lookup& paths, acceptor& accept) const
+            {
+                // the paths are stored in order of priority
+                for (std::size_t i{ _entry_begin[node] }; i < _entry_end[node]; ++i) {
+                    #if defined(ROUTER_INSTRUMENTATION)
+                        // count the path being tried
+                        statistics::examine(_entries[i]);
+                    #endif
+
+                    if (match(_entries[i], paths(_entries[i]), endpoint, slugs) && accept(static_cast<std::size_t>(_entries[i]), slugs)) {
+                        return _entries[i];
+                    }
+                }
+
+                return npos;
+            }
+
+            std::string                 _literals;          // all literal data: prefixes, suffixes and labels
+
+            std::vector<std::uint32_t>  _label_offset;      // the offset of the label for every node
+            std::vector<std::uint32_t>  _label_length;      // the size of the label for every node
+            std::vector<std::uint32_t>  _child_begin;       // the first child of every node
+            std::vector<std::uint32_t>  _child_end;         // the end of the children of every node
+            std::vector<std::uint32_t>  _entry_begin;       // the first path to try for every node
+            std::vector<std::uint32_t>  _entry_end;         // the end of the paths to try for every node
+            std::vector<char>           _child_character;   // the first character of the label for every child
+            std::vector<std::uint32_t>  _child_node;        // the node index for every child
+            std::vector<std::uint32_t>  _entries;           // the paths to try at the nodes
+
+            std::vector<std::uint32_t>  _prefix_offset;     // the offset of the prefix for every path
+            std::vector<std::uint32_t>  _prefix_length;     // the size of the prefix for every path
+            std::vector<std::uint32_t>  _edge_begin;        // the first edge for every path
+            std::vector<std::uint32_t>  _edge_count;        // the number of edges for every path
+
+            std::vector<std::uint32_t>  _suffix_offset;     // the offset of the suffix for every edge
+            std::vector<std::uint32_t>  _suffix_length;     // the size of the suffix for every edge
+            std::vector<std::uint32_t>  _max_length;        // the maximum slug length for every edge
+            std::vector<std::uint32_t>  _matcher;           // the scanner for every edge, or the expression flag
+
+            std::vector<scanner>        _scanners;          // the scanners for the simple slugs
+    };
+
+}
@@ -0,0 +1,312 @@
+#pragma once
+
+#include <string_view>
+#include <iterator>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include "../slug_list.h"
+#include "../fields.h"
+
+
+namespace router::impl {
+
+    /**
+     *  Get the value of a hexadecimal digit
+     *
+     *  @param  digit   The digit to convert
+     *  @return The value of the digit, or -1 if it is not a hexadecimal digit
+     */
+    constexpr int hex_value(char digit) noexcept
+    {
+        if (digit >= '0' && digit <= '9') {
+            return digit - '0';
+        } else if (digit >= 'a' && digit <= 'f') {
+            return digit - 'a' + 10;
+        } else if (digit >= 'A' && digit <= 'F') {
+            return digit - 'A' + 10;
+        }
+
+        return -1;
+    }
+
+    /**
+     *  Decode the percent-escapes in slug data
+     *
+     *  A percent sign that is not followed by two hexadecimal
+     *  digits is not an escape, and is copied as it is.
+     *
+     *  @param  input   The data to decode
+     *  @param  output  The buffer to write to, room for at least the size of the input
+     *  @return The number of characters written
+     */
+    inline std::size_t percent_decode(std::string_view input, char* output) noexcept
+    {
+        // the number of characters written
+        std::size_t size{ 0 };
+
+        for (std::size_t i{ 0 }; i < input.size(); ++i) {
+            // the value of the escaped character, if this is an escape
+            auto high   = input[i] == '%' && i + 2 < input.size() ? hex_value(input[i + 1]) : -1;
+            auto low    = high < 0 ? -1 : hex_value(input[i + 2]);
+
+            // copy everything that is not an escape
+            if (low < 0) {
+                output[size++] = input[i];
+                continue;
+            }
+
+            // write the escaped character, and skip the digits
+            output[size++] = static_cast<char>(high * 16 + low);
+            i += 2;
+        }
+
+        return size;
+    }
+
+    /**
+     *  Scratch buffer for slugs decoded while converting them for a request
+     *
+     *  The decoded slugs are stored inline when they fit, so decoding
+     *  does not allocate. The views on decoded slugs remain valid until
+     *  the buffer is reserved again, or destroyed.
+     */
+    class decode_buffer
+    {
+        public:
+            /**
+             *  The number of characters stored inline
+             */
+            constexpr static std::size_t capacity = 256;
+
+            /**
+             *  Constructor
+             */
+            decode_buffer() = default;
+
+            /**
+             *  The buffer cannot be copied or moved, since the
+             *  decoded slugs refer to the data inside of it
+             */
+            decode_buffer(const decode_buffer& that) = delete;
+            decode_buffer& operator=(const decode_buffer& that) = delete;
+
+            /**
+             *  Discard the decoded slugs and make room for new ones
+             *
+             *  @param  size    The number of characters to make room for
+             */
+            void reserve(std::size_t size)
+            {
+                // slugs that do not fit go on the heap
+                if (size <= capacity) {
+                    _data = _buffer;
+                } else {
+                    _heap.reset(new char[size]);
+                    _data = _heap.get();
+                }
+            }
+
+            /**
+             *  Decode slug data into the buffer, at the given offset, which
+             *  must leave room for all the data that is decoded
+             *
+             *  @param  input   The slug data to decode
+             *  @param  offset  The position in the buffer to decode to
+             *  @return The decoded slug data
+             */
+            std::string_view decode(std::string_view input, std::size_t offset) noexcept
+            {
+                return { _data + offset, percent_decode(input, _data + offset) };
+            }
+        private:
+            char                    _buffer[capacity];      // the inline storage
+            std::unique_ptr<char[]> _heap{};                // storage for slugs that do not fit
+            char*                   _data{ _buffer };       // the storage in use
+    };
+
+    /**
+     *  A view on a slug list, giving the slugs with their
+     *  percent-escapes decoded
+     *
+     *  Slugs without escapes are given as they appear in the endpoint,
+     *  only the slugs containing a percent sign are decoded, into the given
+     *  buffer. These are only looked for when the view is created with a
+     *  buffer, which is only done for callbacks with fields that take the
+     *  decoded data, so other callbacks never pay for it. Every slug comes
+     *  with the value it was converted to while matching, if it is typed.
+     */
+    class decoded_slugs
+    {
+        public:
+            /**
+             *  Iterator over the decoded slugs
+             */
+            class iterator
+            {
+                public:
+                    using iterator_category = std::input_iterator_tag;
+                    using value_type        = typed_slug;
+                    using difference_type   = std::ptrdiff_t;
+                    using pointer           = void;
+                    using reference         = typed_slug;
+
+                    /**
+                     *  Constructor
+                     *
+                     *  @param  view    The view to iterate over
+                     *  @param  index   The index of the slug to start at
+                     */
+                    iterator(const decoded_slugs* view, std::size_t index) noexcept :
+                        _view{ view },
+                        _index{ index }
+                    {}
+
+                    /**
+                     *  Retrieve the current slug, every slug is decoded
+                     *  to its own place in the buffer, so retrieving it
+                     *  again gives the same data
+                     *
+                     *  @return The slug data, with its value
+                     */
+                    typed_slug operator*() const noexcept
+                    {
+                        // the slug as it appears in the endpoint
+                        auto slug = _view->_slugs[_index];
+
+                        // only slugs with escapes are decoded
+                        return { slug, _view->escaped(_index) ? _view->decode(_index) : slug, _view->_slugs.value(_index) };
+                    }
+
+                    /**
+                     *  Move to the next slug
+                     *
+                     *  @return Same object for chaining
+                     */
+                    iterator& operator++() noexcept
+                    {
+                        ++_index;
+                        return *this;
+                    }
+
+                    /**
+                     *  Move to the next slug
+                     *
+                     *  @return The iterator before moving
+                     */
+                    iterator operator++(int) noexcept
+                    {
+                        auto result = *this;
+                        ++_index;
+                        return result;
+                    }
+
+                    /**
+                     *  Compare iterators
+                     *
+                     *  @param  other   The iterator to compare with
+                     *  @return Whether the iterators point to the same slug
+                     */
+                    bool operator==(const iterator& other) const noexcept { return _index == other._index; }
+                    bool operator!=(const iterator& other) const noexcept { return _index != other._index; }
+                private:
+                    const decoded_slugs*    _view;  // the view we iterate over
+                    std::size_t             _index; // the current index into the list
+            };
+
+            /**
+             *  Constructor
+             *
+             *  @param  slugs   The slugs to decode
+             *  @param  buffer  The buffer to decode the slugs into, or a nullptr to not decode them
+             */
+            decoded_slugs(const slug_list& slugs, decode_buffer* buffer) :
+                _slugs{ slugs },
+                _buffer{ buffer }
+            {
+                // without a buffer, nothing is decoded
+                if (_buffer == nullptr) {
+                    return;
+                }
+
+                // the decoded slugs are never larger than the escaped ones
+                std::size_t size{ 0 };
+
+                // find the slugs that need decoding
+                for (std::size_t i{ 0 }; i < slugs.size(); ++i) {
+                    if (slugs[i].find('%') != std::string_view::npos) {
+                        _escaped    |= std::uint32_t{ 1 } << i;
+                        size        += slugs[i].size();
+                    }
+                }
+
+                // without escapes, nothing is decoded
+                if (_escaped != 0) {
+                    _buffer->reserve(size);
+                }
+            }
+
+            /**
+             *  Get the number of slugs
+             *
+             *  @return The number of slugs
+             */
+            std::size_t size() const noexcept
+            {
+                return _slugs.size();
+            }
+
+            /**
+             *  Get iterators to the slugs
+             *
+             *  @return The iterator to the first slug, or past the last slug
+             */
+            iterator begin() const noexcept { return { this, 0              }; }
+            iterator end()   const noexcept { return { this, _slugs.size()  }; }
+        private:
+            /**
+             *  Check whether a slug contains percent-escapes
+             *
+             *  @param  index   The index of the slug
+             *  @return Whether the slug needs decoding
+             */
+            bool escaped(std::size_t index) const noexcept
+            {
+                return (_escaped >> index) & 1;
+            }
+
+            /**
+             *  Decode a slug containing escapes
+             *
+             *  @param  index   The index of the slug
+             *  @return The decoded slug data
+             */
+            std::string_view decode(std::size_t index) const noexcept
+            {
+                // the slugs before it that are decoded come first in the buffer
+                std::size_t offset{ 0 };
+
+                for (std::size_t i{ 0 }; i < index; ++i) {
+                    if (escaped(i)) {
+                        offset += _slugs[i].size();
+                    }
+                }
+
+                return _buffer->decode(_slugs[index], offset);
+            }
+
+            const slug_list&    _slugs;         // the slugs to decode
+            decode_buffer*      _buffer;        // the buffer to decode into, if slugs are decoded
+            std::uint32_t       _escaped{ 0 };  // a bit for every slug containing escapes
+    };
+
+    /**
+     *  Get iterators to the decoded slugs
+     *
+     *  @param  view    The view to iterate over
+     *  @return The iterator to the first slug, or past the last slug
+     */
+    inline decoded_slugs::iterator begin(const decoded_slugs& view) noexcept { return view.begin(); }
+    inline decoded_slugs::iterator end(const decoded_slugs& view)   noexcept { return view.end();   }
+
+}
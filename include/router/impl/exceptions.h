@@ -0,0 +1,35 @@
+#pragma once
+
+#include <utility>
+#include <cstdlib>
+
+
+/**
+ *  Whether exceptions are enabled, when they are not, errors that would
+ *  otherwise throw an exception terminate the program instead
+ */
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+    #define ROUTER_EXCEPTIONS 1
+#endif
+
+
+namespace router::impl {
+
+    /**
+     *  Report an error by throwing an exception, or by
+     *  terminating the program if exceptions are disabled
+     *
+     *  @tparam exception   The type of exception to throw
+     *  @param  parameters  The arguments to construct the exception with
+     */
+    template <typename exception, typename... arguments>
+    [[noreturn]] void fail([[maybe_unused]] arguments&&... parameters)
+    {
+        #if defined(ROUTER_EXCEPTIONS)
+            throw exception{ std::forward<arguments>(parameters)... };
+        #else
+            std::abort();
+        #endif
+    }
+
+}
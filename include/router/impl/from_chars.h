@@ -0,0 +1,84 @@
+#pragma once
+
+#include <type_traits>
+#include <cstddef>
+#include <system_error>
+#include <charconv>
+#include <cstdlib>
+#include <algorithm>
+#include <cerrno>
+
+
+/**
+ *  Whether the standard library can convert floating point numbers with
+ *  std::from_chars(), which some do not, like libc++ before version 17
+ */
+#if defined(__cpp_lib_to_chars)
+    #define ROUTER_FLOATING_FROM_CHARS 1
+#endif
+
+
+namespace router::impl {
+
+    /**
+     *  Convert characters to a floating point number
+     *
+     *  This works like the floating point std::from_chars(). When that is
+     *  not available, the number is copied to a buffer ending with a null
+     *  character, and converted with the strtod() family instead. Longer
+     *  numbers than fit the buffer are then reported to be out of range.
+     *
+     *  @param  first   The first character to convert
+     *  @param  last    Past the last character to convert
+     *  @param  output  The number to set
+     *  @return The result of the conversion
+     */
+    template <typename floating>
+    std::from_chars_result floating_from_chars(const char* first, const char* last, floating& output) noexcept
+    {
+        #if defined(ROUTER_FLOATING_FROM_CHARS)
+            return std::from_chars(first, last, output);
+        #else
+            // the size of the buffer for the copy
+            constexpr std::ptrdiff_t capacity{ 64 };
+
+            // std::from_chars() allows no whitespace or plus sign before the number
+            if (first == last || *first == '+' || *first == ' ' || (*first >= '\t' && *first <= '\r')) {
+                return { first, std::errc::invalid_argument };
+            } else if (last - first >= capacity) {
+                return { first, std::errc::result_out_of_range };
+            }
+
+            // copy the number, so that it ends with a null character
+            char buffer[capacity];
+            std::copy(first, last, buffer);
+            buffer[last - first] = '\0';
+
+            // the end of the converted characters
+            char* end{ buffer };
+            errno = 0;
+
+            // convert it with the function for the type
+            floating value;
+
+            if constexpr (std::is_same_v<floating, float>) {
+                value = std::strtof(buffer, &end);
+            } else if constexpr (std::is_same_v<floating, double>) {
+                value = std::strtod(buffer, &end);
+            } else {
+                value = std::strtold(buffer, &end);
+            }
+
+            // nothing could be converted
+            if (end == buffer) {
+                return { first, std::errc::invalid_argument };
+            } else if (errno == ERANGE) {
+                return { first + (end - buffer), std::errc::result_out_of_range };
+            }
+
+            output = value;
+            return { first + (end - buffer), std::errc{} };
+        #endif
+    }
+
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include "../variadic_lookup.h"
+#include "../method_set.h"
+
+
+namespace router::impl {
+
+    /**
+     *  The methods a table with proxies routes without a handler of their
+     *  own: methods routed to the handler of another method, and the method
+     *  answered from the allowed methods
+     *
+     *  This is shared by the table and the matches it returns, so that a
+     *  match gives the same allowed methods as the handlers receive.
+     */
+    template <auto first, decltype(first)... rest>
+    class method_routing
+    {
+        public:
+            /**
+             *  Alias for a set of methods
+             */
+            using method_set_type = method_set<first, rest...>;
+
+            /**
+             *  Route a method to the handler of another method
+             *
+             *  @param  index   The index of the method to route elsewhere
+             *  @param  target  The method whose handler to use
+             */
+            void set_fallback(std::size_t index, decltype(first) target) noexcept
+            {
+                _fallbacks |= std::uint64_t{ 1 } << index;
+                _fallback[index] = target;
+            }
+
+            /**
+             *  Set the method answered from the allowed methods
+             *
+             *  @param  index   The index of the method
+             */
+            void set_options(std::size_t index) noexcept
+            {
+                _options = index;
+            }
+
+            /**
+             *  Check whether a method is routed to the handler of another method
+             *
+             *  @param  index   The index of the method
+             *  @return Whether the method has a fallback
+             */
+            bool has_fallback(std::size_t index) const noexcept
+            {
+                return index != lookup::npos && ((_fallbacks >> index) & 1) != 0;
+            }
+
+            /**
+             *  Get the method whose handler is used for a method with a fallback
+             *
+             *  @param  index   The index of the method
+             *  @return The target method
+             */
+            decltype(first) fallback(std::size_t index) const noexcept
+            {
+                return _fallback[index];
+            }
+
+            /**
+             *  Check whether a method is answered from the allowed methods
+             *
+             *  @param  index   The index of the method
+             *  @return Whether this is the options method
+             */
+            bool options(std::size_t index) const noexcept
+            {
+                return index != lookup::npos && index == _options;
+            }
+
+            /**
+             *  Get the methods that can be routed for a proxy
+             *
+             *  @param  proxy   The proxy matched for an endpoint
+             *  @return The methods with a handler, a fallback, or answered by the options handler
+             */
+            template <typename proxy_type>
+            method_set_type allowed(const proxy_type& proxy) const noexcept
+            {
+                // the methods with a handler
+                std::uint64_t bits{ proxy.allowed().bits() };
+
+                // methods with a fallback are allowed when their target is
+                for (std::size_t index{ 0 }; index < method_set_type::capacity; ++index) {
+                    if (has_fallback(index) && proxy.get(_fallback[index]).valid()) {
+                        bits |= std::uint64_t{ 1 } << index;
+                    }
+                }
+
+                // the options method is always allowed
+                if (_options != lookup::npos) {
+                    bits |= std::uint64_t{ 1 } << _options;
+                }
+
+                return method_set_type::from_bits(bits);
+            }
+        private:
+            /**
+             *  The lookup for the method indices
+             */
+            using lookup = variadic_index<first, rest...>;
+
+            std::uint64_t                                           _fallbacks{};               // the methods with a fallback
+            std::array<decltype(first), method_set_type::capacity>  _fallback{};                // the fallback for every method
+            std::size_t                                             _options{ lookup::npos };   // the index of the options method
+    };
+
+}
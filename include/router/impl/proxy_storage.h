@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <array>
+
+
+namespace router::impl {
+
+    /**
+     *  Undefined templated class for specializing
+     *  into the dense and sparse storage
+     */
+    template <class callback_type, std::size_t count, bool sparse>
+    class proxy_storage;
+
+    /**
+     *  Storage for the callbacks of a proxy, holding a callback for every
+     *  method, together with a bitmask of the methods that are set
+     */
+    template <class callback_type, std::size_t count>
+    class proxy_storage<callback_type, count, false>
+    {
+        public:
+            static_assert(count <= 64, "A proxy supports at most 64 methods");
+
+            /**
+             *  Retrieve the callback for a method
+             *
+             *  @param  index   The index of the method
+             *  @return The callback, which may be invalid
+             */
+            const callback_type* find(std::size_t index) const noexcept
+            {
+                return &_callbacks[index];
+            }
+
+            /**
+             *  Set the callback for a number of methods
+             *
+             *  @param  methods     A bit for every method to set the callback for
+             *  @param  callback    The callback to set
+             */
+            void assign(std::uint64_t methods, const callback_type& callback) noexcept
+            {
+                // store the callback for every method
+                for (std::size_t index{ 0 }; index < count; ++index) {
+                    if (((methods >> index) & 1) != 0) {
+                        _callbacks[index] = callback;
+                    }
+                }
+
+                // and remember they are set
+                _mask |= methods;
+            }
+
+            /**
+             *  Get the methods that have a callback
+             *
+             *  @return A bit for every method with a callback
+             */
+            std::uint64_t mask() const noexcept
+            {
+                return _mask;
+            }
+        private:
+            std::array<callback_type, count>    _callbacks{};   // the callback for every method
+            std::uint64_t                       _mask{};        // the methods with a callback
+    };
+
+    /**
+     *  Storage for the callbacks of a proxy, holding every distinct callback
+     *  only once, together with the position of the callback for every method
+     *
+     *  Routes often use the same callback for multiple methods, like GET and
+     *  HEAD, which is then stored only once. Methods without a callback take
+     *  no more than a byte.
+     */
+    template <class callback_type, std::size_t count>
+    class proxy_storage<callback_type, count, true>
+    {
+        public:
+            static_assert(count <= 64, "A proxy supports at most 64 methods");
+
+            /**
+             *  Retrieve the callback for a method
+             *
+             *  @param  index   The index of the method
+             *  @return The callback, or a nullptr if not set
+             */
+            const callback_type* find(std::size_t index) const noexcept
+            {
+                // the position of the callback
+                auto position = _positions[index];
+
+                return position == empty ? nullptr : &_callbacks[position];
+            }
+
+            /**
+             *  Set the callback for a number of methods
+             *
+             *  @param  methods     A bit for every method to set the callback for
+             *  @param  callback    The callback to set
+             */
+            void assign(std::uint64_t methods, const callback_type& callback)
+            {
+                // find the callback, if we have it already
+                auto position = static_cast<std::size_t>(std::find(_callbacks.begin(), _callbacks.end(), callback) - _callbacks.begin());
+
+                // store the callback if we do not
+                if (position == _callbacks.size()) {
+                    _callbacks.push_back(callback);
+                }
+
+                // point all the methods to the callback
+                for (std::size_t index{ 0 }; index < count; ++index) {
+                    if (((methods >> index) & 1) != 0) {
+                        _positions[index] = static_cast<std::uint8_t>(position);
+                    }
+                }
+
+                // the methods may have used other callbacks before
+                compact();
+            }
+
+            /**
+             *  Get the methods that have a callback
+             *
+             *  @return A bit for every method with a callback
+             */
+            std::uint64_t mask() const noexcept
+            {
+                // the methods found so far
+                std::uint64_t result{ 0 };
+
+                for (std::size_t index{ 0 }; index < count; ++index) {
+                    if (_positions[index] != empty) {
+                        result |= std::uint64_t{ 1 } << index;
+                    }
+                }
+
+                return result;
+            }
+        private:
+            /**
+             *  Marker for a method without a callback
+             */
+            constexpr static std::uint8_t empty = 255;
+
+            /**
+             *  Create the positions for a proxy without callbacks
+             *
+             *  @return The positions, all marked empty
+             */
+            constexpr static std::array<std::uint8_t, count> no_positions() noexcept
+            {
+                // the positions to fill
+                std::array<std::uint8_t, count> result{};
+
+                for (auto& position : result) {
+                    position = empty;
+                }
+
+                return result;
+            }
+
+            /**
+             *  Remove the callbacks no method uses anymore
+             */
+            void compact()
+            {
+                // check the callbacks, starting at the end so the
+                // positions before the one we remove stay valid
+                for (std::size_t position{ _callbacks.size() }; position-- > 0;) {
+                    // is the callback still used?
+                    if (std::find(_positions.begin(), _positions.end(), position) != _positions.end()) {
+                        continue;
+                    }
+
+                    // remove the callback and move the ones after it
+                    _callbacks.erase(_callbacks.begin() + position);
+
+                    for (auto& current : _positions) {
+                        if (current != empty && current > position) {
+                            --current;
+                        }
+                    }
+                }
+            }
+
+            std::array<std::uint8_t, count> _positions{ no_positions() };   // the position of the callback for every method
+            std::vector<callback_type>      _callbacks;                     // the distinct callbacks
+    };
+
+}
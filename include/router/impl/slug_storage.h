@@ -0,0 +1,135 @@
+#pragma once
+
+#include <type_traits>
+#include <cstddef>
+#include <new>
+#include "decoded_slugs.h"
+
+
+namespace router::impl {
+
+    /**
+     *  Storage for the slug data converted for a callback
+     *
+     *  The type of the converted data depends on the callback, so it is
+     *  erased here. Small types are stored inline, so converting the slugs
+     *  while matching does not allocate, larger types go on the heap. The
+     *  storage also holds the buffer the slugs with escapes are decoded in.
+     */
+    class slug_storage
+    {
+        public:
+            /**
+             *  The number of bytes stored inline
+             */
+            constexpr static std::size_t capacity = 128;
+
+            /**
+             *  Constructor
+             */
+            slug_storage() = default;
+
+            /**
+             *  The storage cannot be copied or moved, since only
+             *  the callback knows the type of the stored data
+             */
+            slug_storage(const slug_storage& that) = delete;
+            slug_storage& operator=(const slug_storage& that) = delete;
+
+            /**
+             *  Destructor
+             */
+            ~slug_storage()
+            {
+                reset();
+            }
+
+            /**
+             *  Replace the stored data with a default-constructed value
+             *
+             *  @tparam T   The type of data to store
+             *  @return The stored value
+             */
+            template <typename T>
+            T& emplace()
+            {
+                // destroy the data for the previous callback
+                reset();
+
+                // store the data inline if it fits
+                if constexpr (fits<T>) {
+                    _pointer = new (_buffer) T{};
+                } else {
+                    _pointer = new T{};
+                }
+
+                _destroy = &destroy<T>;
+                return *static_cast<T*>(_pointer);
+            }
+
+            /**
+             *  Retrieve the stored data
+             *
+             *  @tparam T   The type of data that was stored
+             *  @return The stored value
+             */
+            template <typename T>
+            T& get() noexcept
+            {
+                return *static_cast<T*>(_pointer);
+            }
+
+            /**
+             *  Retrieve the buffer to decode slugs in
+             *
+             *  @return The buffer for the decoded slugs
+             */
+            decode_buffer& buffer() noexcept
+            {
+                return _decoded;
+            }
+
+            /**
+             *  Destroy the stored data, if any
+             */
+            void reset() noexcept
+            {
+                if (_destroy != nullptr) {
+                    _destroy(_pointer);
+                    _destroy = nullptr;
+                }
+            }
+        private:
+            /**
+             *  Whether a type is stored inline
+             */
+            template <typename T>
+            constexpr static bool fits = sizeof(T) <= capacity && alignof(T) <= alignof(std::max_align_t);
+
+            /**
+             *  Destroy stored data of the given type
+             *
+             *  @param  pointer The stored data
+             */
+            template <typename T>
+            static void destroy(void* pointer) noexcept
+            {
+                if constexpr (fits<T>) {
+                    static_cast<T*>(pointer)->~T();
+                } else {
+                    delete static_cast<T*>(pointer);
+                }
+            }
+
+            /**
+             *  Alias for the function destroying the stored data
+             */
+            using destructor = void(*)(void* pointer) noexcept;
+
+            alignas(std::max_align_t) unsigned char _buffer[capacity];  // the inline storage
+            void*                                   _pointer{};         // the stored data
+            destructor                              _destroy{};         // destroys the stored data, empty when nothing is stored
+            decode_buffer                           _decoded;           // the slugs decoded for the stored data
+    };
+
+}
@@ -1,31 +1,86 @@
 #pragma once
 
-#include <vector>
 #include <utility>
 #include <stdexcept>
+#include <tuple>
 #include "../fields.h"
+#include "../query.h"
+#include "exceptions.h"
 
 
 namespace router::impl {
 
     /**
-     *  Read a vector of slugs and parse them
+     *  Read a list of slugs and parse them
      *  into the given tuple
      */
-    template <typename... types, std::size_t... I>
-    void to_dto(const std::vector<std::string_view>& slugs, std::tuple<types...>& output, std::index_sequence<I...>)
+    template <typename slug_container, typename... types, std::size_t... I>
+    void to_dto(const slug_container& slugs, std::tuple<types...>& output, std::index_sequence<I...>)
     {
         // ensure the number of slugs is correct
         if (slugs.size() != sizeof...(types)) {
             // we cannot parse the data
-            throw std::logic_error{ "Cannot convert slugs to dto: slug count mismatch" };
+            fail<std::logic_error>("Cannot convert slugs to dto: slug count mismatch");
         }
 
         // iterator to use in the fold expression
         auto iter = begin(slugs);
 
         // fold the fields into the output object
-        (process_field(*iter++, std::get<I>(output)), ...);
+        (process_slug(*iter++, std::get<I>(output)), ...);
     }
 
+    /**
+     *  Read a list of slugs and parse them
+     *  into the given tuple, without throwing
+     */
+    template <typename slug_container, typename... types, std::size_t... I>
+    bool try_to_dto(const slug_container& slugs, std::tuple<types...>& output, std::index_sequence<I...>)
+    {
+        // iterator to use in the fold expression
+        auto iter = begin(slugs);
+
+        // the number of slugs must be correct, and all fields must convert
+        return slugs.size() == sizeof...(types) && (try_slug(*iter++, std::get<I>(output)) && ...);
+    }
+
+    /**
+     *  The binding between a query parameter and a struct member
+     *
+     *  @tparam member  The member to fill
+     *  @tparam name    The name of the query parameter
+     */
+    template <auto member, const char* name>
+    struct query_field
+    {
+        /**
+         *  Parse the parameter into the member, if it is given
+         *
+         *  @param  parameters  The query to find the parameter in
+         *  @param  output      The object to fill
+         */
+        template <typename data_type>
+        static void process(query parameters, data_type& output)
+        {
+            if (auto value = parameters.find(name); value.has_value()) {
+                process_field(*value, output.*member);
+            }
+        }
+
+        /**
+         *  Parse the parameter into the member, if it is given, without throwing
+         *
+         *  @param  parameters  The query to find the parameter in
+         *  @param  output      The object to fill
+         *  @return Whether the parameter is missing or could be converted
+         */
+        template <typename data_type>
+        static bool parse(query parameters, data_type& output)
+        {
+            auto value = parameters.find(name);
+
+            return !value.has_value() || try_field(*value, output.*member);
+        }
+    };
+
 }
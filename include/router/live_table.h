@@ -0,0 +1,246 @@
+#pragma once
+
+#include <string_view>
+#include <cstddef>
+#include <utility>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <array>
+#include "table.h"
+
+
+namespace router {
+
+    /**
+     *  A routing table that can be replaced while requests are routed
+     *
+     *  A regular table may not be modified while other threads route requests
+     *  with it. A live table instead holds an immutable snapshot of a table.
+     *  A new table is built separately and then published, after which new
+     *  requests are routed with the new table. Requests that were already
+     *  being routed finish on the old snapshot, which is destroyed as soon as
+     *  the last of these requests is done.
+     *
+     *  Readers never wait for each other or for a writer. Every reader thread
+     *  announces itself in one of a fixed number of slots, each on its own
+     *  cache line, so readers on different threads do not share any data that
+     *  is written. Publishing a new table waits until all readers that may
+     *  still use the old snapshot are done, using two alternating counters
+     *  per slot, so that readers that keep arriving cannot delay it forever.
+     */
+    template <class T>
+    class live_table
+    {
+        public:
+            /**
+             *  The table we hold snapshots of
+             */
+            using table_type = table<T>;
+
+            /**
+             *  Constructor
+             *
+             *  @param  initial The table to start with
+             */
+            explicit live_table(table_type initial = {}) :
+                _current{ new table_type{ std::move(initial) } }
+            {}
+
+            /**
+             *  The live table cannot be copied or moved, since
+             *  readers refer to it while routing requests
+             */
+            live_table(const live_table& that) = delete;
+            live_table& operator=(const live_table& that) = delete;
+
+            /**
+             *  Destructor
+             *
+             *  No other thread may use the table anymore.
+             */
+            ~live_table()
+            {
+                delete _current.load();
+            }
+
+            /**
+             *  Replace the table
+             *
+             *  This waits until no request is routed with the old table
+             *  anymore, and then destroys it. Multiple threads may publish
+             *  at the same time, the tables are then published one by one.
+             *  This may not be called while routing a request on the same
+             *  thread, since that request would never finish.
+             *
+             *  @param  next    The table to route new requests with
+             */
+            void publish(table_type next)
+            {
+                // only a single snapshot is replaced at a time
+                std::lock_guard lock{ _mutex };
+
+                // new readers only see the new snapshot from now on
+                std::unique_ptr<table_type> previous{ _current.exchange(new table_type{ std::move(next) }) };
+
+                // a reader may have read the counter index before an earlier
+                // publish and only registered itself afterwards, so we first
+                // wait for those readers, before flipping the index and waiting
+                // for the readers that registered with the current index
+                auto index = _index.load();
+
+                drain(index ^ 1);
+                _index.store(index ^ 1);
+                drain(index);
+
+                // nobody uses the previous snapshot anymore, so it is destroyed when we leave
+            }
+
+            /**
+             *  Invoke a function with the current table
+             *
+             *  The table passed to the function remains valid until the
+             *  function returns, even if another table is published in
+             *  the meantime. The function may not publish a table.
+             *
+             *  @param  callback    The function to invoke with the table
+             *  @return The result of the function
+             */
+            template <typename callable>
+            decltype(auto) read(callable&& callback) const
+            {
+                // register ourselves as a reader
+                section guard{ *this };
+
+                // and invoke the callback with the current snapshot
+                return std::forward<callable>(callback)(*_current.load());
+            }
+
+            /**
+             *  Check whether a given endpoint can be routed
+             *
+             *  @param  endpoint    The endpoint to check
+             *  @return Whether the endpoint can be routed
+             */
+            bool routable(std::string_view endpoint) const noexcept
+            {
+                return read([endpoint](const table_type& table) {
+                    return table.routable(endpoint);
+                });
+            }
+
+            /**
+             *  Route a request with the current table
+             *
+             *  @param  parameters  The endpoint and other arguments for table::route()
+             *  @return The result of the callback
+             *  @throws std::out_of_range If no matching route and no not_found handler is available
+             */
+            template <typename... arguments>
+            decltype(auto) route(arguments&&... parameters) const
+            {
+                return read([&parameters...](const table_type& table) -> decltype(auto) {
+                    return table.route(std::forward<arguments>(parameters)...);
+                });
+            }
+
+            /**
+             *  Route a request with the current table, without throwing
+             *
+             *  @param  parameters  The endpoint and other arguments for table::try_route()
+             *  @return The result of the callback, or the reason it was not invoked
+             */
+            template <typename... arguments>
+            auto try_route(arguments&&... parameters) const
+            {
+                return read([&parameters...](const table_type& table) {
+                    return table.try_route(std::forward<arguments>(parameters)...);
+                });
+            }
+        private:
+            /**
+             *  The number of slots readers announce themselves in
+             */
+            constexpr static std::size_t slot_count = 64;
+
+            /**
+             *  A slot holding the number of active readers for both counter indices
+             */
+            struct alignas(64) slot
+            {
+                std::array<std::atomic<std::size_t>, 2> readers{};  // the number of readers for each index
+            };
+
+            /**
+             *  Helper class registering a reader for its lifetime
+             */
+            class section
+            {
+                public:
+                    /**
+                     *  Constructor
+                     *
+                     *  @param  owner   The live table that is read
+                     */
+                    section(const live_table& owner) noexcept :
+                        _slot{ owner._slots[slot_index()] },
+                        _index{ owner._index.load() }
+                    {
+                        // announce ourselves, the writer checks this before
+                        // destroying any snapshot we could load after this
+                        _slot.readers[_index].fetch_add(1);
+                    }
+
+                    /**
+                     *  Destructor
+                     */
+                    ~section()
+                    {
+                        // we no longer use the snapshot
+                        _slot.readers[_index].fetch_sub(1, std::memory_order_release);
+                    }
+                private:
+                    slot&       _slot;  // the slot we are registered in
+                    std::size_t _index; // the counter index we registered with
+            };
+
+            /**
+             *  Get the slot index for the current thread
+             *
+             *  @return The index of the slot to use
+             */
+            static std::size_t slot_index() noexcept
+            {
+                // the index to give to the next thread
+                static std::atomic<std::size_t> next{ 0 };
+
+                // every thread gets the next slot, wrapping around
+                // when there are more threads than slots
+                thread_local std::size_t index{ next.fetch_add(1, std::memory_order_relaxed) % slot_count };
+
+                return index;
+            }
+
+            /**
+             *  Wait until no reader is registered with the given index
+             *
+             *  @param  index   The counter index to wait for
+             */
+            void drain(std::size_t index) const noexcept
+            {
+                // check all the slots one by one
+                for (const auto& current : _slots) {
+                    while (current.readers[index].load() != 0) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+
+            std::atomic<table_type*>                _current;   // the current snapshot
+            mutable std::array<slot, slot_count>    _slots;     // the slots for the readers
+            std::atomic<std::size_t>                _index{};   // the counter index for new readers
+            std::mutex                              _mutex;     // the lock for publishing snapshots
+    };
+
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <unordered_map>
+#include <string_view>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <mutex>
+#include <regex>
+
+
+namespace router {
+
+    /**
+     *  A registry of compiled slug expressions
+     *
+     *  Routing tables tend to repeat the same few slug patterns many times,
+     *  like \d+ or a uuid. Compiling a regular expression is expensive, and
+     *  every compiled expression holds its own copy of the state machine.
+     *  The registry interns the compiled expressions by their pattern text,
+     *  so that all slugs with the same pattern share a single, immutable
+     *  expression.
+     *
+     *  Every table has its own registry, but a registry can be shared by
+     *  multiple tables, which may be built on different threads at the same
+     *  time. The registry does not keep the expressions alive by itself, an
+     *  expression is destroyed when the last slug using it is gone. The
+     *  patterns of expressions that are gone are removed from the registry
+     *  whenever it has doubled in size, so a long-lived registry does not
+     *  keep growing when tables are replaced.
+     */
+    class matcher_registry
+    {
+        public:
+            /**
+             *  Get the compiled expression for a pattern
+             *
+             *  @param  pattern The pattern to compile
+             *  @return The shared compiled expression
+             *  @throws std::regex_error If the pattern is not a valid regular expression
+             */
+            std::shared_ptr<const std::regex> expression(std::string_view pattern)
+            {
+                // the key to store the expression under
+                std::string key{ pattern };
+
+                // check whether we already have the expression
+                if (auto result = lookup(key); result != nullptr) {
+                    return result;
+                }
+
+                // compile the expression without holding the lock, so that
+                // multiple threads can compile different expressions at once,
+                // an invalid pattern throws here and is never registered
+                auto result = std::make_shared<const std::regex>(begin(pattern), end(pattern));
+
+                // the registry may be shared between threads
+                std::lock_guard lock{ _mutex };
+
+                // another thread may have compiled the same expression
+                // in the meantime, in which case we use that one instead
+                auto& stored = _expressions[std::move(key)];
+
+                if (auto existing = stored.lock(); existing != nullptr) {
+                    ++_reused;
+                    return existing;
+                }
+
+                // store the new expression
+                stored = result;
+
+                // remove the expressions that are gone, once enough were added
+                if (_expressions.size() >= _prune_size) {
+                    prune();
+                }
+
+                return result;
+            }
+
+            /**
+             *  Get the number of unique expressions that are in use
+             *
+             *  @return The number of compiled expressions still alive
+             */
+            std::size_t size() const
+            {
+                // the registry may be shared between threads
+                std::lock_guard lock{ _mutex };
+
+                // the expression count
+                std::size_t result{ 0 };
+
+                // only count the expressions still in use
+                for (const auto& [pattern, stored] : _expressions) {
+                    if (!stored.expired()) {
+                        ++result;
+                    }
+                }
+
+                return result;
+            }
+
+            /**
+             *  Get the number of patterns stored, including those of
+             *  expressions that are gone but were not yet removed
+             *
+             *  @return The number of stored patterns
+             */
+            std::size_t entries() const
+            {
+                std::lock_guard lock{ _mutex };
+                return _expressions.size();
+            }
+
+            /**
+             *  Get the number of expressions that were requested
+             *
+             *  @return The number of calls to expression()
+             */
+            std::size_t requests() const
+            {
+                std::lock_guard lock{ _mutex };
+                return _requests;
+            }
+
+            /**
+             *  Get the number of requests answered with an existing expression
+             *
+             *  @return The number of expressions that did not need to be compiled
+             */
+            std::size_t reused() const
+            {
+                std::lock_guard lock{ _mutex };
+                return _reused;
+            }
+        private:
+            /**
+             *  The number of patterns stored before expressions that are gone are removed
+             */
+            constexpr static std::size_t min_prune_size = 64;
+
+            /**
+             *  Remove the patterns of expressions that are gone, the lock must be held
+             */
+            void prune()
+            {
+                for (auto iter = _expressions.begin(); iter != _expressions.end(); ) {
+                    iter = iter->second.expired() ? _expressions.erase(iter) : std::next(iter);
+                }
+
+                // prune again when the expressions in use have doubled
+                _prune_size = std::max(min_prune_size, 2 * _expressions.size());
+            }
+
+            /**
+             *  Find an expression that is still alive
+             *
+             *  @param  key The pattern of the expression
+             *  @return The expression, or a nullptr
+             */
+            std::shared_ptr<const std::regex> lookup(const std::string& key)
+            {
+                // the registry may be shared between threads
+                std::lock_guard lock{ _mutex };
+
+                // count the request
+                ++_requests;
+
+                // find the expression for the pattern
+                auto iter = _expressions.find(key);
+
+                if (iter == _expressions.end()) {
+                    return nullptr;
+                }
+
+                // the expression may no longer be in use
+                auto result = iter->second.lock();
+
+                if (result != nullptr) {
+                    ++_reused;
+                }
+
+                return result;
+            }
+
+            std::unordered_map<std::string, std::weak_ptr<const std::regex>>   _expressions;                  // the expressions by their pattern
+            std::size_t                                                        _requests{};                   // the number of expressions requested
+            std::size_t                                                        _reused{};                     // the number of requests for an existing expression
+            std::size_t                                                        _prune_size{ min_prune_size }; // the number of patterns at which the expired ones are removed
+            mutable std::mutex                                                 _mutex;                        // the lock protecting the registry
+    };
+
+}
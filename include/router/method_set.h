@@ -0,0 +1,180 @@
+#pragma once
+
+#include "variadic_lookup.h"
+#include <initializer_list>
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+
+namespace router {
+
+    /**
+     *  A set of methods a proxy can forward to
+     *
+     *  The set is stored as a bitmask, with a bit for every method in the
+     *  order the methods are given. This is passed to the handler for
+     *  methods that are not proxied, so it can tell which methods are
+     *  allowed, for example to fill an Allow header.
+     */
+    template <auto first, decltype(first)... rest>
+    class method_set
+    {
+        public:
+            /**
+             *  The type of the methods in the set
+             */
+            using method_type = decltype(first);
+
+            /**
+             *  The number of methods that can be in the set
+             */
+            constexpr static std::size_t capacity = 1 + sizeof...(rest);
+
+            static_assert(capacity <= 64, "A method set holds at most 64 methods");
+
+            /**
+             *  Constructor
+             *
+             *  @param  bits    The bitmask, with a bit for every method in the order they are given
+             */
+            constexpr explicit method_set(std::uint64_t bits = 0) noexcept :
+                _bits{ bits }
+            {}
+
+            /**
+             *  Constructor
+             *
+             *  @param  methods The methods in the set
+             */
+            constexpr method_set(std::initializer_list<method_type> methods) noexcept :
+                _bits{ 0 }
+            {
+                for (auto method : methods) {
+                    insert(method);
+                }
+            }
+
+            /**
+             *  Create a set from a bitmask
+             *
+             *  Use this instead of brace-initializing the set with a bitmask,
+             *  which picks the constructor taking a list of methods when the
+             *  methods are integers.
+             *
+             *  @param  bits    The bitmask, with a bit for every method in the order they are given
+             *  @return The set with the methods
+             */
+            constexpr static method_set from_bits(std::uint64_t bits) noexcept
+            {
+                return method_set(bits);
+            }
+
+            /**
+             *  Check whether a method is in the set
+             *
+             *  @param  method  The method to check
+             *  @return Whether the method is in the set
+             */
+            constexpr bool contains(method_type method) const noexcept
+            {
+                // the index of the method, an unknown method is never in the set
+                auto index = lookup::find(method);
+
+                return index != lookup::npos && (_bits >> index) & 1;
+            }
+
+            /**
+             *  Add a method to the set
+             *
+             *  @param  method  The method to add, an unknown method is ignored
+             *  @return Same object for chaining
+             */
+            constexpr method_set& insert(method_type method) noexcept
+            {
+                // the index of the method
+                if (auto index = lookup::find(method); index != lookup::npos) {
+                    _bits |= std::uint64_t{ 1 } << index;
+                }
+
+                return *this;
+            }
+
+            /**
+             *  Check whether the set is empty
+             *
+             *  @return Whether no method is in the set
+             */
+            constexpr bool empty() const noexcept
+            {
+                return _bits == 0;
+            }
+
+            /**
+             *  Get the number of methods in the set
+             *
+             *  @return The number of methods
+             */
+            constexpr std::size_t size() const noexcept
+            {
+                // the methods we still have to count
+                std::uint64_t   remaining   { _bits };
+                std::size_t     result      { 0     };
+
+                // remove the lowest bit until none are left
+                for (; remaining != 0; remaining &= remaining - 1) {
+                    ++result;
+                }
+
+                return result;
+            }
+
+            /**
+             *  Invoke a callback for every method in the set, in the
+             *  order the methods were given to the proxy
+             *
+             *  @param  callback    The callback to invoke with every method
+             */
+            template <typename callable>
+            constexpr void for_each(callable&& callback) const
+            {
+                for (std::size_t index{ 0 }; index < capacity; ++index) {
+                    if ((_bits >> index) & 1) {
+                        callback(methods[index]);
+                    }
+                }
+            }
+
+            /**
+             *  Get the bitmask for the set
+             *
+             *  @return A bit for every method in the order they are given
+             */
+            constexpr std::uint64_t bits() const noexcept
+            {
+                return _bits;
+            }
+
+            /**
+             *  Compare with another set
+             *
+             *  @param  that    The set to compare with
+             *  @return Whether the sets hold the same methods
+             */
+            constexpr bool operator==(const method_set& that) const noexcept { return _bits == that._bits; }
+            constexpr bool operator!=(const method_set& that) const noexcept { return _bits != that._bits; }
+        private:
+            /**
+             *  The lookup for the method indices
+             */
+            using lookup = variadic_index<first, rest...>;
+
+            /**
+             *  All the methods, in order
+             */
+            constexpr static std::array<method_type, capacity> methods{ first, rest... };
+
+            std::uint64_t _bits; // a bit for every method in the set
+    };
+
+}
@@ -1,8 +1,12 @@
 #pragma once
 
 #include <string_view>
+#include <type_traits>
 #include <algorithm>
 #include <vector>
+#include "pattern_error.h"
+#include "slug_list.h"
+#include "trace.h"
 #include "slug.h"
 
 
@@ -15,13 +19,24 @@ namespace router {
     class path
     {
         public:
+            /**
+             *  An edge consists of a slug and a
+             *  literal trailing suffix
+             */
+            using edge = std::pair<slug, std::string>;
+
             /**
              *  Constructor
              *
-             *  @param  path    The path to route
+             *  @param  path        The path to route
+             *  @param  registry    The registry to share slug expressions with, if any
+             *  @throws pattern_error If a slug in the path is invalid
              */
-            path(std::string_view path)
+            path(std::string_view path, matcher_registry* registry = nullptr)
             {
+                // the full pattern, for reporting errors
+                std::string_view pattern{ path };
+
                 // find the first slug inside the given path
                 std::size_t position = slug::find_start(path);
 
@@ -39,8 +54,8 @@ namespace router {
                 // process all slugs given in the path
                 while (!path.empty()) {
                     // parse the slug at the front of the path
-                    slug                slug    { path  };
-                    std::string_view    suffix  {       };
+                    slug                slug    { parse(pattern, path, registry)    };
+                    std::string_view    suffix  {                                   };
 
                     // find the start of the next slug (if any)
                     position = slug::find_start(path);
@@ -60,6 +75,30 @@ namespace router {
                 }
             }
 
+            /**
+             *  Find the regular expressions the slugs in a path need, without compiling them
+             *
+             *  @param  path    The path to search
+             *  @param  output  The vector to add the expressions to
+             */
+            static void regular_expressions(std::string_view path, std::vector<std::string_view>& output)
+            {
+                // process every slug given in the path
+                for (auto position = slug::find_start(path); position != std::string_view::npos; position = slug::find_start(path)) {
+                    // the slug starts at the position we found
+                    path.remove_prefix(position);
+
+                    // an invalid slug is reported when the path is created
+                    auto remaining = path.size();
+
+                    if (auto expression = slug::regular_expression(path); expression) {
+                        output.push_back(*expression);
+                    } else if (remaining == path.size()) {
+                        return;
+                    }
+                }
+            }
+
             /**
              *  Get the fixed prefix for this path
              *
@@ -70,6 +109,16 @@ namespace router {
                 return _prefix;
             }
 
+            /**
+             *  Get the slugs and their suffixes
+             *
+             *  @return The edges following the prefix
+             */
+            const std::vector<edge>& edges() const noexcept
+            {
+                return _edges;
+            }
+
             /**
              *  Check whether the prefix matches the given input
              *
@@ -86,14 +135,14 @@ namespace router {
              *  Check whether the path matches the given input
              *
              *  @param  input   The input to test
-             *  @param  output  The matched slug data
+             *  @param  output  The matched slug data, a slug_list or a vector of string views
              *  @return Whether the input matches the path
              */
-            bool match(std::string_view input, std::vector<std::string_view>& output) const
+            template <typename slug_container>
+            bool match(std::string_view input, slug_container& output) const
             {
-                // clean the output and allocate memory
+                // clean the output
                 output.clear();
-                output.reserve(_edges.size());
 
                 // first we check whether the input correctly begins with the prefix
                 if (!match_prefix(input)) {
@@ -106,11 +155,12 @@ namespace router {
 
                 // go over all the edges
                 for (const auto& [slug, suffix] : _edges) {
-                    // the matched slug data
-                    std::string_view matched_data;
+                    // the matched slug data, and its value
+                    std::string_view    matched_data;
+                    slug_value          value;
 
                     // check the slug
-                    if (!slug.match(input, matched_data)) {
+                    if (!slug.match(input, matched_data, value)) {
                         // the slug failed to match
                         return false;
                     }
@@ -124,7 +174,13 @@ namespace router {
 
                     // remove the suffix from the input and store the matched data
                     input.remove_prefix(suffix.size());
-                    output.push_back(matched_data);
+
+                    // a slug list keeps the value too
+                    if constexpr (std::is_same_v<slug_container, slug_list>) {
+                        output.push_back(matched_data, value);
+                    } else {
+                        output.push_back(matched_data);
+                    }
                 }
 
                 // prefix and all sludges matched, this should have
@@ -132,12 +188,95 @@ namespace router {
                 // trailing input
                 return input.empty();
             }
+
+            /**
+             *  Find out where the path stops matching the given input
+             *
+             *  This does the same as match(), but tells how far it got.
+             *
+             *  @param  input   The input to test
+             *  @return The candidate, with the stage, slug and characters consumed filled in
+             */
+            trace::candidate explain(std::string_view input) const
+            {
+                // the result, assuming the input matches
+                trace::candidate result{};
+                result.prefix = _prefix;
+
+                // the size of the whole input, to tell how much we consumed
+                std::size_t size{ input.size() };
+
+                // the input must begin with the prefix
+                if (!match_prefix(input)) {
+                    result.failed   = trace::stage::prefix;
+                    result.consumed = std::mismatch(begin(input), end(input), begin(_prefix), end(_prefix)).first - begin(input);
+                    return result;
+                }
+
+                // remove the prefix from the input
+                input.remove_prefix(_prefix.size());
+
+                // go over all the edges
+                for (std::size_t index{ 0 }; index < _edges.size(); ++index) {
+                    // the slug and suffix to check
+                    const auto& [slug, suffix] = _edges[index];
+
+                    // the matched slug data, which we do not need
+                    std::string_view matched_data;
+
+                    // check the slug, and the suffix after it
+                    if (!slug.match(input, matched_data)) {
+                        result.failed = trace::stage::slug;
+                    } else if (input.substr(0, suffix.size()) != suffix) {
+                        result.failed = trace::stage::suffix;
+                    } else {
+                        input.remove_prefix(suffix.size());
+                        continue;
+                    }
+
+                    // the edge failed, after consuming this much
+                    result.slug     = index;
+                    result.consumed = size - input.size();
+                    return result;
+                }
+
+                // all input must be consumed
+                if (!input.empty()) {
+                    result.failed = trace::stage::trailing;
+                }
+
+                result.consumed = size - input.size();
+                return result;
+            }
         private:
             /**
-             *  An edge consists of a slug and a
-             *  literal trailing suffix
+             *  Parse the slug at the front of a path
+             *
+             *  @param  pattern     The full pattern the path is part of
+             *  @param  path        The remaining path, the slug is consumed from the input
+             *  @param  registry    The registry to share the slug expression with, if any
+             *  @return The parsed slug
+             *  @throws pattern_error If the slug is invalid
              */
-            using edge = std::pair<slug, std::string>;
+            static slug parse(std::string_view pattern, std::string_view& path, matcher_registry* registry)
+            {
+                // the position of the slug in the pattern
+                std::size_t position{ pattern.size() - path.size() };
+
+                #if defined(ROUTER_EXCEPTIONS)
+                    // report any error together with the pattern and position
+                    try {
+                        return slug{ path, registry };
+                    } catch (const std::exception& error) {
+                        throw pattern_error{ pattern, position, error.what() };
+                    }
+                #else
+                    // an invalid slug terminates the program
+                    static_cast<void>(pattern);
+                    static_cast<void>(position);
+                    return slug{ path, registry };
+                #endif
+            }
 
             std::string         _prefix;    // the part of the path up to the first slug
             std::vector<edge>   _edges;
@@ -2,9 +2,11 @@
 
 #include "function_traits.h"
 #include "wrap_callback.h"
+#include "slug_list.h"
+#include "status.h"
+#include "impl/exceptions.h"
 #include <functional>
 #include <string_view>
-#include <vector>
 
 
 namespace router {
@@ -41,7 +43,7 @@ namespace router {
              */
             template <auto callback, typename = std::enable_if_t<!std::is_member_function_pointer_v<decltype(callback)>>>
             path_callback(in_place_value<callback>) noexcept :
-                _callback{ &wrap_callback<callback> }
+                _operations{ &operations_for<callback> }
             {}
 
             /**
@@ -52,7 +54,7 @@ namespace router {
              */
             template <auto callback, typename = std::enable_if_t<std::is_member_function_pointer_v<decltype(callback)>>>
             path_callback(in_place_value<callback>, typename function_traits<decltype(callback)>::member_type* instance) noexcept :
-                _callback{ &wrap_callback<callback> },
+                _operations{ &operations_for<callback> },
                 _instance{ instance }
             {}
 
@@ -65,7 +67,7 @@ namespace router {
             std::enable_if_t<!std::is_member_function_pointer_v<decltype(callback)>>
             set() noexcept
             {
-                _callback = &wrap_callback<callback>;
+                _operations = &operations_for<callback>;
             }
 
             /**
@@ -78,8 +80,8 @@ namespace router {
             std::enable_if_t<std::is_member_function_pointer_v<decltype(callback)>>
             set(typename function_traits<decltype(callback)>::member_type* instance) noexcept
             {
-                _callback = &wrap_callback<callback>;
-                _instance = instance;
+                _operations = &operations_for<callback>;
+                _instance   = instance;
             }
 
             /**
@@ -87,9 +89,18 @@ namespace router {
              *
              *  @return Whether a callback was set
              */
-            bool valid() const noexcept { return _callback != nullptr; }
+            bool valid() const noexcept { return _operations != nullptr; }
             operator bool() const noexcept { return valid(); }
 
+            /**
+             *  Compare with another callback
+             *
+             *  @param  that    The callback to compare with
+             *  @return Whether both invoke the same function on the same instance
+             */
+            bool operator==(const path_callback& that) const noexcept { return _operations == that._operations && _instance == that._instance; }
+            bool operator!=(const path_callback& that) const noexcept { return !(*this == that); }
+
             /**
              *  Invoke the installed function
              *
@@ -97,23 +108,90 @@ namespace router {
              *  @param  parameters  The parameters to the callback
              *  @throws std::bad_function_call  In case no member function is installed
              */
-            return_type operator()(const std::vector<std::string_view>& slugs, arguments&&... parameters) const
+            return_type operator()(const slug_list& slugs, arguments&&... parameters) const
+            {
+                // check whether we have a valid callback
+                if (_operations == nullptr) {
+                    impl::fail<std::bad_function_call>();
+                }
+
+                // invoke the callback
+                return _operations->invoke(slugs, _instance, std::forward<arguments>(parameters)...);
+            }
+
+            /**
+             *  Invoke the installed function, without throwing
+             *  when the slugs cannot be converted
+             *
+             *  @param  slugs       The slugs parsed from the path
+             *  @param  parameters  The parameters to the callback
+             *  @return The result of the callback, status::not_found if no callback
+             *          is installed or status::conversion_failed for invalid slugs
+             */
+            result<return_type> try_call(const slug_list& slugs, arguments&&... parameters) const
             {
                 // check whether we have a valid callback
-                if (_callback == nullptr) {
-                    throw std::bad_function_call{};
+                if (_operations == nullptr) {
+                    return status::not_found;
                 }
 
                 // invoke the callback
-                return _callback(slugs, _instance, std::forward<arguments>(parameters)...);
+                return _operations->try_invoke(slugs, _instance, std::forward<arguments>(parameters)...);
+            }
+
+            /**
+             *  Convert the slugs for the installed function, so it can be
+             *  invoked later without converting them again
+             *
+             *  @param  slugs       The slugs parsed from the path
+             *  @param  storage     The storage to keep the converted slugs in
+             *  @return Whether a callback is installed and the slugs could be converted
+             */
+            bool convert(const slug_list& slugs, impl::slug_storage& storage) const
+            {
+                return _operations != nullptr && _operations->convert(slugs, storage);
+            }
+
+            /**
+             *  Invoke the installed function with the slugs converted by convert()
+             *
+             *  @param  storage     The storage holding the converted slugs
+             *  @param  parameters  The parameters to the callback
+             */
+            return_type invoke(impl::slug_storage& storage, arguments&&... parameters) const
+            {
+                return _operations->invoke_converted(storage, _instance, std::forward<arguments>(parameters)...);
             }
         private:
             /**
-             *  Alias for a wrapped callback
+             *  The wrapped versions of a single callback, the first one is used
+             *  for routing, the others only for routing without throwing or with
+             *  conversion checks
+             */
+            struct operations
+            {
+                return_type         (*invoke)(const slug_list& slugs, void* instance, arguments&&... parameters);                  // converts the slugs and invokes
+                result<return_type> (*try_invoke)(const slug_list& slugs, void* instance, arguments&&... parameters);              // reports failed conversions
+                bool                (*convert)(const slug_list& slugs, impl::slug_storage& storage);                               // converts the slugs ahead of time
+                return_type         (*invoke_converted)(impl::slug_storage& storage, void* instance, arguments&&... parameters);   // uses the converted slugs
+            };
+
+            /**
+             *  The operations for a callback, shared by every path_callback
+             *  invoking it, so a path_callback is no larger than the pointer
+             *  to these and the instance, which keeps the method slots of
+             *  proxies small. The table is constant, so the extra load while
+             *  routing is nearly always served from the cache.
              */
-            using wrapped_callback = return_type(*)(const std::vector<std::string_view>& slugs, void* instance, arguments&&... parameters);
+            template <auto callback>
+            constexpr static operations operations_for{
+                &wrap_callback<callback, return_type, arguments...>,
+                &try_wrap_callback<callback, return_type, arguments...>,
+                &convert_callback<callback, return_type, arguments...>,
+                &invoke_converted<callback, return_type, arguments...>
+            };
 
-            wrapped_callback    _callback{};    // the callback to invoke
+            const operations*   _operations{};  // the wrapped versions of the callback
             void*               _instance{};    // the instance to invoke on (empty for non-member functions)
     };
 
@@ -1,14 +1,57 @@
 #pragma once
 
 #include <algorithm>
+#include <iterator>
+#include <array>
 #include <vector>
+#include <string>
+#include <optional>
+#include <stdexcept>
+#include <condition_variable>
+#include <type_traits>
+#include <functional>
+#include <exception>
+#include <cstdint>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include "matcher_registry.h"
+#include "static_index.h"
+#include "route_cache.h"
+#include "statistics.h"
+#include "frozen_index.h"
+#include "slug_list.h"
+#include "automaton.h"
 #include "path.h"
+#include "impl/exceptions.h"
 
 
 namespace router {
 
     /**
      *  A class mapping paths to something else
+     *
+     *  Paths without any slugs are stored in a hash index, and are found
+     *  with a single lookup. An exact match always takes precedence over
+     *  paths with slugs.
+     *
+     *  Paths with slugs are indexed in a compressed trie (radix tree) on
+     *  their literal prefix. Each edge in the tree holds a piece of literal
+     *  data, and each node holds the paths whose prefix ends exactly at that
+     *  node. Finding the candidates for an endpoint only walks down the tree
+     *  along the endpoint, so the cost depends on the length of the endpoint
+     *  and not on the number of registered paths.
+     *
+     *  Candidates are tried in order of increasing prefix length, so the
+     *  shortest matching prefix comes first. Paths with the same prefix are
+     *  tried starting with the most recently added one, and paths without any
+     *  prefix are tried last.
+     *
+     *  Once all paths are added, the map can be compiled into a single
+     *  automaton, which finds the matching path in a single pass over
+     *  the endpoint, instead of trying the candidates one by one.
      */
     template <typename V>
     class path_map
@@ -26,30 +69,247 @@ namespace router {
             value_type& add(std::string_view endpoint, arguments&&... parameters)
             {
                 // create the path to route
-                path    path    { endpoint  };
-
-                // does the endpoint contain a fixed prefix?
-                if (path.prefix().empty()) {
-                    // there is no prefix to sort on so
-                    // we add this to the unsorted list
-                     return _unsorted_paths.emplace_back(
-                        std::piecewise_construct,
-                        std::forward_as_tuple(std::move(path)),
-                        std::forward_as_tuple(std::forward<arguments>(parameters)...)
-                    ).second;
-                } else {
-                    // find the element to insert before
-                    auto iter = std::lower_bound(begin(_prefixed_paths), end(_prefixed_paths), path, [](const auto& a, const auto& b) {
-                        // endpoints are sorted by prefix
-                        return std::get<0>(a).prefix() < b.prefix();
-                    });
+                path    path    { endpoint, _registry.get() };
+
+                // the slugs must fit in a slug list
+                check(path);
+
+                // the derived lookup structures no longer cover all paths
+                invalidate();
+
+                // store the path and the value
+                auto& entry = _entries.emplace_back(
+                    std::piecewise_construct,
+                    std::forward_as_tuple(std::move(path)),
+                    std::forward_as_tuple(std::forward<arguments>(parameters)...)
+                );
+
+                // make the path available for lookups, the index may never
+                // refer to an entry that is not there, so if this fails, the
+                // entry is removed again
+                #if defined(ROUTER_EXCEPTIONS)
+                    try {
+                        enlist(std::get<0>(entry), _entries.size() - 1);
+                    } catch (...) {
+                        _entries.pop_back();
+                        throw;
+                    }
+                #else
+                    enlist(std::get<0>(entry), _entries.size() - 1);
+                #endif
+
+                #if defined(ROUTER_INSTRUMENTATION)
+                    // count the lookups for the new path as well
+                    _statistics.resize(_entries.size());
+                #endif
+
+                return entry.second;
+            }
+
+            /**
+             *  Add many values to the map at once
+             *
+             *  This gives the same result as adding the values one by one,
+             *  in the given order. All paths are parsed first, after which
+             *  they are ordered on their prefix and added to the index in a
+             *  single pass, so that related paths are added together and the
+             *  storage for all of them is only allocated once.
+             *
+             *  @param  first   Iterator to the first endpoint and value pair
+             *  @param  last    Iterator past the last endpoint and value pair
+             */
+            template <typename iterator>
+            void add_all(iterator first, iterator last)
+            {
+                // the index of the first new entry
+                std::size_t base{ _entries.size() };
+
+                // parse all the paths before making them available, if any
+                // of them is invalid, we remove the ones we added already
+                #if defined(ROUTER_EXCEPTIONS)
+                    try {
+                        add_entries(first, last);
+                    } catch (...) {
+                        _entries.erase(begin(_entries) + base, end(_entries));
+                        throw;
+                    }
+                #else
+                    add_entries(first, last);
+                #endif
+
+                // make the new paths available for lookups
+                enlist_all(base);
+            }
+
+            /**
+             *  Add many values to the map at once, compiling the regular expressions in parallel
+             *
+             *  This gives the same result as the add_all() above, but the
+             *  regular expressions for the slugs, which take most of the time
+             *  to parse, are compiled by tasks handed to the given executor.
+             *  The executor may run these tasks on any thread, in any order,
+             *  and this call waits until they are all done. The paths are then
+             *  added like the add_all() above, so when any path is invalid, the
+             *  error for the first invalid path is thrown, and nothing is added.
+             *
+             *  Slugs with a type or a simple character class do not need a
+             *  regular expression. When no slug needs one, no tasks are run.
+             *
+             *  The iterators are used twice, so they must be forward iterators.
+             *
+             *  @param  first   Iterator to the first endpoint and value pair
+             *  @param  last    Iterator past the last endpoint and value pair
+             *  @param  execute Callable invoked with every task to run, as a std::function<void()>
+             *  @param  tasks   The number of tasks to divide the work over
+             */
+            template <typename iterator, typename executor>
+            std::enable_if_t<std::is_invocable_v<executor&, std::function<void()>>>
+            add_all(iterator first, iterator last, executor&& execute, std::size_t tasks = std::thread::hardware_concurrency())
+            {
+                // the regular expressions the paths need
+                std::vector<std::string_view> expressions;
+
+                for (auto iter = first; iter != last; ++iter) {
+                    path::regular_expressions(std::get<0>(*iter), expressions);
+                }
+
+                // every expression is only compiled once
+                std::sort(begin(expressions), end(expressions));
+                expressions.erase(std::unique(begin(expressions), end(expressions)), end(expressions));
+
+                // without any expressions there is nothing to do in parallel
+                if (expressions.empty()) {
+                    add_all(first, last);
+                    return;
+                }
+
+                // the compiled expressions, kept alive until the paths use them
+                std::vector<std::shared_ptr<const std::regex>> compiled(expressions.size());
+
+                // the shared state of the tasks
+                std::atomic<std::size_t>    next    { 0 };
+                std::size_t                 running { 0 };
+                std::mutex                  mutex;
+                std::condition_variable     done;
+
+                // the task compiling the expressions, every task takes the next
+                // expression until all of them are compiled, an invalid expression
+                // is skipped, it is reported when the path using it is added
+                auto compile = [&]() {
+                    for (auto index = next.fetch_add(1); index < expressions.size(); index = next.fetch_add(1)) {
+                        #if defined(ROUTER_EXCEPTIONS)
+                            try {
+                                compiled[index] = _registry->expression(expressions[index]);
+                            } catch (...) {}
+                        #else
+                            compiled[index] = _registry->expression(expressions[index]);
+                        #endif
+                    }
+
+                    // signal that this task is done
+                    std::lock_guard lock{ mutex };
+
+                    if (--running == 0) {
+                        done.notify_one();
+                    }
+                };
+
+                // there is no point in having more tasks than expressions
+                tasks = std::clamp<std::size_t>(tasks, 1, expressions.size());
+
+                // hand out the tasks, when the executor fails, the tasks handed
+                // out before still refer to our state, so we wait for them
+                std::exception_ptr failure;
+
+                for (std::size_t i{ 0 }; i < tasks && failure == nullptr; ++i) {
+                    // register the task before it can possibly finish
+                    {
+                        std::lock_guard lock{ mutex };
+                        ++running;
+                    }
+
+                    #if defined(ROUTER_EXCEPTIONS)
+                        try {
+                            execute(std::function<void()>{ compile });
+                        } catch (...) {
+                            // the task never runs, so remove it again
+                            std::lock_guard lock{ mutex };
+                            --running;
+
+                            failure = std::current_exception();
+                        }
+                    #else
+                        execute(std::function<void()>{ compile });
+                    #endif
+                }
+
+                // wait for all tasks to finish
+                {
+                    std::unique_lock lock{ mutex };
+                    done.wait(lock, [&running]() { return running == 0; });
+                }
+
+                #if defined(ROUTER_EXCEPTIONS)
+                    // report the failure to run the tasks
+                    if (failure != nullptr) {
+                        std::rethrow_exception(failure);
+                    }
+                #endif
+
+                // the paths now find their expressions in the registry
+                add_all(first, last);
+            }
 
-                    // add it to the sorted list before the found element
-                    return _prefixed_paths.emplace(iter,
-                        std::piecewise_construct,
-                        std::forward_as_tuple(std::move(path)),
-                        std::forward_as_tuple(std::forward<arguments>(parameters)...)
-                    )->second;
+            /**
+             *  Add many values to the map at once, compiling the regular expressions on a number of threads
+             *
+             *  This gives the same result as the add_all() above, but the regular
+             *  expressions for the slugs are compiled by at most the given number
+             *  of threads, and no more than there are cores. The threads are only
+             *  started when there are expressions to compile. If any path is invalid, the error for the first invalid
+             *  path is thrown, and nothing is added.
+             *
+             *  @param  first   Iterator to the first endpoint and value pair
+             *  @param  last    Iterator past the last endpoint and value pair
+             *  @param  threads The number of threads to use
+             */
+            template <typename iterator>
+            void add_all(iterator first, iterator last, std::size_t threads)
+            {
+                // more threads than cores only adds overhead
+                threads = std::min<std::size_t>(threads, std::max(std::thread::hardware_concurrency(), 1u));
+
+                // a single thread is simply the calling thread
+                if (threads <= 1) {
+                    add_all(first, last);
+                    return;
+                }
+
+                // the threads running the tasks
+                std::vector<std::thread> workers;
+
+                // the executor, running every task on its own thread
+                auto spawn = [&workers](std::function<void()> task) {
+                    workers.emplace_back(std::move(task));
+                };
+
+                // run the tasks, joining the threads whatever happens
+                #if defined(ROUTER_EXCEPTIONS)
+                    try {
+                        add_all(first, last, spawn, threads);
+                    } catch (...) {
+                        for (auto& worker : workers) {
+                            worker.join();
+                        }
+
+                        throw;
+                    }
+                #else
+                    add_all(first, last, spawn, threads);
+                #endif
+
+                for (auto& worker : workers) {
+                    worker.join();
                 }
             }
 
@@ -60,57 +320,922 @@ namespace router {
              *  @param  endpoint    The endpoint to lookup
              *  @return The found value, or a nullptr
              */
-            const value_type* find(std::vector<std::string_view>& slugs, std::string_view endpoint) const noexcept
+            template <typename slug_container>
+            const value_type* find(slug_container& slugs, std::string_view endpoint) const noexcept
+            {
+                return find(slugs, endpoint, accept_all{});
+            }
+
+            /**
+             *  Find an entry in the map, which must also be accepted
+             *
+             *  When a path matches the endpoint, the acceptor is invoked with
+             *  the value and the slugs. If it rejects them, the lookup goes on
+             *  with the next candidate, as if the path did not match at all.
+             *
+             *  @param  slugs       The slugs to fill if found
+             *  @param  endpoint    The endpoint to lookup
+             *  @param  accept      Callable invoked with the value and slugs of every matching path
+             *  @return The found value, or a nullptr
+             */
+            template <typename slug_container, typename acceptor>
+            const value_type* find(slug_container& slugs, std::string_view endpoint, acceptor&& accept) const
+            {
+                #if defined(ROUTER_INSTRUMENTATION)
+                    // attribute the candidates tried to this map
+                    router::statistics::scope scope{ _statistics };
+
+                    // find the value and count the outcome
+                    auto* value = find_value(slugs, endpoint, accept);
+                    scope.finish(value == nullptr ? router::statistics::npos : index_of(value));
+
+                    return value;
+                #else
+                    return find_value(slugs, endpoint, accept);
+                #endif
+            }
+
+            /**
+             *  Find the entries for a batch of endpoints
+             *
+             *  This gives the same results as calling find() for every
+             *  endpoint, but the exact match lookups are interleaved: the
+             *  slots for a chunk of endpoints are prefetched together.
+             *
+             *  @param  endpoints   The endpoints to lookup
+             *  @param  count       The number of endpoints
+             *  @param  slugs       The slugs to fill for every endpoint
+             *  @param  values      The found value for every endpoint, or a nullptr
+             */
+            template <typename slug_container>
+            void find_batch(const std::string_view* endpoints, std::size_t count, slug_container* slugs, const value_type** values) const
+            {
+                #if defined(ROUTER_INSTRUMENTATION)
+                    // attribute the candidates tried to this map
+                    router::statistics::scope scope{ _statistics };
+
+                    // find the values and count the outcome for every endpoint
+                    find_values(endpoints, count, slugs, values);
+
+                    for (std::size_t i{ 0 }; i < count; ++i) {
+                        _statistics.record(values[i] == nullptr ? router::statistics::npos : index_of(values[i]));
+                    }
+                #else
+                    find_values(endpoints, count, slugs, values);
+                #endif
+            }
+
+            /**
+             *  Look up an endpoint, recording every path that is tried
+             *
+             *  The paths with slugs are tried in the order of the prefix tree.
+             *  A compiled or frozen map, or the cache, finds the same value, but
+             *  the time they take is not reflected in the trace.
+             *
+             *  @param  endpoint    The endpoint to lookup
+             *  @return The trace of the lookup, with the index of the entry found
+             */
+            trace explain(std::string_view endpoint) const
+            {
+                // the slugs matched by the paths tried
+                slug_list slugs;
+
+                return explain(slugs, endpoint, accept_all{});
+            }
+
+            /**
+             *  Look up an endpoint with an acceptor, recording every path that is tried
+             *
+             *  This finds the same entry as find() with the same acceptor. Paths
+             *  that match, but are rejected by the acceptor, are recorded with
+             *  the conversion stage.
+             *
+             *  @param  slugs       The slugs to fill for every path that matches
+             *  @param  endpoint    The endpoint to lookup
+             *  @param  accept      Callable invoked with the value and slugs of every matching path
+             *  @return The trace of the lookup, with the index of the entry found
+             */
+            template <typename slug_container, typename acceptor>
+            trace explain(slug_container& slugs, std::string_view endpoint, acceptor accept) const
+            {
+                // the trace to fill, and the moment we started
+                trace   result  {                                   };
+                auto    start   { std::chrono::steady_clock::now()  };
+
+                // check for an exact match first
+                if (auto index = _static.find(endpoint, static_index::hash(endpoint)); index != static_index::npos) {
+                    // there are no slugs for a path without slugs
+                    slugs.clear();
+                    result.exact = true;
+
+                    // a rejected path without slugs is the only candidate
+                    if (accept(std::get<1>(_entries[index]), slugs)) {
+                        result.route = index;
+                    } else {
+                        trace::candidate candidate{};
+
+                        candidate.route     = index;
+                        candidate.prefix    = std::get<0>(_entries[index]).prefix();
+                        candidate.failed    = trace::stage::conversion;
+                        candidate.consumed  = endpoint.size();
+
+                        result.candidates.push_back(candidate);
+                    }
+                } else {
+                    // the nodes with paths that may match, with the
+                    // paths without a known prefix tried after them
+                    std::vector<std::pair<std::size_t, std::size_t>> visited;
+                    walk(0, 0, endpoint, visited);
+                    visited.emplace_back(0, 0);
+
+                    for (const auto& [index, consumed] : visited) {
+                        if (explain(_nodes[index], slugs, endpoint, accept, result)) {
+                            break;
+                        }
+                    }
+                }
+
+                result.time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+                return result;
+            }
+
+            /**
+             *  Compile all paths into a single automaton
+             *
+             *  This only succeeds when none of the paths uses a regular
+             *  expression for its slugs, and the resulting automaton does
+             *  not exceed the given number of states. Adding another path
+             *  discards the automaton again.
+             *
+             *  @param  max_states  The maximum number of states in the automaton
+             *  @return Whether the paths were compiled
+             */
+            bool compile(std::size_t max_states = 1 << 16)
+            {
+                // the entries with slugs, paths without slugs are found in the index
+                std::vector<std::size_t> ranked;
+
+                for (std::size_t i{ 0 }; i < _entries.size(); ++i) {
+                    if (!std::get<0>(_entries[i]).edges().empty()) {
+                        ranked.push_back(i);
+                    }
+                }
+
+                // order the entries in the way find() would try them
+
+                std::sort(begin(ranked), end(ranked), [this](std::size_t a, std::size_t b) {
+                    // retrieve the prefixes to compare
+                    auto prefix_a = std::get<0>(_entries[a]).prefix();
+                    auto prefix_b = std::get<0>(_entries[b]).prefix();
+
+                    // paths without a prefix come last, shorter prefixes
+                    // come first and otherwise the newest entry wins
+                    if (prefix_a.empty() != prefix_b.empty()) {
+                        return prefix_b.empty();
+                    } else if (prefix_a.size() != prefix_b.size()) {
+                        return prefix_a.size() < prefix_b.size();
+                    } else {
+                        return a > b;
+                    }
+                });
+
+                // collect the paths in order of priority
+                std::vector<const path*> paths;
+                paths.reserve(ranked.size());
+
+                for (auto index : ranked) {
+                    paths.push_back(&std::get<0>(_entries[index]));
+                }
+
+                // try to build the automaton
+                _automaton = automaton::compile(paths, max_states);
+                _ranked = std::move(ranked);
+
+                return _automaton.has_value();
+            }
+
+            /**
+             *  Check whether the map is compiled
+             *
+             *  @return Whether lookups use a compiled automaton
+             */
+            bool compiled() const noexcept
+            {
+                return _automaton.has_value();
+            }
+
+            /**
+             *  Freeze the paths into a compact layout
+             *
+             *  This copies all paths and the prefix tree into a few contiguous
+             *  arrays, so that lookups touch less memory. Slugs that need a
+             *  regular expression are not copied, the frozen layout uses the
+             *  ones of the paths. Lookups find the same values as before.
+             *  Adding another path discards the frozen layout.
+             */
+            void freeze()
+            {
+                // the index to fill
+                frozen_index index;
+
+                // add all paths, in order
+                for (const auto& [path, value] : _entries) {
+                    index.add_path(path);
+                }
+
+                // and all nodes, with the most recently added entries first
+                for (const auto& current : _nodes) {
+                    index.add_node(current.label, current.children, std::vector<std::size_t>(rbegin(current.entries), rend(current.entries)));
+                }
+
+                _frozen = std::move(index);
+            }
+
+            /**
+             *  Check whether the map is frozen
+             *
+             *  @return Whether lookups use the frozen layout
+             */
+            bool frozen() const noexcept
+            {
+                return _frozen.has_value();
+            }
+
+            /**
+             *  Cache the values found for endpoints with slugs
+             *
+             *  Repeated lookups for the same endpoint are then answered from
+             *  the cache. Lookups with the cache enabled may still happen from
+             *  multiple threads at the same time.
+             *
+             *  @param  capacity    The number of endpoints to cache, zero disables the cache
+             */
+            void enable_cache(std::size_t capacity)
+            {
+                // remove the cache, or create a new one
+                if (capacity == 0) {
+                    _cache.reset();
+                } else {
+                    _cache.emplace(capacity);
+                }
+            }
+
+            /**
+             *  Retrieve the cache
+             *
+             *  @return The cache, or a nullptr if the cache is disabled
+             */
+            const route_cache<value_type>* cache() const noexcept
+            {
+                return _cache ? &*_cache : nullptr;
+            }
+
+            /**
+             *  Share the compiled slug expressions with other maps
+             *
+             *  Paths added after this share their expressions with all
+             *  other maps using the same registry. Paths that were added
+             *  before keep the expressions they already have.
+             *
+             *  @param  registry    The registry to use, or a nullptr for a new registry
+             */
+            void share_matchers(std::shared_ptr<matcher_registry> registry)
+            {
+                _registry = registry ? std::move(registry) : std::make_shared<matcher_registry>();
+            }
+
+            /**
+             *  Retrieve the registry holding the compiled slug expressions
+             *
+             *  @return The registry used for new paths
+             */
+            const matcher_registry& matchers() const noexcept
+            {
+                return *_registry;
+            }
+
+            /**
+             *  Retrieve the counters for the lookups done with the map
+             *
+             *  The counters are only maintained when ROUTER_INSTRUMENTATION
+             *  is defined, otherwise the snapshot is always empty.
+             *
+             *  @return The counters, added up over all threads
+             */
+            router::statistics::snapshot statistics() const
+            {
+                #if defined(ROUTER_INSTRUMENTATION)
+                    return _statistics.collect();
+                #else
+                    return {};
+                #endif
+            }
+
+            /**
+             *  Set the counters for the lookups back to zero
+             */
+            void reset_statistics() noexcept
+            {
+                #if defined(ROUTER_INSTRUMENTATION)
+                    _statistics.reset();
+                #endif
+            }
+
+            #if defined(ROUTER_INSTRUMENTATION)
+                /**
+                 *  Retrieve the counters, to count events outside the map
+                 *
+                 *  @return The counters for the map
+                 */
+                const router::statistics& counters() const noexcept
+                {
+                    return _statistics;
+                }
+            #endif
+        private:
+            /**
+             *  The entry type we store inside the map, we store both the
+             *  path and the given value type together in a flat structure
+             */
+            using entry = std::pair<path, value_type>;
+
+            /**
+             *  The number of endpoints whose slots are prefetched together
+             */
+            constexpr static std::size_t batch_size = 64;
+
+            /**
+             *  A node in the prefix tree
+             */
+            struct node
+            {
+                std::string                                 label;      // the literal data on the edge leading here
+                std::vector<std::pair<char, std::size_t>>   children;   // the child nodes, sorted by their first character
+                std::vector<std::size_t>                    entries;    // entries with a prefix ending here, in insertion order
+            };
+
+            /**
+             *  Acceptor for lookups accepting every path that matches
+             */
+            struct accept_all
+            {
+                template <typename slug_container>
+                constexpr bool operator()(const value_type&, const slug_container&) const noexcept
+                {
+                    return true;
+                }
+            };
+
+            /**
+             *  Check whether a path can be added
+             *
+             *  @param  path    The path to check
+             *  @throws std::length_error   If the path contains too many slugs
+             */
+            static void check(const path& path)
+            {
+                // the slugs must fit in a slug list
+                if (path.edges().size() > slug_list::capacity) {
+                    impl::fail<std::length_error>("Path contains too many slugs");
+                }
+            }
+
+            /**
+             *  Parse paths and store them with their values, without
+             *  making them available for lookups yet
+             *
+             *  @param  first   Iterator to the first endpoint and value pair
+             *  @param  last    Iterator past the last endpoint and value pair
+             */
+            template <typename iterator>
+            void add_entries(iterator first, iterator last)
+            {
+                for (; first != last; ++first) {
+                    // the endpoint and value to add
+                    const auto& [endpoint, value] = *first;
+
+                    // create the path and check its slugs
+                    check(_entries.emplace_back(path{ endpoint, _registry.get() }, value).first);
+                }
+            }
+
+            /**
+             *  Make the entries added at once available for lookups
+             *
+             *  @param  base    The index of the first new entry
+             */
+            void enlist_all(std::size_t base)
+            {
+                // the derived lookup structures no longer cover all paths
+                invalidate();
+
+                // the new paths with slugs, with their prefix
+                std::vector<std::pair<std::string_view, std::size_t>> prefixed;
+
+                // paths without slugs go straight into the exact match index
+                _static.reserve(_static.size() + _entries.size() - base);
+
+                for (std::size_t index{ base }; index < _entries.size(); ++index) {
+                    // retrieve the path to add
+                    const auto& path = std::get<0>(_entries[index]);
+
+                    if (path.edges().empty()) {
+                        _static.insert(path.prefix(), index);
+                    } else {
+                        prefixed.emplace_back(path.prefix(), index);
+                    }
+                }
+
+                // order the paths with slugs on their prefix, keeping the order
+                // in which they were given for paths with the same prefix, since
+                // the most recently added path takes precedence
+                std::stable_sort(begin(prefixed), end(prefixed), [](const auto& a, const auto& b) {
+                    return a.first < b.first;
+                });
+
+                // the nodes on the way to the previous prefix, with the
+                // number of characters consumed after reaching them
+                std::vector<std::pair<std::size_t, std::size_t>> visited;
+                std::string_view                                 previous;
+
+                // add them to the tree, since the prefixes are sorted, the
+                // walk down for a prefix can continue where it diverges from
+                // the previous one, instead of starting at the root again
+                for (const auto& [prefix, index] : prefixed) {
+                    // the number of leading characters shared with the previous prefix
+                    std::size_t shared = std::mismatch(begin(prefix), end(prefix), begin(previous), end(previous)).first - begin(prefix);
+
+                    // nodes beyond the shared part are not on the way to this prefix
+                    while (!visited.empty() && visited.back().second > shared) {
+                        visited.pop_back();
+                    }
+
+                    // continue from the deepest shared node
+                    std::size_t start       { visited.empty() ? 0 : visited.back().first    };
+                    std::size_t consumed    { visited.empty() ? 0 : visited.back().second   };
+
+                    _nodes[insert(prefix.substr(consumed), start, consumed, &visited)].entries.push_back(index);
+                    previous = prefix;
+                }
+
+                #if defined(ROUTER_INSTRUMENTATION)
+                    // count the lookups for the new paths as well
+                    _statistics.resize(_entries.size());
+                #endif
+            }
+
+            /**
+             *  Discard everything derived from the paths, after adding a path
+             */
+            void invalidate() noexcept
+            {
+                // the compiled automaton and frozen index no longer cover all paths
+                _automaton.reset();
+                _frozen.reset();
+
+                // cached endpoints may now find a different value
+                if (_cache) {
+                    _cache->clear();
+                }
+            }
+
+            /**
+             *  Make an entry available for lookups
+             *
+             *  @param  path    The path of the entry
+             *  @param  index   The index of the entry
+             */
+            void enlist(const path& path, std::size_t index)
+            {
+                // paths without slugs only need an exact match
+                if (path.edges().empty()) {
+                    // register it in the index, replacing an earlier path
+                    _static.insert(path.prefix(), index);
+                } else {
+                    // find (or create) the node for the prefix and register the entry there
+                    _nodes[insert(path.prefix())].entries.push_back(index);
+                }
+            }
+
+            /**
+             *  Find the child of a node starting with the given character
+             *
+             *  @param  parent      The node to find the child in
+             *  @param  character   The first character of the child label
+             *  @return The index of the child, or zero if no such child exists
+             */
+            static std::size_t child(const node& parent, char character) noexcept
             {
-                // find the first possibly matching entry by prefix
-                auto iter = std::lower_bound(begin(_prefixed_paths), end(_prefixed_paths), endpoint, [](const auto& a, const auto& b) {
-                    // check whether the prefix comes before the given endpoint
-                    return std::get<0>(a).prefix() < b.substr(0, std::get<0>(a).prefix().size());
+                // find the child in the sorted list
+                auto iter = std::lower_bound(begin(parent.children), end(parent.children), character, [](const auto& a, char b) {
+                    return a.first < b;
                 });
 
-                // try all valid matches
-                while (iter != end(_prefixed_paths)) {
-                    // retrieve the path, callback and instance
-                    const auto& [path, value] = *iter;
+                // the root is never a child, so zero signals a missing child
+                if (iter == end(parent.children) || iter->first != character) {
+                    return 0;
+                }
+
+                return iter->second;
+            }
+
+            /**
+             *  Find an entry in the map, without counting the lookup
+             *
+             *  @param  slugs       The slugs to fill if found
+             *  @param  endpoint    The endpoint to lookup
+             *  @param  accept      Callable deciding whether a matching path is used
+             *  @return The found value, or a nullptr
+             */
+            template <typename slug_container, typename acceptor>
+            const value_type* find_value(slug_container& slugs, std::string_view endpoint, acceptor& accept) const
+            {
+                // the hash is shared by the index and the cache
+                auto hash = static_index::hash(endpoint);
+
+                // check for an exact match first
+                if (auto index = _static.find(endpoint, hash); index != static_index::npos) {
+                    // there are no slugs for a path without slugs
+                    slugs.clear();
+
+                    // a path without slugs takes precedence, so there is
+                    // nothing else to try when it is rejected
+                    return accept(std::get<1>(_entries[index]), slugs) ? &std::get<1>(_entries[index]) : nullptr;
+                }
+
+                // try the paths with slugs
+                return find_cached(slugs, endpoint, hash, accept);
+            }
+
+            /**
+             *  Find the entries for a batch of endpoints, without counting the lookups
+             *
+             *  @param  endpoints   The endpoints to lookup
+             *  @param  count       The number of endpoints
+             *  @param  slugs       The slugs to fill for every endpoint
+             *  @param  values      The found value for every endpoint, or a nullptr
+             */
+            template <typename slug_container>
+            void find_values(const std::string_view* endpoints, std::size_t count, slug_container* slugs, const value_type** values) const
+            {
+                // the hashes for a chunk of endpoints
+                std::array<std::uint64_t, batch_size> hashes;
+
+                // every matching path is accepted
+                accept_all accept;
+
+                for (std::size_t first{ 0 }; first < count; first += batch_size) {
+                    // the number of endpoints in this chunk
+                    auto size = std::min(batch_size, count - first);
+
+                    // calculate all hashes and start loading their slots
+                    for (std::size_t i{ 0 }; i < size; ++i) {
+                        hashes[i] = static_index::hash(endpoints[first + i]);
+                        _static.prefetch(hashes[i]);
+                    }
+
+                    // now look up the endpoints, whose slots should be loaded by now
+                    for (std::size_t i{ 0 }; i < size; ++i) {
+                        // the endpoint to look up, and where to store the result
+                        auto    endpoint    = endpoints[first + i];
+                        auto&   value       = values[first + i];
+                        auto&   matched     = slugs[first + i];
+
+                        // do we have an exact match?
+                        if (auto index = _static.find(endpoint, hashes[i]); index != static_index::npos) {
+                            matched.clear();
+                            value = &std::get<1>(_entries[index]);
+                        } else {
+                            value = find_cached(matched, endpoint, hashes[i], accept);
+                        }
+                    }
+                }
+            }
+
+            /**
+             *  Find an entry with slugs in the map, using the cache if enabled
+             *
+             *  @param  slugs       The slugs to fill if found
+             *  @param  endpoint    The endpoint to lookup
+             *  @param  hash        The hash of the endpoint
+             *  @param  accept      Callable deciding whether a matching path is used
+             *  @return The found value, or a nullptr
+             */
+            template <typename slug_container, typename acceptor>
+            const value_type* find_cached(slug_container& slugs, std::string_view endpoint, std::uint64_t hash, acceptor& accept) const
+            {
+                // without a cache we look up the endpoint right away
+                if (!_cache) {
+                    return find_dynamic(slugs, endpoint, accept);
+                }
+
+                // did we find the endpoint before? the value must still be
+                // accepted, since the acceptor may keep data for the value
+                if (auto* value = _cache->find(endpoint, hash, slugs); value != nullptr && accept(*value, slugs)) {
+                    return value;
+                }
+
+                // look up the endpoint and remember the value for next time
+                auto* value = find_dynamic(slugs, endpoint, accept);
 
-                    // if the prefix no longer matches we have exhausted all options
-                    if (!path.match_prefix(endpoint)) {
-                        // stop now to avoid expensive regex calls
+                if (value != nullptr) {
+                    _cache->store(endpoint, hash, value, slugs);
+                }
+
+                return value;
+            }
+
+            /**
+             *  Find an entry with slugs in the map
+             *
+             *  @param  slugs       The slugs to fill if found
+             *  @param  endpoint    The endpoint to lookup
+             *  @param  accept      Callable deciding whether a matching path is used
+             *  @return The found value, or a nullptr
+             */
+            template <typename slug_container, typename acceptor>
+            const value_type* find_dynamic(slug_container& slugs, std::string_view endpoint, acceptor& accept) const
+            {
+                // use the compiled automaton if available
+                if (_automaton) {
+                    // find the path with the highest priority that matches
+                    auto rank = _automaton->match(endpoint);
+
+                    // none of the paths matched
+                    if (rank == automaton::npos) {
+                        return nullptr;
+                    }
+
+                    // match the path again to extract the slugs, since all
+                    // slugs use a scanner this does not involve any regex
+                    const auto& [path, value] = _entries[_ranked[rank]];
+
+                    #if defined(ROUTER_INSTRUMENTATION)
+                        // the automaton tried all paths at once, only this one is matched again
+                        router::statistics::examine(_ranked[rank]);
+                    #endif
+
+                    if (_frozen) {
+                        _frozen->match(_ranked[rank], path, endpoint, slugs);
+                    } else {
+                        path.match(endpoint, slugs);
+                    }
+
+                    // the automaton only knows the best path, so when it is
+                    // rejected, the candidates are tried one by one below
+                    if (accept(value, slugs)) {
+                        return &value;
+                    }
+                }
+
+                // use the frozen layout if available
+                if (_frozen) {
+                    // the paths the layout was created from, for the slugs with a regular expression
+                    auto paths = [this](std::size_t entry) -> const path& {
+                        return std::get<0>(_entries[entry]);
+                    };
+
+                    // find the path that matches and is accepted
+                    auto index = _frozen->find(endpoint, slugs, paths, [this, &accept](std::size_t entry, const slug_container& matched) {
+                        return accept(std::get<1>(_entries[entry]), matched);
+                    });
+
+                    // and return the value belonging to it
+                    return index == frozen_index::npos ? nullptr : &std::get<1>(_entries[index]);
+                }
+
+                // start at the root, which holds the paths without a prefix,
+                // these are only tried after all the prefixed paths failed
+                std::size_t         index       { 0         };
+                std::string_view    remaining   { endpoint  };
+
+                // walk down the tree as far as the endpoint allows
+                while (!remaining.empty()) {
+                    // find the child that continues with the next character
+                    index = child(_nodes[index], remaining.front());
+
+                    // stop if there is no child, or the edge does not match
+                    if (index == 0 || remaining.substr(0, _nodes[index].label.size()) != _nodes[index].label) {
                         break;
                     }
 
-                    // try to match the path to the given endpoint
-                    if (path.match(endpoint, slugs)) {
+                    // consume the edge data
+                    remaining.remove_prefix(_nodes[index].label.size());
+
+                    // try all paths with a prefix ending here
+                    if (auto* value = match(_nodes[index], slugs, endpoint, accept); value != nullptr) {
                         // we matched the endpoint, return the handler
-                        return &value;
+                        return value;
+                    }
+                }
+
+                // none of the prefixed paths matched, so try
+                // the paths without a known prefix
+                return match(_nodes.front(), slugs, endpoint, accept);
+            }
+
+            /**
+             *  Get the index of the entry holding a value
+             *
+             *  @param  value   The value, which must be stored in the map
+             *  @return The index of the entry
+             */
+            std::size_t index_of(const value_type* value) const noexcept
+            {
+                // the values are spread evenly over the entries
+                auto offset = reinterpret_cast<const char*>(value) - reinterpret_cast<const char*>(&std::get<1>(_entries.front()));
+
+                return static_cast<std::size_t>(offset) / sizeof(entry);
+            }
+
+            /**
+             *  Walk down the tree along an endpoint, collecting the nodes
+             *  whose edge is fully matched by the endpoint
+             *
+             *  @param  index       The node to start at
+             *  @param  consumed    The number of characters consumed to reach the node
+             *  @param  endpoint    The endpoint to walk along
+             *  @param  visited     The nodes visited, with the number of characters consumed
+             */
+            void walk(std::size_t index, std::size_t consumed, std::string_view endpoint, std::vector<std::pair<std::size_t, std::size_t>>& visited) const
+            {
+                // the part of the endpoint we still have to walk
+                auto remaining = endpoint.substr(consumed);
+
+                // walk down the tree as far as the endpoint allows
+                while (!remaining.empty()) {
+                    // find the child that continues with the next character
+                    index = child(_nodes[index], remaining.front());
+
+                    // stop if there is no child, or the edge does not match
+                    if (index == 0 || remaining.substr(0, _nodes[index].label.size()) != _nodes[index].label) {
+                        break;
+                    }
+
+                    // consume the edge data and register the node
+                    remaining.remove_prefix(_nodes[index].label.size());
+                    visited.emplace_back(index, endpoint.size() - remaining.size());
+                }
+            }
+
+            /**
+             *  Find or create the node for the given prefix
+             *
+             *  The nodes passed on the way down are recorded together with the
+             *  number of characters consumed after reaching them, so that a
+             *  following insert with a shared prefix can start from one of them.
+             *
+             *  @param  prefix      The prefix to insert, relative to the start node
+             *  @param  index       The node to start at
+             *  @param  consumed    The number of characters consumed to reach the start node
+             *  @param  visited     The nodes passed on the way down, if these must be recorded
+             *  @return The index of the node
+             */
+            std::size_t insert(std::string_view prefix, std::size_t index = 0, std::size_t consumed = 0, std::vector<std::pair<std::size_t, std::size_t>>* visited = nullptr)
+            {
+                // descend until the whole prefix is consumed
+                while (!prefix.empty()) {
+                    // find the child we have to descend into
+                    auto& children  = _nodes[index].children;
+                    auto  iter      = std::lower_bound(begin(children), end(children), prefix.front(), [](const auto& a, char b) {
+                        return a.first < b;
+                    });
+
+                    // is there no child starting with the same character?
+                    if (iter == end(children) || iter->first != prefix.front()) {
+                        // add a new leaf holding the remainder of the prefix
+                        children.emplace(iter, prefix.front(), _nodes.size());
+                        _nodes.push_back(node{ std::string{ prefix }, {}, {} });
+
+                        // record the leaf as well
+                        if (visited != nullptr) {
+                            visited->emplace_back(_nodes.size() - 1, consumed + prefix.size());
+                        }
+
+                        return _nodes.size() - 1;
                     }
 
-                    // move on to the next entry
-                    ++iter;
+                    // find out how much of the edge label matches the prefix
+                    std::size_t child   = iter->second;
+                    std::size_t common  = std::mismatch(begin(prefix), end(prefix), begin(_nodes[child].label), end(_nodes[child].label)).first - begin(prefix);
+
+                    // does the prefix diverge from the edge halfway?
+                    if (common < _nodes[child].label.size()) {
+                        // split the edge, creating an intermediate node
+                        std::size_t middle = _nodes.size();
+                        iter->second = middle;
+
+                        // the intermediate node takes the common part of the label
+                        node split{ _nodes[child].label.substr(0, common), {}, {} };
+                        _nodes[child].label.erase(0, common);
+                        split.children.emplace_back(_nodes[child].label.front(), child);
+                        _nodes.push_back(std::move(split));
+
+                        // continue from the intermediate node
+                        child = middle;
+                    }
+
+                    // consume the matched part of the prefix
+                    prefix.remove_prefix(common);
+                    consumed += common;
+                    index = child;
+
+                    // and record the node we reached
+                    if (visited != nullptr) {
+                        visited->emplace_back(index, consumed);
+                    }
                 }
 
-                // none of the prefixed paths matched, so try the
-                // unsorted paths without a known prefix
-                for (const auto& [path, value] : _unsorted_paths) {
+                return index;
+            }
+
+            /**
+             *  Try the entries stored in a node, recording every attempt
+             *
+             *  @param  current     The node to try the entries for
+             *  @param  slugs       The slugs to fill for every path that matches
+             *  @param  endpoint    The endpoint to lookup
+             *  @param  accept      Callable deciding whether a matching path is used
+             *  @param  result      The trace to add the attempts to
+             *  @return Whether one of the entries matched and was accepted
+             */
+            template <typename slug_container, typename acceptor>
+            bool explain(const node& current, slug_container& slugs, std::string_view endpoint, acceptor& accept, trace& result) const
+            {
+                // the most recently added entry takes precedence
+                for (auto iter = rbegin(current.entries); iter != rend(current.entries); ++iter) {
+                    // the entry to try
+                    const auto& [path, value] = _entries[*iter];
+
+                    // try the path, and time it
+                    auto    start       { std::chrono::steady_clock::now()  };
+                    auto    candidate   { path.explain(endpoint)            };
+
+                    // a matching path must also be accepted
+                    if (candidate.failed == trace::stage::matched && !(path.match(endpoint, slugs) && accept(value, slugs))) {
+                        candidate.failed = trace::stage::conversion;
+                    }
+
+                    candidate.route = *iter;
+                    candidate.time  = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+                    result.candidates.push_back(candidate);
+
+                    // stop at the first path that matches
+                    if (candidate.failed == trace::stage::matched) {
+                        result.route = *iter;
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            /**
+             *  Try to match the entries stored in a node
+             *
+             *  @param  current     The node to try the entries for
+             *  @param  slugs       The slugs to fill if found
+             *  @param  endpoint    The endpoint to lookup
+             *  @param  accept      Callable deciding whether a matching path is used
+             *  @return The found value, or a nullptr
+             */
+            template <typename slug_container, typename acceptor>
+            const value_type* match(const node& current, slug_container& slugs, std::string_view endpoint, acceptor& accept) const
+            {
+                // the most recently added entry takes precedence
+                for (auto iter = rbegin(current.entries); iter != rend(current.entries); ++iter) {
+                    // retrieve the path and value
+                    const auto& [path, value] = _entries[*iter];
+
+                    #if defined(ROUTER_INSTRUMENTATION)
+                        // count the path being tried
+                        router::statistics::examine(*iter);
+                    #endif
+
                     // try to match the path to the given endpoint
-                    if (path.match(endpoint, slugs)) {
+                    if (path.match(endpoint, slugs) && accept(value, slugs)) {
                         // we matched the endpoint, return the handler
                         return &value;
                     }
                 }
 
-                // none of the paths matched
+                // none of the entries matched
                 return nullptr;
             }
-        private:
-            /**
-             *  The entry type we store inside the map, we store both the
-             *  path and the given value type together in a flat structure
-             */
-            using entry = std::pair<path, value_type>;
 
-            std::vector<entry>  _prefixed_paths;    // a sorted list of paths with prefixes
-            std::vector<entry>  _unsorted_paths;    // paths without a prefix, not sorted
+            std::vector<entry>                      _entries;       // all paths, in insertion order
+            static_index                            _static;        // the paths without any slugs
+            std::vector<node>                       _nodes{ 1 };    // the prefix tree, the first node is the root
+            std::optional<automaton>                _automaton;     // the compiled automaton, if any
+            std::vector<std::size_t>                _ranked;        // the entry for every path in the automaton
+            std::optional<route_cache<value_type>>  _cache;         // the cache for endpoints with slugs, if enabled
+            std::optional<frozen_index>             _frozen;        // the compact copy of the paths, if frozen
+            std::shared_ptr<matcher_registry>       _registry{ std::make_shared<matcher_registry>() };  // the registry for the slug expressions
+
+            #if defined(ROUTER_INSTRUMENTATION)
+                router::statistics                  _statistics;    // the counters for the lookups
+            #endif
     };
 
 }
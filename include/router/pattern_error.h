@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string_view>
+#include <stdexcept>
+#include <cstddef>
+#include <string>
+
+
+namespace router {
+
+    /**
+     *  Exception thrown when a path pattern is invalid
+     *
+     *  Besides the reason the pattern was rejected, this holds the
+     *  full pattern and the position of the slug that is invalid.
+     */
+    class pattern_error : public std::logic_error
+    {
+        public:
+            /**
+             *  Constructor
+             *
+             *  @param  pattern     The invalid pattern
+             *  @param  position    The position of the invalid slug in the pattern
+             *  @param  reason      The reason the slug is invalid
+             */
+            pattern_error(std::string_view pattern, std::size_t position, std::string_view reason) :
+                std::logic_error{ std::string{ reason } + " in pattern " + std::string{ pattern } + " at position " + std::to_string(position) },
+                _pattern{ pattern },
+                _position{ position }
+            {}
+
+            /**
+             *  Get the invalid pattern
+             *
+             *  @return The full pattern
+             */
+            const std::string& pattern() const noexcept
+            {
+                return _pattern;
+            }
+
+            /**
+             *  Get the position of the invalid slug
+             *
+             *  @return The offset of the slug in the pattern
+             */
+            std::size_t position() const noexcept
+            {
+                return _position;
+            }
+        private:
+            std::string _pattern;   // the invalid pattern
+            std::size_t _position;  // the position of the invalid slug
+    };
+
+}
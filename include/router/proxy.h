@@ -4,6 +4,8 @@
 #include "function_traits.h"
 #include "wrap_callback.h"
 #include "path_callback.h"
+#include "impl/proxy_storage.h"
+#include "method_set.h"
 #include <string_view>
 #include <vector>
 #include <array>
@@ -11,6 +13,20 @@
 
 namespace router {
 
+    /**
+     *  Whether proxies for a method type store only the callbacks that are set
+     *
+     *  By default, a proxy stores a callback for every method, even when only
+     *  a single one is set. With many routes, this costs a lot of memory for
+     *  methods that are never used. Specialize this for a method type to store
+     *  a byte for every method, referring to a list holding every distinct
+     *  callback only once, at the cost of an extra allocation for every proxy:
+     *
+     *  template <> constexpr bool router::sparse_proxy<http::method> = true;
+     */
+    template <typename method_type>
+    constexpr bool sparse_proxy = false;
+
     /**
      *  Undefined templated class for specializing
      *  into a function-like template class
@@ -31,19 +47,43 @@ namespace router {
              */
             using callback_type = path_callback<return_type(arguments...)>;
 
+            /**
+             *  Alias for a set of methods
+             */
+            using method_set_type = method_set<first, rest...>;
+
             /**
              *  Retrieve an installed handler
              *
              *  @param  method  The method to retrieve the handler for
-             *  @return The handler, or a nullptr if not set
+             *  @return The handler, which is invalid if not set or the method is unknown
              */
             const callback_type& get(decltype(first) method) const noexcept
             {
+                // an invalid handler, for methods that are not set
+                static const callback_type missing{};
+
                 // the index to retrieve
                 auto index = method_index(method);
 
+                // unknown methods have no handler
+                if (index == lookup::npos) {
+                    return missing;
+                }
+
                 // retrieve the callback
-                return _callbacks[index];
+                auto* callback = _callbacks.find(index);
+                return callback == nullptr ? missing : *callback;
+            }
+
+            /**
+             *  Get the methods that have a handler
+             *
+             *  @return The set of methods with a handler
+             */
+            method_set_type allowed() const noexcept
+            {
+                return method_set_type::from_bits(_callbacks.mask());
             }
 
             /**
@@ -54,16 +94,10 @@ namespace router {
              */
             template <decltype(first) method, auto callback>
             std::enable_if_t<!std::is_member_function_pointer_v<decltype(callback)>, proxy&>
-            set() noexcept
+            set() noexcept(!sparse)
             {
-                // the index to store under
-                constexpr auto index = method_index(method);
-
-                // wrap and store the callback
-                _callbacks[index].template set<callback>();
-
-                // allow chaining
-                return *this;
+                // register the callback for just this method
+                return set<callback>(method_set_type::from_bits(method_bit<method>()));
             }
 
             /**
@@ -75,28 +109,59 @@ namespace router {
              */
             template <decltype(first) method, auto callback>
             std::enable_if_t<std::is_member_function_pointer_v<decltype(callback)>, proxy&>
-            set(typename function_traits<decltype(callback)>::member_type* instance) noexcept
+            set(typename function_traits<decltype(callback)>::member_type* instance) noexcept(!sparse)
             {
-                // the index to store under
-                constexpr auto index = method_index(method);
+                // register the callback for just this method
+                return set<callback>(method_set_type::from_bits(method_bit<method>()), instance);
+            }
+
+            /**
+             *  Set up a handler for multiple methods
+             *
+             *  @tparam callback    The callback to register
+             *  @param  methods     The methods to register under, like { method::get, method::head }
+             */
+            template <auto callback>
+            std::enable_if_t<!std::is_member_function_pointer_v<decltype(callback)>, proxy&>
+            set(method_set_type methods) noexcept(!sparse)
+            {
+                // wrap the callback
+                callback_type wrapped;
+                wrapped.template set<callback>();
 
-                // wrap and store the callback
-                _callbacks[index].template set<callback>(instance);
+                // and store it for all methods
+                _callbacks.assign(methods.bits(), wrapped);
 
                 // allow chaining
                 return *this;
             }
-        private:
+
             /**
-             *  Retrieve the index for the method
-             *  in the list of methods
+             *  Set up a handler for multiple methods
              *
-             *  @param  method The method to lookup
+             *  @tparam callback    The callback to register
+             *  @param  methods     The methods to register under, like { method::get, method::head }
+             *  @param  instance    The instance to invoke the callback on
              */
-            constexpr static std::size_t method_index(decltype(first) method)
+            template <auto callback>
+            std::enable_if_t<std::is_member_function_pointer_v<decltype(callback)>, proxy&>
+            set(method_set_type methods, typename function_traits<decltype(callback)>::member_type* instance) noexcept(!sparse)
             {
-                return variadic_lookup<0, first, rest...>(method);
+                // wrap the callback
+                callback_type wrapped;
+                wrapped.template set<callback>(instance);
+
+                // and store it for all methods
+                _callbacks.assign(methods.bits(), wrapped);
+
+                // allow chaining
+                return *this;
             }
+        private:
+            /**
+             *  The lookup for the method indices
+             */
+            using lookup = variadic_index<first, rest...>;
 
             /**
              *  The number of available options, note that we
@@ -104,10 +169,43 @@ namespace router {
              */
             constexpr static std::size_t count = 1 + sizeof...(rest);
 
+            /**
+             *  Whether only the distinct callbacks that are set are stored
+             */
+            constexpr static bool sparse = sparse_proxy<decltype(first)>;
+
+            /**
+             *  Get the bit for a method that is proxied
+             *
+             *  @tparam method  The method to get the bit for
+             *  @return The bit for the method
+             */
+            template <decltype(first) method>
+            constexpr static std::uint64_t method_bit() noexcept
+            {
+                // the index of the method
+                constexpr auto index = method_index(method);
+                static_assert(index != lookup::npos, "Method is not proxied");
+
+                return std::uint64_t{ 1 } << index;
+            }
+
+            /**
+             *  Retrieve the index for the method
+             *  in the list of methods
+             *
+             *  @param  method The method to lookup
+             *  @return The index, or lookup::npos for an unknown method
+             */
+            constexpr static std::size_t method_index(decltype(first) method) noexcept
+            {
+                return lookup::find(method);
+            }
+
             /**
              *  All the registered callbacks
              */
-            std::array<callback_type, count> _callbacks{};
+            impl::proxy_storage<callback_type, count, sparse> _callbacks;
 	};
 
 }
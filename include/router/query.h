@@ -0,0 +1,224 @@
+#pragma once
+
+#include <string_view>
+#include <iterator>
+#include <optional>
+#include <cstddef>
+#include <utility>
+
+
+namespace router {
+
+    /**
+     *  A view on the query string of an endpoint
+     *
+     *  The query is not parsed up front, the parameters are only found
+     *  when they are looked up or iterated over. Nothing is copied or
+     *  allocated, the names and values refer to the endpoint, so the
+     *  endpoint must remain valid for as long as the query is used.
+     *
+     *  The names and values are given as they appear in the endpoint,
+     *  they are not percent-decoded. Parameters are separated by an
+     *  ampersand, and a parameter without an equals sign has an empty value.
+     */
+    class query
+    {
+        public:
+            /**
+             *  The type of the parameters in the query
+             */
+            using value_type = std::pair<std::string_view, std::string_view>;
+
+            /**
+             *  Iterator over the parameters in the query
+             */
+            class iterator
+            {
+                public:
+                    using iterator_category = std::forward_iterator_tag;
+                    using value_type        = query::value_type;
+                    using difference_type   = std::ptrdiff_t;
+                    using pointer           = const value_type*;
+                    using reference         = const value_type&;
+
+                    /**
+                     *  Constructor
+                     *
+                     *  @param  remaining   The data after the current parameter
+                     */
+                    explicit iterator(std::string_view remaining = {}) noexcept :
+                        _remaining{ remaining }
+                    {
+                        // find the first parameter
+                        advance();
+                    }
+
+                    /**
+                     *  Retrieve the current parameter
+                     *
+                     *  @return The name and value of the parameter
+                     */
+                    reference operator*() const noexcept   { return _current;    }
+                    pointer operator->() const noexcept    { return &_current;   }
+
+                    /**
+                     *  Move to the next parameter
+                     *
+                     *  @return Same object for chaining
+                     */
+                    iterator& operator++() noexcept
+                    {
+                        advance();
+                        return *this;
+                    }
+
+                    /**
+                     *  Move to the next parameter
+                     *
+                     *  @return The iterator before moving
+                     */
+                    iterator operator++(int) noexcept
+                    {
+                        auto result = *this;
+                        advance();
+                        return result;
+                    }
+
+                    /**
+                     *  Compare iterators
+                     *
+                     *  @param  other   The iterator to compare with
+                     *  @return Whether the iterators point to the same parameter
+                     */
+                    bool operator==(const iterator& other) const noexcept { return _current.first.data() == other._current.first.data() && _done == other._done; }
+                    bool operator!=(const iterator& other) const noexcept { return !(*this == other); }
+                private:
+                    /**
+                     *  Find the next parameter, skipping empty ones
+                     */
+                    void advance() noexcept
+                    {
+                        // skip the separators of empty parameters
+                        while (!_remaining.empty() && _remaining.front() == '&') {
+                            _remaining.remove_prefix(1);
+                        }
+
+                        // no more parameters
+                        if (_remaining.empty()) {
+                            _current    = {};
+                            _done       = true;
+                            return;
+                        }
+
+                        // the parameter runs up to the next separator
+                        auto parameter  = _remaining.substr(0, _remaining.find('&'));
+                        auto equals     = parameter.find('=');
+
+                        // split it into the name and the value
+                        if (equals == std::string_view::npos) {
+                            _current = { parameter, parameter.substr(parameter.size()) };
+                        } else {
+                            _current = { parameter.substr(0, equals), parameter.substr(equals + 1) };
+                        }
+
+                        _remaining.remove_prefix(parameter.size());
+                    }
+
+                    std::string_view    _remaining;         // the data after the current parameter
+                    value_type          _current;           // the current parameter
+                    bool                _done{ false };     // whether all parameters were visited
+            };
+
+            /**
+             *  Constructor for an empty query
+             */
+            query() = default;
+
+            /**
+             *  Constructor
+             *
+             *  @param  data    The query string, without the question mark
+             */
+            explicit query(std::string_view data) noexcept :
+                _data{ data }
+            {}
+
+            /**
+             *  Split an endpoint into the path and the query
+             *
+             *  @param  endpoint    The endpoint to split
+             *  @return The path before the question mark, and the query after it
+             */
+            static std::pair<std::string_view, query> split(std::string_view endpoint) noexcept
+            {
+                // find the start of the query
+                auto separator = endpoint.find('?');
+
+                // without a question mark there is no query
+                if (separator == std::string_view::npos) {
+                    return { endpoint, query{} };
+                }
+
+                return { endpoint.substr(0, separator), query{ endpoint.substr(separator + 1) } };
+            }
+
+            /**
+             *  Retrieve the query string
+             *
+             *  @return The query string, without the question mark
+             */
+            std::string_view data() const noexcept
+            {
+                return _data;
+            }
+
+            /**
+             *  Check whether the query has no parameters
+             *
+             *  @return Whether the query is empty
+             */
+            bool empty() const noexcept
+            {
+                return begin() == end();
+            }
+
+            /**
+             *  Find the value of a parameter
+             *
+             *  @param  name    The name of the parameter
+             *  @return The value of the first parameter with the name, if any
+             */
+            std::optional<std::string_view> find(std::string_view name) const noexcept
+            {
+                for (const auto& [key, value] : *this) {
+                    if (key == name) {
+                        return value;
+                    }
+                }
+
+                return std::nullopt;
+            }
+
+            /**
+             *  Check whether a parameter is given
+             *
+             *  @param  name    The name of the parameter
+             *  @return Whether the query contains the parameter
+             */
+            bool contains(std::string_view name) const noexcept
+            {
+                return find(name).has_value();
+            }
+
+            /**
+             *  Get iterators to the parameters
+             *
+             *  @return The iterator to the first parameter, or past the last parameter
+             */
+            iterator begin() const noexcept { return iterator{ _data }; }
+            iterator end()   const noexcept { return iterator{};        }
+        private:
+            std::string_view _data{}; // the query string, without the question mark
+    };
+
+}
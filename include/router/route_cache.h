@@ -0,0 +1,364 @@
+#pragma once
+
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+#include <array>
+#include "slug_list.h"
+
+
+namespace router {
+
+    /**
+     *  A bounded cache of recently found endpoints
+     *
+     *  The cache stores the value found for a full endpoint together with
+     *  the position of its slugs, so that a repeated lookup of the same
+     *  endpoint reads a single slot instead of matching the candidate paths
+     *  again. A hit compares the stored key with the endpoint in place, and
+     *  only reads the words holding the key and the slugs that were matched.
+     *  The cache is direct-mapped: every endpoint has exactly one slot
+     *  it can be stored in, and a newer endpoint simply replaces an older one.
+     *
+     *  Lookups and stores may happen concurrently from multiple threads. Every
+     *  slot is protected by a sequence counter, readers never wait and simply
+     *  treat a slot that is being written as a miss. Endpoints that are longer
+     *  than max_key characters are never cached.
+     *
+     *  The hits and misses are counted in a number of shards, every thread
+     *  counts in its own shard, so that threads probing the cache at the same
+     *  time do not fight over the cache line holding the counters.
+     */
+    template <typename V>
+    class route_cache
+    {
+        public:
+            using value_type = V;
+
+            /**
+             *  The longest endpoint that can be cached
+             */
+            constexpr static std::size_t max_key = 64;
+
+            /**
+             *  Constructor
+             *
+             *  @param  capacity    The number of endpoints to cache, rounded up to a power of two
+             */
+            explicit route_cache(std::size_t capacity) :
+                _mask{ round(capacity) - 1 },
+                _slots{ std::make_unique<slot[]>(_mask + 1) },
+                _counters{ std::make_unique<counters[]>(shards) }
+            {}
+
+            /**
+             *  Copy constructor, this creates an empty cache with the same
+             *  capacity, since the cached values belong to the original
+             *
+             *  @param  that    The cache to copy the capacity of
+             */
+            route_cache(const route_cache& that) :
+                route_cache{ that.capacity() }
+            {}
+
+            /**
+             *  Copy assignment, this empties the cache and takes over the capacity
+             *
+             *  @param  that    The cache to copy the capacity of
+             *  @return Same object for chaining
+             */
+            route_cache& operator=(const route_cache& that)
+            {
+                // replace the slots with empty ones
+                _mask   = that._mask;
+                _slots  = std::make_unique<slot[]>(_mask + 1);
+
+                return *this;
+            }
+
+            /**
+             *  Find an endpoint in the cache
+             *
+             *  @param  endpoint    The endpoint to find
+             *  @param  hash        The hash of the endpoint, never zero
+             *  @param  slugs       The slugs to fill if found
+             *  @return The cached value, or a nullptr
+             */
+            template <typename slug_container>
+            const value_type* find(std::string_view endpoint, std::uint64_t hash, slug_container& slugs) const noexcept
+            {
+                // long endpoints are never stored
+                if (endpoint.size() > max_key) {
+                    return nullptr;
+                }
+
+                // the slot the endpoint would be stored in
+                const auto& target = _slots[locate(hash)];
+
+                // an odd sequence means the slot is being written
+                auto sequence = target.sequence.load(std::memory_order_acquire);
+
+                // check the hash first, so most misses read a single word
+                if ((sequence & 1) != 0 || target.data[0].load(std::memory_order_relaxed) != hash) {
+                    count_miss();
+                    return nullptr;
+                }
+
+                // the value, and the size of the key with the number of slugs
+                auto value  = target.data[1].load(std::memory_order_relaxed);
+                auto header = target.data[2].load(std::memory_order_relaxed);
+                auto count  = static_cast<std::size_t>(header >> 8);
+
+                // compare the stored key with the endpoint, one word at a time, since
+                // the key is padded with zeroes we only read the words holding the key
+                bool equal{ static_cast<std::size_t>(header & 0xff) == endpoint.size() && count <= slug_list::capacity };
+
+                for (std::size_t offset{ 0 }; equal && offset < endpoint.size(); offset += sizeof(std::uint64_t)) {
+                    // the part of the endpoint in this word
+                    std::uint64_t expected{ 0 };
+                    std::memcpy(&expected, endpoint.data() + offset, std::min(sizeof expected, endpoint.size() - offset));
+
+                    equal = target.data[key_word + offset / sizeof expected].load(std::memory_order_relaxed) == expected;
+                }
+
+                // the position of every slug inside the endpoint, again only the words in use
+                std::uint64_t positions[slug_list::capacity * 2 / sizeof(std::uint64_t)];
+
+                for (std::size_t i{ 0 }; equal && i * sizeof(std::uint64_t) < 2 * count; ++i) {
+                    positions[i] = target.data[slug_word + i].load(std::memory_order_relaxed);
+                }
+
+                // what we read is only valid if the slot was not written in the meantime
+                std::atomic_thread_fence(std::memory_order_acquire);
+
+                // check that we read a consistent copy of the same endpoint
+                if (!equal || target.sequence.load(std::memory_order_relaxed) != sequence) {
+                    count_miss();
+                    return nullptr;
+                }
+
+                // restore the slugs from their offset and size
+                const auto* bytes = reinterpret_cast<const std::uint8_t*>(positions);
+
+                slugs.clear();
+
+                for (std::size_t i{ 0 }; i < count; ++i) {
+                    slugs.push_back(endpoint.substr(bytes[2 * i], bytes[2 * i + 1]));
+                }
+
+                // we found the endpoint
+                count_hit();
+                return reinterpret_cast<const value_type*>(static_cast<std::uintptr_t>(value));
+            }
+
+            /**
+             *  Store the value found for an endpoint
+             *
+             *  If another thread is storing an endpoint in the same slot, the
+             *  endpoint is not stored. This is harmless, since a cache does not
+             *  have to hold every endpoint.
+             *
+             *  @param  endpoint    The endpoint to store
+             *  @param  hash        The hash of the endpoint, never zero
+             *  @param  value       The value found for the endpoint
+             *  @param  slugs       The slugs matched from the endpoint
+             */
+            template <typename slug_container>
+            void store(std::string_view endpoint, std::uint64_t hash, const value_type* value, const slug_container& slugs) const noexcept
+            {
+                // long endpoints are never stored
+                if (endpoint.size() > max_key) {
+                    return;
+                }
+
+                // prepare the data to store
+                std::array<std::uint64_t, words> data{};
+                std::uint8_t                     positions[2 * slug_list::capacity]{};
+                std::size_t                      count{ 0 };
+
+                // the slugs are stored as their offset and size inside the endpoint
+                for (std::string_view slug : slugs) {
+                    positions[count++] = static_cast<std::uint8_t>(slug.data() - endpoint.data());
+                    positions[count++] = static_cast<std::uint8_t>(slug.size());
+                }
+
+                data[0] = hash;
+                data[1] = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(value));
+                data[2] = endpoint.size() | (count / 2) << 8;
+                std::memcpy(&data[slug_word], positions, sizeof positions);
+                std::memcpy(&data[key_word], endpoint.data(), endpoint.size());
+
+                // the slot to store the endpoint in
+                auto& target = _slots[locate(hash)];
+
+                // claim the slot by making the sequence odd, unless another thread did
+                auto sequence = target.sequence.load(std::memory_order_relaxed);
+
+                if ((sequence & 1) != 0 || !target.sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_relaxed)) {
+                    return;
+                }
+
+                // make sure readers see the odd sequence before any of the data
+                std::atomic_thread_fence(std::memory_order_release);
+
+                // write the data
+                for (std::size_t i{ 0 }; i < words; ++i) {
+                    target.data[i].store(data[i], std::memory_order_relaxed);
+                }
+
+                // and release the slot again
+                target.sequence.store(sequence + 2, std::memory_order_release);
+            }
+
+            /**
+             *  Remove all endpoints from the cache
+             *
+             *  This may not be called while other threads use the cache.
+             */
+            void clear() noexcept
+            {
+                // an empty slot has a zero hash, which is never used
+                for (std::size_t i{ 0 }; i <= _mask; ++i) {
+                    _slots[i].data[0].store(0, std::memory_order_relaxed);
+                }
+            }
+
+            /**
+             *  Get the number of endpoints the cache can hold
+             *
+             *  @return The number of slots
+             */
+            std::size_t capacity() const noexcept
+            {
+                return _mask + 1;
+            }
+
+            /**
+             *  Get the number of lookups that were found in the cache
+             *
+             *  @return The number of hits
+             */
+            std::size_t hits() const noexcept
+            {
+                // the number of hits, added up over all shards
+                std::size_t result{ 0 };
+
+                for (std::size_t i{ 0 }; i < shards; ++i) {
+                    result += _counters[i].hits.load(std::memory_order_relaxed);
+                }
+
+                return result;
+            }
+
+            /**
+             *  Get the number of lookups that were not found in the cache
+             *
+             *  @return The number of misses
+             */
+            std::size_t misses() const noexcept
+            {
+                // the number of misses, added up over all shards
+                std::size_t result{ 0 };
+
+                for (std::size_t i{ 0 }; i < shards; ++i) {
+                    result += _counters[i].misses.load(std::memory_order_relaxed);
+                }
+
+                return result;
+            }
+        private:
+            /**
+             *  The layout of the data in a slot: the hash, the value, the key
+             *  size and slug count, the slug positions and finally the key
+             */
+            constexpr static std::size_t slug_word  = 3;
+            constexpr static std::size_t key_word   = slug_word + 2 * slug_list::capacity / sizeof(std::uint64_t);
+            constexpr static std::size_t words      = key_word + max_key / sizeof(std::uint64_t);
+
+            /**
+             *  The number of shards to spread the counters over
+             */
+            constexpr static std::size_t shards = 16;
+
+            /**
+             *  The counters for a number of threads, on their own cache line
+             */
+            struct alignas(64) counters
+            {
+                std::atomic<std::size_t>    hits    {};     // the number of lookups found
+                std::atomic<std::size_t>    misses  {};     // the number of lookups not found
+            };
+
+            /**
+             *  A slot in the cache, the data is stored in atomic words
+             *  so that concurrent readers and writers do not race
+             */
+            struct alignas(64) slot
+            {
+                std::atomic<std::uint64_t>                      sequence{}; // odd while the slot is written
+                std::array<std::atomic<std::uint64_t>, words>   data{};     // the data stored in the slot
+            };
+
+            /**
+             *  Find the slot for an endpoint
+             *
+             *  @param  hash    The hash of the endpoint
+             *  @return The index of the slot
+             */
+            std::size_t locate(std::uint64_t hash) const noexcept
+            {
+                // the lowest bit of the hash is always set
+                return (hash ^ (hash >> 32)) & _mask;
+            }
+
+            /**
+             *  Get the counters for the current thread
+             *
+             *  @return The shard to count in
+             */
+            counters& shard() const noexcept
+            {
+                // the index to give to the next thread
+                static std::atomic<std::size_t> next{ 0 };
+
+                // every thread gets the next shard, wrapping around
+                // when there are more threads than shards
+                thread_local std::size_t index{ next.fetch_add(1, std::memory_order_relaxed) % shards };
+
+                return _counters[index];
+            }
+
+            /**
+             *  Count a lookup that was found, or that was not found
+             */
+            void count_hit() const noexcept     { shard().hits.fetch_add(1, std::memory_order_relaxed);     }
+            void count_miss() const noexcept    { shard().misses.fetch_add(1, std::memory_order_relaxed);   }
+
+            /**
+             *  Round the capacity up to a power of two
+             *
+             *  @param  capacity    The requested capacity
+             *  @return The capacity to use
+             */
+            static std::size_t round(std::size_t capacity) noexcept
+            {
+                // we need at least one slot
+                std::size_t result{ 1 };
+
+                while (result < capacity) {
+                    result *= 2;
+                }
+
+                return result;
+            }
+
+            std::size_t                             _mask;          // the number of slots minus one
+            std::unique_ptr<slot[]>                 _slots;         // the slots holding the endpoints
+            std::unique_ptr<counters[]>             _counters;      // the hits and misses, spread over the threads
+    };
+
+}
@@ -0,0 +1,238 @@
+#pragma once
+
+#include "path_callback.h"
+#include "impl/method_routing.h"
+#include "impl/exceptions.h"
+#include "slug_list.h"
+#include "proxy.h"
+#include "status.h"
+
+
+namespace router {
+
+    /**
+     *  Undefined templated class for specializing
+     *  into a function-like template class
+     */
+    template <class>
+    class route_match;
+
+    /**
+     *  The result of looking up an endpoint in a routing table
+     *
+     *  The match holds the callback and the slug data, so it can be invoked
+     *  at a later time, possibly on another thread. The slug data refers to
+     *  the endpoint that was matched, so the endpoint must remain valid for
+     *  as long as the match is used.
+     */
+    template <class return_type, class... arguments>
+    class route_match<return_type(arguments...)>
+    {
+        public:
+            /**
+             *  Alias for the callback type that was matched
+             */
+            using callback_type = path_callback<return_type(arguments...)>;
+
+            /**
+             *  Default constructor, creating a match
+             *  for an endpoint that was not found
+             */
+            route_match() = default;
+
+            /**
+             *  Constructor
+             *
+             *  @param  callback    The matched callback
+             *  @param  slugs       The slug data for the callback
+             */
+            route_match(const callback_type& callback, const slug_list& slugs) noexcept :
+                _callback{ callback },
+                _slugs{ slugs }
+            {}
+
+            /**
+             *  Check whether the endpoint was matched
+             *
+             *  @return Whether a valid callback was found
+             */
+            bool valid() const noexcept { return _callback.valid(); }
+            explicit operator bool() const noexcept { return valid(); }
+
+            /**
+             *  Retrieve the slug data
+             *
+             *  @return The data matched by the slugs
+             */
+            const slug_list& slugs() const noexcept
+            {
+                return _slugs;
+            }
+
+            /**
+             *  Invoke the matched callback
+             *
+             *  @param  parameters  The arguments to give to the callback
+             *  @return The result of the callback
+             *  @throws std::bad_function_call  If the endpoint was not matched
+             */
+            return_type operator()(arguments... parameters) const
+            {
+                return _callback(_slugs, std::forward<arguments>(parameters)...);
+            }
+
+            /**
+             *  Invoke the matched callback, without throwing
+             *
+             *  @param  parameters  The arguments to give to the callback
+             *  @return The result of the callback, status::not_found if the endpoint
+             *          was not matched or status::conversion_failed for invalid slugs
+             */
+            result<return_type> try_invoke(arguments... parameters) const
+            {
+                return _callback.try_call(_slugs, std::forward<arguments>(parameters)...);
+            }
+        private:
+            callback_type   _callback;  // the callback to invoke
+            slug_list       _slugs;     // the slug data for the callback
+    };
+
+    /**
+     *  The result of looking up an endpoint in a routing table with proxies
+     *
+     *  The match refers to the proxy stored in the routing table, so the table
+     *  may not be modified while the match is used. The slug data refers to the
+     *  endpoint that was matched, so the endpoint must remain valid as well.
+     */
+    template <class return_type, class... arguments, auto first, decltype(first)... rest>
+    class route_match<proxy<return_type(arguments...), first, rest...>>
+    {
+        public:
+            /**
+             *  The proxy that was matched
+             */
+            using proxy_type = proxy<return_type(arguments...), first, rest...>;
+
+            /**
+             *  The fallbacks and options method of the table the proxy was found in
+             */
+            using routing_type = impl::method_routing<first, rest...>;
+
+            /**
+             *  Default constructor, creating a match
+             *  for an endpoint that was not found
+             */
+            route_match() = default;
+
+            /**
+             *  Constructor
+             *
+             *  @param  proxy   The matched proxy
+             *  @param  slugs   The slug data for the callbacks
+             *  @param  routing The fallbacks and options method of the table, if any
+             */
+            route_match(const proxy_type* proxy, const slug_list& slugs, const routing_type* routing = nullptr) noexcept :
+                _proxy{ proxy },
+                _routing{ routing },
+                _slugs{ slugs }
+            {}
+
+            /**
+             *  Check whether the endpoint was matched
+             *
+             *  @return Whether a proxy was found
+             */
+            bool valid() const noexcept { return _proxy != nullptr; }
+            explicit operator bool() const noexcept { return valid(); }
+
+            /**
+             *  Check whether a handler is installed for the given method
+             *
+             *  @param  method  The method to check
+             *  @return Whether the endpoint was matched and the method is handled
+             */
+            bool valid(decltype(first) method) const noexcept
+            {
+                return _proxy != nullptr && _proxy->get(method).valid();
+            }
+
+            /**
+             *  Get the methods that can be routed for the endpoint
+             *
+             *  These are the methods with a handler, and for a match found in
+             *  a table, the methods with a fallback to one of those and the
+             *  method answered by the options handler. This is the same set
+             *  the not-allowed and options handlers are given.
+             *
+             *  @return The set of allowed methods, empty if the endpoint was not matched
+             */
+            typename proxy_type::method_set_type allowed() const noexcept
+            {
+                // without a proxy, nothing is allowed
+                if (_proxy == nullptr) {
+                    return typename proxy_type::method_set_type{};
+                }
+
+                return _routing != nullptr ? _routing->allowed(*_proxy) : _proxy->allowed();
+            }
+
+            /**
+             *  Retrieve the slug data
+             *
+             *  @return The data matched by the slugs
+             */
+            const slug_list& slugs() const noexcept
+            {
+                return _slugs;
+            }
+
+            /**
+             *  Invoke the callback for a method
+             *
+             *  @param  method      The method to invoke the callback for
+             *  @param  parameters  The arguments to give to the callback
+             *  @return The result of the callback
+             *  @throws std::bad_function_call  If the endpoint was not matched or the method is not handled
+             */
+            return_type operator()(decltype(first) method, arguments... parameters) const
+            {
+                // we need a proxy to invoke anything
+                if (_proxy == nullptr) {
+                    impl::fail<std::bad_function_call>();
+                }
+
+                return _proxy->get(method)(_slugs, std::forward<arguments>(parameters)...);
+            }
+
+            /**
+             *  Invoke the callback for a method, without throwing
+             *
+             *  @param  method      The method to invoke the callback for
+             *  @param  parameters  The arguments to give to the callback
+             *  @return The result of the callback, status::not_found if the endpoint was not
+             *          matched, status::method_not_allowed if the method is not handled or
+             *          status::conversion_failed for invalid slugs
+             */
+            result<return_type> try_invoke(decltype(first) method, arguments... parameters) const
+            {
+                // we need a proxy to invoke anything
+                if (_proxy == nullptr) {
+                    return status::not_found;
+                }
+
+                // and a handler for the method
+                const auto& callback = _proxy->get(method);
+
+                if (!callback.valid()) {
+                    return status::method_not_allowed;
+                }
+
+                return callback.try_call(_slugs, std::forward<arguments>(parameters)...);
+            }
+        private:
+            const proxy_type*   _proxy{};   // the matched proxy
+            const routing_type* _routing{}; // the fallbacks and options method of the table
+            slug_list           _slugs;     // the slug data for the callbacks
+    };
+
+}
@@ -0,0 +1,450 @@
+#pragma once
+
+#include <string_view>
+#include <algorithm>
+#include <optional>
+#include <cctype>
+#include <cstdint>
+#include <limits>
+#include <array>
+
+
+namespace router {
+
+    /**
+     *  A scanner for simple slug patterns
+     *
+     *  Many slugs consist of nothing more than a single character class
+     *  with an optional repetition, like \d+, \w+, [^/]+ or [0-9a-f]{24}.
+     *  These can be matched by testing each character against a bitmap,
+     *  which is a lot cheaper than running a regular expression. The
+     *  scanner gives exactly the same results as an anchored, greedy
+     *  regular expression match would.
+     */
+    class scanner
+    {
+        public:
+            /**
+             *  Value for a repetition without upper bound
+             */
+            constexpr static std::size_t unbounded = std::numeric_limits<std::size_t>::max();
+
+            /**
+             *  Try to create a scanner for a regular expression
+             *
+             *  @param  expression  The regular expression to convert
+             *  @return The scanner, or nothing if the expression is too complex
+             */
+            static std::optional<scanner> parse(std::string_view expression) noexcept
+            {
+                // the scanner to fill
+                scanner result{};
+
+                // the expression starts with the character class
+                if (!result.parse_atom(expression)) {
+                    return std::nullopt;
+                }
+
+                // followed by an optional repetition
+                if (!result.parse_repetition(expression)) {
+                    return std::nullopt;
+                }
+
+                // there may be no trailing data (like a lazy quantifier)
+                if (!expression.empty()) {
+                    return std::nullopt;
+                }
+
+                return result;
+            }
+
+            /**
+             *  Check whether a character is in the character class
+             *
+             *  @param  character   The character to test
+             *  @return Whether the character is matched
+             */
+            bool test(char character) const noexcept
+            {
+                auto value = static_cast<unsigned char>(character);
+                return (_bitmap[value / 64] >> (value % 64)) & 1;
+            }
+
+            /**
+             *  Get the minimum number of characters to match
+             *
+             *  @return The minimum repetition count
+             */
+            std::size_t min() const noexcept
+            {
+                return _min;
+            }
+
+            /**
+             *  Get the maximum number of characters to match
+             *
+             *  @return The maximum repetition count, or unbounded
+             */
+            std::size_t max() const noexcept
+            {
+                return _max;
+            }
+
+            /**
+             *  Match the scanner against the start of the given input
+             *
+             *  @param  input   The input to test
+             *  @param  output  Set to the matched data
+             *  @return Whether the input matched the scanner
+             */
+            bool match(std::string_view& input, std::string_view& output) const noexcept
+            {
+                // we never consume more than we are allowed to
+                std::size_t limit { std::min(_max, input.size())    };
+                std::size_t count { 0                               };
+
+                // consume as many characters from the class as possible
+                while (count < limit && test(input[count])) {
+                    ++count;
+                }
+
+                // did we match enough characters?
+                if (count < _min) {
+                    return false;
+                }
+
+                // store the match and consume it from the input
+                output = input.substr(0, count);
+                input.remove_prefix(count);
+                return true;
+            }
+        private:
+            /**
+             *  Add a range of characters to the class
+             *
+             *  @param  first   The first character to add
+             *  @param  last    The last character to add (inclusive)
+             */
+            void add(unsigned char first, unsigned char last) noexcept
+            {
+                for (unsigned value = first; value <= last; ++value) {
+                    _bitmap[value / 64] |= std::uint64_t{ 1 } << (value % 64);
+                }
+            }
+
+            /**
+             *  Add all characters from another class
+             *
+             *  @param  other   The class to add
+             */
+            void add(const std::array<std::uint64_t, 4>& other) noexcept
+            {
+                for (std::size_t i{ 0 }; i < _bitmap.size(); ++i) {
+                    _bitmap[i] |= other[i];
+                }
+            }
+
+            /**
+             *  Invert the character class
+             */
+            void invert() noexcept
+            {
+                for (auto& word : _bitmap) {
+                    word = ~word;
+                }
+            }
+
+            /**
+             *  Retrieve the class for a class escape (like \d or \W)
+             *
+             *  @param  escape  The character following the backslash
+             *  @param  output  The class to fill
+             *  @return Whether the escape is a class escape
+             */
+            static bool class_escape(char escape, std::array<std::uint64_t, 4>& output) noexcept
+            {
+                // the class to build
+                scanner result{};
+
+                // the uppercase escapes are the inverse of the lowercase ones
+                switch (escape) {
+                    case 'd':
+                    case 'D':
+                        result.add('0', '9');
+                        break;
+                    case 'w':
+                    case 'W':
+                        result.add('0', '9');
+                        result.add('A', 'Z');
+                        result.add('a', 'z');
+                        result.add('_', '_');
+                        break;
+                    case 's':
+                    case 'S':
+                        result.add('\t', '\r');
+                        result.add(' ', ' ');
+                        break;
+                    default:
+                        return false;
+                }
+
+                // invert the uppercase variants
+                if (escape == 'D' || escape == 'W' || escape == 'S') {
+                    result.invert();
+                }
+
+                output = result._bitmap;
+                return true;
+            }
+
+            /**
+             *  Check whether a character may be used as a literal
+             *
+             *  We only accept printable ascii characters, everything
+             *  else is left to the regular expression engine.
+             *
+             *  @param  character   The character to check
+             *  @return Whether it is a simple literal character
+             */
+            static bool literal(char character) noexcept
+            {
+                return character >= ' ' && character <= '~';
+            }
+
+            /**
+             *  Parse the character class at the start of the expression
+             *
+             *  @param  expression  The expression, the atom is consumed from the input
+             *  @return Whether a supported class was found
+             */
+            bool parse_atom(std::string_view& expression) noexcept
+            {
+                // we need at least a single character
+                if (expression.empty()) {
+                    return false;
+                }
+
+                // the class for escaped data
+                std::array<std::uint64_t, 4> escaped{};
+
+                switch (expression.front()) {
+                    case '.':
+                        // everything except line terminators
+                        add(0, 255);
+                        _bitmap['\n' / 64] &= ~(std::uint64_t{ 1 } << '\n');
+                        _bitmap['\r' / 64] &= ~(std::uint64_t{ 1 } << '\r');
+                        expression.remove_prefix(1);
+                        return true;
+                    case '\\':
+                        // only class escapes are supported outside a bracket
+                        if (expression.size() < 2 || !class_escape(expression[1], escaped)) {
+                            return false;
+                        }
+
+                        add(escaped);
+                        expression.remove_prefix(2);
+                        return true;
+                    case '[':
+                        expression.remove_prefix(1);
+                        return parse_bracket(expression);
+                    default:
+                        return false;
+                }
+            }
+
+            /**
+             *  Parse a bracketed character class, the opening
+             *  bracket must already be consumed from the input
+             *
+             *  @param  expression  The expression, the class is consumed from the input
+             *  @return Whether a supported class was found
+             */
+            bool parse_bracket(std::string_view& expression) noexcept
+            {
+                // is the class inverted?
+                bool inverted = !expression.empty() && expression.front() == '^';
+
+                // consume the inversion character
+                if (inverted) {
+                    expression.remove_prefix(1);
+                }
+
+                // empty classes are left to the regular expression engine
+                if (expression.empty() || expression.front() == ']') {
+                    return false;
+                }
+
+                // process all elements until the closing bracket
+                while (!expression.empty() && expression.front() != ']') {
+                    // the first character of a possible range
+                    char first{};
+
+                    // is the character escaped?
+                    if (expression.front() == '\\') {
+                        // we need the escaped character
+                        if (expression.size() < 2) {
+                            return false;
+                        }
+
+                        // the class for escaped data
+                        std::array<std::uint64_t, 4> escaped{};
+
+                        // is it a class escape?
+                        if (class_escape(expression[1], escaped)) {
+                            // add the class and continue
+                            add(escaped);
+                            expression.remove_prefix(2);
+                            continue;
+                        }
+
+                        // escaped letters and digits have a special meaning
+                        if (!literal(expression[1]) || std::isalnum(static_cast<unsigned char>(expression[1]))) {
+                            return false;
+                        }
+
+                        first = expression[1];
+                        expression.remove_prefix(2);
+                    } else if (literal(expression.front())) {
+                        // a regular literal character
+                        first = expression.front();
+                        expression.remove_prefix(1);
+                    } else {
+                        // not a character we support
+                        return false;
+                    }
+
+                    // is this the start of a range? a dash before the closing bracket is a literal
+                    if (expression.size() >= 2 && expression[0] == '-' && expression[1] != ']') {
+                        // the last character must be a simple literal
+                        char last = expression[1];
+
+                        if (last == '\\' || !literal(last) || last < first) {
+                            return false;
+                        }
+
+                        add(first, last);
+                        expression.remove_prefix(2);
+                    } else {
+                        // a single character
+                        add(first, first);
+                    }
+                }
+
+                // the class must be closed
+                if (expression.empty()) {
+                    return false;
+                }
+
+                // consume the closing bracket
+                expression.remove_prefix(1);
+
+                // invert the class if requested
+                if (inverted) {
+                    invert();
+                }
+
+                return true;
+            }
+
+            /**
+             *  Parse a decimal number
+             *
+             *  @param  expression  The expression, the number is consumed from the input
+             *  @param  output      The parsed number
+             *  @return Whether a valid number was found
+             */
+            static bool parse_number(std::string_view& expression, std::size_t& output) noexcept
+            {
+                // the number of digits parsed
+                std::size_t digits{ 0 };
+                output = 0;
+
+                // parse digits, but keep the value within sane limits
+                while (digits < expression.size() && expression[digits] >= '0' && expression[digits] <= '9') {
+                    // we do not support overly large repetitions
+                    if (output > 100000) {
+                        return false;
+                    }
+
+                    output = output * 10 + static_cast<std::size_t>(expression[digits++] - '0');
+                }
+
+                // consume the digits
+                expression.remove_prefix(digits);
+                return digits > 0;
+            }
+
+            /**
+             *  Parse the repetition following the character class
+             *
+             *  @param  expression  The expression, the repetition is consumed from the input
+             *  @return Whether the repetition is supported
+             */
+            bool parse_repetition(std::string_view& expression) noexcept
+            {
+                // without a repetition the class matches a single character
+                if (expression.empty()) {
+                    _min = _max = 1;
+                    return true;
+                }
+
+                switch (expression.front()) {
+                    case '+':
+                        _min = 1;
+                        _max = unbounded;
+                        expression.remove_prefix(1);
+                        return true;
+                    case '*':
+                        _min = 0;
+                        _max = unbounded;
+                        expression.remove_prefix(1);
+                        return true;
+                    case '?':
+                        _min = 0;
+                        _max = 1;
+                        expression.remove_prefix(1);
+                        return true;
+                    case '{':
+                        break;
+                    default:
+                        return false;
+                }
+
+                // consume the opening brace and read the minimum
+                expression.remove_prefix(1);
+                if (!parse_number(expression, _min) || expression.empty()) {
+                    return false;
+                }
+
+                // is a maximum given as well?
+                if (expression.front() == ',') {
+                    // consume the separator
+                    expression.remove_prefix(1);
+
+                    // the maximum may be omitted
+                    if (!expression.empty() && expression.front() == '}') {
+                        _max = unbounded;
+                    } else if (!parse_number(expression, _max)) {
+                        return false;
+                    }
+                } else {
+                    // exact repetition count
+                    _max = _min;
+                }
+
+                // the repetition must be properly closed and valid
+                if (expression.empty() || expression.front() != '}' || _max < _min) {
+                    return false;
+                }
+
+                // consume the closing brace
+                expression.remove_prefix(1);
+                return true;
+            }
+
+            std::array<std::uint64_t, 4>    _bitmap {};     // the characters in the class
+            std::size_t                     _min    {};     // the minimum number of characters
+            std::size_t                     _max    {};     // the maximum number of characters
+    };
+
+}
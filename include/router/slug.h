@@ -2,7 +2,14 @@
 
 #include <string_view>
 #include <stdexcept>
+#include <optional>
+#include <memory>
 #include <regex>
+#include "matcher_registry.h"
+#include "statistics.h"
+#include "slug_type.h"
+#include "scanner.h"
+#include "impl/exceptions.h"
 
 
 namespace router {
@@ -17,72 +24,81 @@ namespace router {
             /**
              *  Constructor
              *
-             *  @param  pattern The slug pattern, the pattern is consumed from the input
+             *  The slug may start with a maximum length, between an asterisk
+             *  and a colon, like {*64:[^/]+}, in which case the slug never
+             *  looks at more than the given number of characters.
+             *
+             *  @param  pattern     The slug pattern, the pattern is consumed from the input
+             *  @param  registry    The registry to share the regular expression with, if any
              */
-            slug(std::string_view& pattern)
+            slug(std::string_view& pattern, matcher_registry* registry = nullptr)
             {
                 // the pattern must include the slug opening character
                 if (pattern.empty() || pattern[0] != '{') {
                     // not a valid slug pattern, does not start with an opening brace
-                    throw std::logic_error{ "Missing slug opening character" };
+                    impl::fail<std::logic_error>("Missing slug opening character");
                 }
 
-                // track whether the last character was an escape character
-                // and how many levels of curly braces we have entered
-                bool        last_char_was_escape    { false };
-                std::size_t brace_nesting_level     { 0     };
+                // find the expression between the braces
+                auto expression = extract(pattern);
 
-                // read all characters until we hit the slug end
-                for (std::size_t i{ 0 }; i < pattern.size(); ++i) {
-                    // did we find an escape character?
-                    if (pattern[i] == '\\') {
-                        // if the previous character was also an escape character
-                        // then we escaped the escape character (to get a literal
-                        // backslash), so we need to flip the state back to false
-                        // otherwise it's set to true.
-                        last_char_was_escape = !last_char_was_escape;
-                        continue;
-                    }
+                // check if the slug was properly closed
+                if (!expression) {
+                    // there are more opening braces than closing
+                    // braces, which means the pattern does not contain
+                    // the closing brace, we cannot create the regex
+                    impl::fail<std::logic_error>("Unterminated slug, missing closing curly brace");
+                }
 
-                    // escaped characters aren't checked, they do not change the
-                    // brace nesting level, so we can skip further processing
-                    if (last_char_was_escape) {
-                        last_char_was_escape = false;
-                        continue;
-                    }
+                // extract the optional maximum length
+                _max_length = parse_max_length(*expression);
 
-                    // did we find another curly brace character?
-                    if (pattern[i] == '{') {
-                        // increase nesting level
-                        ++brace_nesting_level;
-                    } else if (pattern[i] == '}') {
-                        // decrease nesting level
-                        --brace_nesting_level;
+                // typed slugs are checked while matching, the ones that
+                // are a simple character class get a scanner for that,
+                // so they can still be compiled into an automaton
+                if (_type = slug_type::parse(*expression); _type) {
+                    if (_type->type() == slug_type::kind::segment) {
+                        _scanner = scanner::parse("[^/]+");
+                    } else if (_type->type() == slug_type::kind::hex) {
+                        _scanner = scanner::parse("[0-9a-fA-F]+");
                     }
+                } else if (_scanner = scanner::parse(*expression); !_scanner) {
+                    // simple patterns get a dedicated scanner, only
+                    // more complex patterns require a regular expression,
+                    // which is shared with other slugs through the registry
+                    _pattern = registry != nullptr ? registry->expression(*expression) : std::make_shared<const std::regex>(begin(*expression), end(*expression));
+                }
+            }
 
-                    // did we find the final, closing slug character?
-                    if (brace_nesting_level == 0) {
-                        // to get the regular expression we ignore the first
-                        // character from the pattern (the opening {) and the
-                        // final closing character (the })
-                        auto expression = pattern.substr(1, i - 1);
-
-                        // initialize the regex and consume the data
-                        _pattern.assign(begin(expression), end(expression));
-                        pattern.remove_prefix(i + 1);
+            /**
+             *  Find the regular expression a slug needs, without compiling it
+             *
+             *  This allows compiling the expressions ahead of creating the
+             *  slugs, for example on other threads. Slugs with a type or a
+             *  scanner do not need a regular expression.
+             *
+             *  @param  pattern     The slug pattern, the pattern is consumed from the input
+             *  @return The regular expression, or std::nullopt if none is needed or the slug is invalid
+             */
+            static std::optional<std::string_view> regular_expression(std::string_view& pattern) noexcept
+            {
+                // find the expression between the braces
+                auto expression = pattern.empty() || pattern[0] != '{' ? std::nullopt : extract(pattern);
 
-                        // the slug is complete, stop processing data
-                        break;
-                    }
+                // an invalid slug is reported when it is created
+                if (!expression) {
+                    return std::nullopt;
                 }
 
-                // check if the slug was properly closed
-                if (brace_nesting_level > 0) {
-                    // there are more opening braces than closing
-                    // braces, which means the pattern does not contain
-                    // the closing brace, we cannot create the regex
-                    throw std::logic_error{ "Unterminated slug, missing closing curly brace" };
+                // the maximum length is not part of the regular expression
+                parse_max_length(*expression);
+
+                // typed slugs and simple patterns do not need a regular expression
+                if (slug_type::parse(*expression) || scanner::parse(*expression)) {
+                    return std::nullopt;
                 }
+
+                return expression;
             }
 
             /**
@@ -94,25 +110,91 @@ namespace router {
              */
             bool match(std::string_view& input, std::string_view& output) const
             {
-                // the match results to use
-                using match_results = std::match_results<std::string_view::const_iterator>;
+                // the value is not needed
+                slug_value value;
 
-                // search the input and get the results
-                match_results   matches {                                                                   };
-                bool            matched { std::regex_search(begin(input), end(input), matches, _pattern)    };
+                return match(input, output, value);
+            }
 
-                // did we find a match and did it occur at the start of the input?
-                if (matched && matches.position(0) == 0) {
-                    // store the match in the output
-                    output = input.substr(0, matches.length(0));
+            /**
+             *  Match the slug against the given input, and get its value
+             *
+             *  @param  input   The input to test
+             *  @param  output  Set to the matched data
+             *  @param  value   Set to the converted value, for typed numbers
+             *  @return Whether the input matched the slug pattern
+             */
+            bool match(std::string_view& input, std::string_view& output, slug_value& value) const
+            {
+                // we never look beyond the maximum length
+                std::string_view bounded{ input.substr(0, _max_length) };
+
+                // use the scanner if we have one
+                if (_scanner) {
+                    if (!_scanner->match(bounded, output)) {
+                        return false;
+                    }
+                } else if (_type) {
+                    // check the value while matching it
+                    if (!_type->match(bounded, output, value)) {
+                        return false;
+                    }
+                } else {
+                    #if defined(ROUTER_INSTRUMENTATION)
+                        // count the expression for the route being tried
+                        statistics::regex_timer timer;
+                    #endif
+
+                    // the match results to use
+                    using match_results = std::match_results<std::string_view::const_iterator>;
 
-                    // consume the matched input
-                    input.remove_prefix(output.size());
-                    return true;
+                    // the match must start at the beginning of the input, so we only
+                    // try that position instead of searching the whole remainder
+                    match_results   matches {};
+                    bool            matched { std::regex_search(begin(bounded), end(bounded), matches, *_pattern, std::regex_constants::match_continuous) };
+
+                    // did we find a match?
+                    if (!matched) {
+                        return false;
+                    }
+
+                    // store the match in the output
+                    output = bounded.substr(0, matches.length(0));
                 }
 
-                // no match found, or the match was not at the start of the input
-                return false;
+                // consume the matched input
+                input.remove_prefix(output.size());
+                return true;
+            }
+
+            /**
+             *  Get the scanner used for matching the slug
+             *
+             *  @return The scanner, or a nullptr if a regular expression is used
+             */
+            const scanner* matcher() const noexcept
+            {
+                return _scanner ? &*_scanner : nullptr;
+            }
+
+            /**
+             *  Get the type of a typed slug, like {id:int}
+             *
+             *  @return The type, or a nullptr if the slug uses a regular expression
+             */
+            const slug_type* type() const noexcept
+            {
+                return _type ? &*_type : nullptr;
+            }
+
+            /**
+             *  Get the maximum number of characters the slug looks at
+             *
+             *  @return The maximum length, or std::string_view::npos if unbounded
+             */
+            std::size_t max_length() const noexcept
+            {
+                return _max_length;
             }
 
             /**
@@ -150,7 +232,107 @@ namespace router {
                 return position;
             }
         private:
-            std::regex  _pattern;   // the pattern to match for this slug
+            /**
+             *  Extract the expression of a slug, starting at the opening brace
+             *
+             *  @param  pattern     The slug pattern, the slug is consumed from the input
+             *  @return The expression between the braces, or std::nullopt if the slug is not closed
+             */
+            static std::optional<std::string_view> extract(std::string_view& pattern) noexcept
+            {
+                // track whether the last character was an escape character
+                // and how many levels of curly braces we have entered
+                bool        last_char_was_escape    { false };
+                std::size_t brace_nesting_level     { 0     };
+
+                // read all characters until we hit the slug end
+                for (std::size_t i{ 0 }; i < pattern.size(); ++i) {
+                    // did we find an escape character?
+                    if (pattern[i] == '\\') {
+                        // if the previous character was also an escape character
+                        // then we escaped the escape character (to get a literal
+                        // backslash), so we need to flip the state back to false
+                        // otherwise it's set to true.
+                        last_char_was_escape = !last_char_was_escape;
+                        continue;
+                    }
+
+                    // escaped characters aren't checked, they do not change the
+                    // brace nesting level, so we can skip further processing
+                    if (last_char_was_escape) {
+                        last_char_was_escape = false;
+                        continue;
+                    }
+
+                    // did we find another curly brace character?
+                    if (pattern[i] == '{') {
+                        // increase nesting level
+                        ++brace_nesting_level;
+                    } else if (pattern[i] == '}') {
+                        // decrease nesting level
+                        --brace_nesting_level;
+                    }
+
+                    // did we find the final, closing slug character?
+                    if (brace_nesting_level == 0) {
+                        // to get the regular expression we ignore the first
+                        // character from the pattern (the opening {) and the
+                        // final closing character (the })
+                        auto expression = pattern.substr(1, i - 1);
+
+                        // consume the data
+                        pattern.remove_prefix(i + 1);
+                        return expression;
+                    }
+                }
+
+                // the slug is never closed
+                return std::nullopt;
+            }
+
+            /**
+             *  Extract the maximum length from the start of an expression
+             *
+             *  The length is given as an asterisk, the digits and a colon, like
+             *  *64: in front of the expression. A regular expression can never
+             *  start with an asterisk, since there is nothing for it to repeat,
+             *  so this is never confused with an expression.
+             *
+             *  @param  expression  The expression, the length is consumed from the input
+             *  @return The maximum length, or std::string_view::npos if none is given
+             */
+            static std::size_t parse_max_length(std::string_view& expression) noexcept
+            {
+                // find the end of the length specification
+                auto end = expression.find(':');
+
+                // the length must be given between the asterisk and the colon
+                if (expression.empty() || expression.front() != '*' || end == std::string_view::npos || end == 1) {
+                    return std::string_view::npos;
+                }
+
+                // the length in between
+                std::size_t length{ 0 };
+
+                // parse the digits, if anything else is found the
+                // expression is left alone, and fails to compile
+                for (std::size_t i{ 1 }; i < end; ++i) {
+                    if (expression[i] < '0' || expression[i] > '9' || length > std::string_view::npos / 10 - 9) {
+                        return std::string_view::npos;
+                    }
+
+                    length = length * 10 + static_cast<std::size_t>(expression[i] - '0');
+                }
+
+                // consume the specification
+                expression.remove_prefix(end + 1);
+                return length;
+            }
+
+            std::size_t                         _max_length { std::string_view::npos }; // the maximum number of characters to match
+            std::optional<scanner>              _scanner;                               // the scanner for simple patterns
+            std::optional<slug_type>            _type;                                  // the type for typed slugs
+            std::shared_ptr<const std::regex>   _pattern;                               // the pattern to match for this slug, if no scanner is available
     };
 
 }
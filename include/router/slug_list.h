@@ -0,0 +1,264 @@
+#pragma once
+
+#include <string_view>
+#include <iterator>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <bitset>
+#include <array>
+#include "slug_value.h"
+#include "query.h"
+
+
+namespace router {
+
+    /**
+     *  A fixed-capacity list of matched slug data
+     *
+     *  The list never allocates, all slugs are stored inline as offset
+     *  and length pairs, relative to the first slug that was added. This
+     *  means that all slugs must refer to the same underlying buffer,
+     *  which is the case for slugs matched from a single endpoint.
+     *
+     *  The list also holds the query string that followed the path
+     *  in the endpoint, for callbacks that take the query as well.
+     *
+     *  Slugs are stored as they appear in the endpoint, percent-escapes
+     *  are only looked for when the slugs are converted for a callback.
+     *
+     *  Typed slugs, like {id:int}, are stored with the value they were
+     *  converted to while matching, so it need not be parsed again. Only
+     *  room for a few values is kept, since paths rarely have more typed
+     *  numbers than that, any others are parsed from their data instead.
+     */
+    class slug_list
+    {
+        public:
+            /**
+             *  The maximum number of slugs a path may contain
+             */
+            constexpr static std::size_t capacity = 16;
+
+            /**
+             *  The maximum number of values of typed slugs that are stored
+             */
+            constexpr static std::size_t value_capacity = 4;
+
+            /**
+             *  The type of the elements in the list
+             */
+            using value_type = std::string_view;
+
+            /**
+             *  Iterator over the slugs in the list
+             */
+            class iterator
+            {
+                public:
+                    using iterator_category = std::forward_iterator_tag;
+                    using value_type        = std::string_view;
+                    using difference_type   = std::ptrdiff_t;
+                    using pointer           = void;
+                    using reference         = std::string_view;
+
+                    /**
+                     *  Constructor
+                     *
+                     *  @param  list    The list to iterate over
+                     *  @param  index   The index of the slug to start at
+                     */
+                    iterator(const slug_list* list, std::size_t index) noexcept :
+                        _list{ list },
+                        _index{ index }
+                    {}
+
+                    /**
+                     *  Retrieve the current slug
+                     *
+                     *  @return The slug data
+                     */
+                    std::string_view operator*() const noexcept
+                    {
+                        return (*_list)[_index];
+                    }
+
+                    /**
+                     *  Move to the next slug
+                     *
+                     *  @return Same object for chaining
+                     */
+                    iterator& operator++() noexcept
+                    {
+                        ++_index;
+                        return *this;
+                    }
+
+                    /**
+                     *  Move to the next slug
+                     *
+                     *  @return The iterator before moving
+                     */
+                    iterator operator++(int) noexcept
+                    {
+                        auto result = *this;
+                        ++_index;
+                        return result;
+                    }
+
+                    /**
+                     *  Compare iterators
+                     *
+                     *  @param  other   The iterator to compare with
+                     *  @return Whether the iterators point to the same slug
+                     */
+                    bool operator==(const iterator& other) const noexcept { return _index == other._index; }
+                    bool operator!=(const iterator& other) const noexcept { return _index != other._index; }
+                private:
+                    const slug_list*    _list;  // the list we iterate over
+                    std::size_t         _index; // the current index into the list
+            };
+
+            /**
+             *  Remove all slugs from the list, the query is kept
+             */
+            void clear() noexcept
+            {
+                _size   = 0;
+                _kinds  = 0;
+            }
+
+            /**
+             *  Add a slug to the list
+             *
+             *  The list must not be full, which is guaranteed for slugs
+             *  matched by a path, since paths cannot have more slugs.
+             *
+             *  @param  slug    The slug data to add
+             *  @param  value   The value the slug was converted to, if any
+             */
+            void push_back(std::string_view slug, slug_value value = {}) noexcept
+            {
+                // the first slug determines the base for the offsets
+                if (_size == 0) {
+                    _base = slug.data();
+                }
+
+                // store the value, if there is one and there is still room for it
+                if (value.type() != slug_value::kind::none) {
+                    if (auto slot = values(_size); slot < value_capacity) {
+                        _kinds          |= static_cast<std::uint32_t>(value.type()) << (2 * _size);
+                        _values[slot]    = value.bits();
+                    }
+                }
+
+                // store the slug relative to the base
+                _slugs[_size++] = { static_cast<std::uint32_t>(slug.data() - _base), static_cast<std::uint32_t>(slug.size()) };
+            }
+
+            /**
+             *  Get the number of slugs in the list
+             *
+             *  @return The number of slugs
+             */
+            std::size_t size() const noexcept
+            {
+                return _size;
+            }
+
+            /**
+             *  Check whether the list is empty
+             *
+             *  @return Whether the list contains no slugs
+             */
+            bool empty() const noexcept
+            {
+                return _size == 0;
+            }
+
+            /**
+             *  Retrieve a slug from the list
+             *
+             *  @param  index   The index of the slug
+             *  @return The slug data
+             */
+            std::string_view operator[](std::size_t index) const noexcept
+            {
+                return { _base + _slugs[index].first, _slugs[index].second };
+            }
+
+            /**
+             *  Retrieve the value of a slug
+             *
+             *  @param  index   The index of the slug
+             *  @return The value the slug was converted to, which has no kind for untyped slugs
+             */
+            slug_value value(std::size_t index) const noexcept
+            {
+                // the kind of value, two bits for every slug
+                auto type = static_cast<slug_value::kind>((_kinds >> (2 * index)) & 3);
+
+                // the values are stored in the order of their slugs
+                return { type, type == slug_value::kind::none ? 0 : _values[values(index)] };
+            }
+
+            /**
+             *  Get iterators to the slugs
+             *
+             *  @return The iterator to the first slug, or past the last slug
+             */
+            iterator begin() const noexcept { return { this, 0      }; }
+            iterator end()   const noexcept { return { this, _size  }; }
+
+            /**
+             *  Set the query that followed the path
+             *
+             *  @param  parameters  The query of the endpoint
+             */
+            void set_query(router::query parameters) noexcept
+            {
+                _query = parameters;
+            }
+
+            /**
+             *  Retrieve the query that followed the path
+             *
+             *  @return The query, which is empty if the endpoint had none
+             */
+            router::query query() const noexcept
+            {
+                return _query;
+            }
+        private:
+            /**
+             *  Count the stored values for the slugs before a slug
+             *
+             *  @param  index   The index of the slug
+             *  @return The number of values stored before it
+             */
+            std::size_t values(std::size_t index) const noexcept
+            {
+                // a bit for every slug that has a value, below the index
+                std::uint32_t stored{ (_kinds | (_kinds >> 1)) & 0x55555555u & ((std::uint32_t{ 1 } << (2 * index)) - 1) };
+
+                return std::bitset<32>{ stored }.count();
+            }
+
+            const char*                                                     _base   {}; // the data all slugs are relative to
+            std::array<std::pair<std::uint32_t, std::uint32_t>, capacity>   _slugs  {}; // the offset and size of every slug
+            std::uint32_t                                                   _size   {}; // the number of slugs stored
+            std::uint32_t                                                   _kinds  {}; // the kind of value of every slug, two bits each
+            std::array<std::uint64_t, value_capacity>                       _values {}; // the values of the first typed slugs
+            router::query                                                   _query  {}; // the query following the path
+    };
+
+    /**
+     *  Get iterators to the slugs
+     *
+     *  @param  list    The list to iterate over
+     *  @return The iterator to the first slug, or past the last slug
+     */
+    inline slug_list::iterator begin(const slug_list& list) noexcept { return list.begin();   }
+    inline slug_list::iterator end(const slug_list& list)   noexcept { return list.end();     }
+
+}
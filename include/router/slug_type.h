@@ -0,0 +1,416 @@
+#pragma once
+
+#include <string_view>
+#include <optional>
+#include <charconv>
+#include <system_error>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <array>
+#include "impl/from_chars.h"
+#include "slug_value.h"
+
+
+namespace router {
+
+    /**
+     *  A slug with a built-in type, like {id:int} or {name:segment}
+     *
+     *  Instead of a regular expression, these slugs give a name and a type,
+     *  separated by a colon. The type is checked while matching, so a value
+     *  that does not fit the type, like a number that is out of range, does
+     *  not match the route at all. The supported types are:
+     *
+     *  int, int8, int16, int32, int64      a signed integer, int is as wide as a C++ int
+     *  uint, uint8, uint16, uint32, uint64 an unsigned integer, uint is as wide as a C++ unsigned
+     *  float                               a finite decimal floating point number
+     *  segment                             anything up to the next slash
+     *  hex                                 one or more hexadecimal digits
+     *  uuid                                a uuid, in its 8-4-4-4-12 form
+     *
+     *  The numbers are converted while checking them, and the value
+     *  is given with the match, so callbacks need not parse it again.
+     *
+     *  An expression with a name, followed by anything else than one of
+     *  these types, like {a:b}, remains a regular expression.
+     */
+    class slug_type
+    {
+        public:
+            /**
+             *  The kinds of slugs
+             */
+            enum class kind : std::uint8_t
+            {
+                integer,    // a signed or unsigned integer, within the bounds
+                floating,   // a decimal floating point number
+                segment,    // a path segment, up to the next slash
+                hex,        // hexadecimal digits
+                uuid        // a uuid, with dashes
+            };
+
+            /**
+             *  Try to parse a typed slug expression
+             *
+             *  @param  expression  The expression, without the braces
+             *  @return The slug type, or nothing if the expression is not a name followed by a type
+             */
+            static std::optional<slug_type> parse(std::string_view expression)
+            {
+                // the name comes before the colon
+                auto colon = expression.find(':');
+
+                // without a valid name the expression is a regular expression
+                if (colon == std::string_view::npos || !identifier(expression.substr(0, colon))) {
+                    return std::nullopt;
+                }
+
+                // the type comes after it
+                auto type = expression.substr(colon + 1);
+
+                // the types with their bounds
+                struct definition
+                {
+                    std::string_view    name;   // the name of the type
+                    kind                type;   // the kind of slug
+                    std::int64_t        min;    // the smallest integer allowed
+                    std::uint64_t       max;    // the largest integer allowed
+                };
+
+                constexpr std::array<definition, 14> definitions{ {
+                    { "int",        kind::integer,  bound<int>::min,            bound<int>::max             },
+                    { "int8",       kind::integer,  bound<std::int8_t>::min,    bound<std::int8_t>::max     },
+                    { "int16",      kind::integer,  bound<std::int16_t>::min,   bound<std::int16_t>::max    },
+                    { "int32",      kind::integer,  bound<std::int32_t>::min,   bound<std::int32_t>::max    },
+                    { "int64",      kind::integer,  bound<std::int64_t>::min,   bound<std::int64_t>::max    },
+                    { "uint",       kind::integer,  0,                          bound<unsigned>::max        },
+                    { "uint8",      kind::integer,  0,                          bound<std::uint8_t>::max    },
+                    { "uint16",     kind::integer,  0,                          bound<std::uint16_t>::max   },
+                    { "uint32",     kind::integer,  0,                          bound<std::uint32_t>::max   },
+                    { "uint64",     kind::integer,  0,                          bound<std::uint64_t>::max   },
+                    { "float",      kind::floating, 0,                          0                           },
+                    { "segment",    kind::segment,  0,                          0                           },
+                    { "hex",        kind::hex,      0,                          0                           },
+                    { "uuid",       kind::uuid,     0,                          0                           },
+                } };
+
+                // find the type by its name
+                for (const auto& current : definitions) {
+                    if (current.name == type) {
+                        return slug_type{ expression.substr(0, colon), current.type, current.min, current.max };
+                    }
+                }
+
+                // not a type we know, so this is a regular expression
+                return std::nullopt;
+            }
+
+            /**
+             *  Get the name of the slug
+             *
+             *  @return The name given before the colon
+             */
+            std::string_view name() const noexcept
+            {
+                return _name;
+            }
+
+            /**
+             *  Get the kind of slug
+             *
+             *  @return The kind
+             */
+            kind type() const noexcept
+            {
+                return _type;
+            }
+
+            /**
+             *  Match the start of the given input
+             *
+             *  This is greedy, like a regular expression: it takes as much of
+             *  the input as it can, and then checks whether that fits the type.
+             *
+             *  @param  input   The input to test
+             *  @param  output  Set to the matched data
+             *  @return Whether the input starts with a value of the type
+             */
+            bool match(std::string_view input, std::string_view& output) const noexcept
+            {
+                // the value is not needed
+                slug_value value;
+
+                return match(input, output, value);
+            }
+
+            /**
+             *  Match the start of the given input, and get the value
+             *
+             *  @param  input   The input to test
+             *  @param  output  Set to the matched data
+             *  @param  value   Set to the converted value, for numbers
+             *  @return Whether the input starts with a value of the type
+             */
+            bool match(std::string_view input, std::string_view& output, slug_value& value) const noexcept
+            {
+                // the number of characters matched
+                std::size_t count{ 0 };
+
+                switch (_type) {
+                    case kind::integer:     count = match_integer(input, value);    break;
+                    case kind::floating:    count = match_floating(input, value);   break;
+                    case kind::segment:     count = match_segment(input);           break;
+                    case kind::hex:         count = match_hex(input);               break;
+                    case kind::uuid:        count = match_uuid(input);              break;
+                }
+
+                // nothing matched, which is never a valid value
+                if (count == 0) {
+                    return false;
+                }
+
+                output = input.substr(0, count);
+                return true;
+            }
+        private:
+            /**
+             *  The bounds of an integer type, in the types used for the definitions
+             */
+            template <typename integral>
+            struct bound
+            {
+                constexpr static std::int64_t   min = static_cast<std::int64_t>(std::numeric_limits<integral>::min());
+                constexpr static std::uint64_t  max = static_cast<std::uint64_t>(std::numeric_limits<integral>::max());
+            };
+
+            /**
+             *  Constructor
+             *
+             *  @param  name    The name of the slug
+             *  @param  type    The kind of slug
+             *  @param  min     The smallest integer allowed
+             *  @param  max     The largest integer allowed
+             */
+            slug_type(std::string_view name, kind type, std::int64_t min, std::uint64_t max) :
+                _name{ name },
+                _type{ type },
+                _min{ min },
+                _max{ max }
+            {}
+
+            /**
+             *  Check whether a name can be used for a slug
+             *
+             *  @param  name    The name to check
+             *  @return Whether the name is a letter or underscore, followed by letters, digits or underscores
+             */
+            static bool identifier(std::string_view name) noexcept
+            {
+                // the name may not be empty, or start with a digit
+                if (name.empty() || digit(name.front())) {
+                    return false;
+                }
+
+                for (char character : name) {
+                    if (!digit(character) && !letter(character) && character != '_') {
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+            /**
+             *  Character tests, which do not depend on the locale
+             *
+             *  @param  character   The character to test
+             *  @return Whether the character is in the class
+             */
+            static bool digit(char character) noexcept  { return character >= '0' && character <= '9'; }
+            static bool letter(char character) noexcept { return (character >= 'a' && character <= 'z') || (character >= 'A' && character <= 'Z'); }
+            static bool hex(char character) noexcept    { return digit(character) || (character >= 'a' && character <= 'f') || (character >= 'A' && character <= 'F'); }
+
+            /**
+             *  Count the digits at the start of the input
+             *
+             *  @param  input   The input to count in
+             *  @param  start   The position to start counting at
+             *  @return The position after the last digit
+             */
+            static std::size_t digits(std::string_view input, std::size_t start) noexcept
+            {
+                while (start < input.size() && digit(input[start])) {
+                    ++start;
+                }
+
+                return start;
+            }
+
+            /**
+             *  Match an integer within the bounds
+             *
+             *  @param  input   The input to match
+             *  @param  output  Set to the value of the integer
+             *  @return The number of characters matched, zero if none or out of range
+             */
+            std::size_t match_integer(std::string_view input, slug_value& output) const noexcept
+            {
+                // a minus sign is only allowed for signed integers
+                bool        negative    { _min < 0 && !input.empty() && input.front() == '-'    };
+                std::size_t start       { negative ? std::size_t{ 1 } : std::size_t{ 0 }        };
+                std::size_t end         { digits(input, start)                                  };
+
+                // the largest magnitude we accept
+                std::uint64_t limit{ negative ? std::uint64_t{ 0 } - static_cast<std::uint64_t>(_min) : _max };
+
+                // convert the digits, checking the bounds on the way
+                std::uint64_t value{ 0 };
+
+                for (std::size_t i{ start }; i < end; ++i) {
+                    // the value of the next digit
+                    auto next = static_cast<std::uint64_t>(input[i] - '0');
+
+                    // would the value become too large?
+                    if (value > (limit - next) / 10) {
+                        return 0;
+                    }
+
+                    value = value * 10 + next;
+                }
+
+                // there must be at least one digit
+                if (end == start) {
+                    return 0;
+                }
+
+                // store the value with the sign of the type
+                if (_min < 0) {
+                    output = slug_value{ static_cast<std::int64_t>(negative ? std::uint64_t{ 0 } - value : value) };
+                } else {
+                    output = slug_value{ value };
+                }
+
+                return end;
+            }
+
+            /**
+             *  Match a finite decimal floating point number
+             *
+             *  @param  input   The input to match
+             *  @param  output  Set to the value of the number
+             *  @return The number of characters matched, zero if none or out of range
+             */
+            static std::size_t match_floating(std::string_view input, slug_value& output) noexcept
+            {
+                // the optional sign, and the digits before the decimal point
+                std::size_t start       { !input.empty() && input.front() == '-' ? std::size_t{ 1 } : std::size_t{ 0 } };
+                std::size_t end         { digits(input, start) };
+                bool        mantissa    { end > start };
+
+                // the optional fraction, a lone decimal point is not a number
+                if (end < input.size() && input[end] == '.') {
+                    // the digits after the decimal point
+                    auto fraction = digits(input, end + 1);
+
+                    if (mantissa || fraction > end + 1) {
+                        mantissa    = true;
+                        end         = fraction;
+                    }
+                }
+
+                // there must be digits before or after the decimal point
+                if (!mantissa) {
+                    return 0;
+                }
+
+                // the optional exponent, which must have digits
+                if (end < input.size() && (input[end] == 'e' || input[end] == 'E')) {
+                    // the position of the exponent digits
+                    auto exponent = end + 1;
+
+                    if (exponent < input.size() && (input[exponent] == '-' || input[exponent] == '+')) {
+                        ++exponent;
+                    }
+
+                    if (auto last = digits(input, exponent); last > exponent) {
+                        end = last;
+                    }
+                }
+
+                // the value must fit in a double
+                double      value   {};
+                auto        result  { impl::floating_from_chars(input.data(), input.data() + end, value) };
+
+                if (result.ec != std::errc{} || result.ptr != input.data() + end) {
+                    return 0;
+                }
+
+                output = slug_value{ value };
+                return end;
+            }
+
+            /**
+             *  Match a path segment
+             *
+             *  @param  input   The input to match
+             *  @return The number of characters up to the next slash
+             */
+            static std::size_t match_segment(std::string_view input) noexcept
+            {
+                return std::min(input.find('/'), input.size());
+            }
+
+            /**
+             *  Match hexadecimal digits
+             *
+             *  @param  input   The input to match
+             *  @return The number of digits
+             */
+            static std::size_t match_hex(std::string_view input) noexcept
+            {
+                // the number of digits found
+                std::size_t result{ 0 };
+
+                while (result < input.size() && hex(input[result])) {
+                    ++result;
+                }
+
+                return result;
+            }
+
+            /**
+             *  Match a uuid, like 123e4567-e89b-12d3-a456-426614174000
+             *
+             *  @param  input   The input to match
+             *  @return The number of characters matched, zero if it is not a uuid
+             */
+            static std::size_t match_uuid(std::string_view input) noexcept
+            {
+                // a uuid has a fixed size, with dashes at fixed positions
+                constexpr std::size_t size{ 36 };
+
+                if (input.size() < size) {
+                    return 0;
+                }
+
+                for (std::size_t i{ 0 }; i < size; ++i) {
+                    // is this where a dash should be?
+                    bool dash{ i == 8 || i == 13 || i == 18 || i == 23 };
+
+                    if (dash ? input[i] != '-' : !hex(input[i])) {
+                        return 0;
+                    }
+                }
+
+                return size;
+            }
+
+            std::string     _name;  // the name of the slug
+            kind            _type;  // the kind of slug
+            std::int64_t    _min;   // the smallest integer allowed
+            std::uint64_t   _max;   // the largest integer allowed
+    };
+
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <type_traits>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+
+namespace router {
+
+    /**
+     *  The value of a typed slug, like {id:int}, converted while matching
+     *
+     *  Typed slugs check their value while matching, which means they
+     *  have to convert it anyway. The value is kept with the slug, so
+     *  that it does not need to be parsed again for the callback.
+     */
+    class slug_value
+    {
+        public:
+            /**
+             *  The kinds of values
+             */
+            enum class kind : std::uint8_t
+            {
+                none,               // the slug has no converted value
+                signed_integer,     // a signed integer
+                unsigned_integer,   // an unsigned integer
+                floating            // a double
+            };
+
+            /**
+             *  Constructor for a slug without a value
+             */
+            constexpr slug_value() noexcept = default;
+
+            /**
+             *  Constructor
+             *
+             *  @param  type    The kind of value
+             *  @param  bits    The bits of the value, as given by bits()
+             */
+            constexpr slug_value(kind type, std::uint64_t bits) noexcept :
+                _type{ type },
+                _bits{ bits }
+            {}
+
+            /**
+             *  Constructors for the value of a slug
+             *
+             *  @param  value   The converted value
+             */
+            constexpr explicit slug_value(std::int64_t value) noexcept  : _type{ kind::signed_integer   }, _bits{ static_cast<std::uint64_t>(value) } {}
+            constexpr explicit slug_value(std::uint64_t value) noexcept : _type{ kind::unsigned_integer }, _bits{ value } {}
+
+            explicit slug_value(double value) noexcept :
+                _type{ kind::floating }
+            {
+                std::memcpy(&_bits, &value, sizeof value);
+            }
+
+            /**
+             *  Get the kind of value
+             *
+             *  @return The kind, which is none if the slug has no value
+             */
+            constexpr kind type() const noexcept
+            {
+                return _type;
+            }
+
+            /**
+             *  Get the bits of the value, for storing it
+             *
+             *  @return The bits
+             */
+            constexpr std::uint64_t bits() const noexcept
+            {
+                return _bits;
+            }
+
+            /**
+             *  Store the value in a field
+             *
+             *  Integers are stored in integral fields they fit in, and
+             *  floating point numbers in fields of type double. Any other
+             *  field is left alone, and should be parsed from the slug data.
+             *
+             *  @param  output  The field to set
+             *  @return Whether the field was set
+             */
+            template <typename T>
+            bool get(T& output) const noexcept
+            {
+                if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>) {
+                    // the bounds of the field, compared in the types of the value
+                    constexpr auto max = static_cast<std::uint64_t>(std::numeric_limits<T>::max());
+                    constexpr auto min = static_cast<std::int64_t>(std::numeric_limits<T>::min());
+
+                    if (_type == kind::signed_integer) {
+                        // the value as it was stored
+                        auto value = static_cast<std::int64_t>(_bits);
+
+                        if (value < min || (value > 0 && static_cast<std::uint64_t>(value) > max)) {
+                            return false;
+                        }
+
+                        output = static_cast<T>(value);
+                        return true;
+                    } else if (_type == kind::unsigned_integer) {
+                        if (_bits > max) {
+                            return false;
+                        }
+
+                        output = static_cast<T>(_bits);
+                        return true;
+                    }
+                } else if constexpr (std::is_same_v<T, double>) {
+                    if (_type == kind::floating) {
+                        std::memcpy(&output, &_bits, sizeof output);
+                        return true;
+                    }
+                }
+
+                static_cast<void>(output);
+                return false;
+            }
+        private:
+            kind            _type{ kind::none };    // the kind of value
+            std::uint64_t   _bits{ 0 };             // the bits of the value
+    };
+
+}
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+namespace router {
+
+    /**
+     *  A hash index for paths without slugs
+     *
+     *  Paths without any slugs can only match an endpoint that is exactly
+     *  equal to the path, so they can be found with a single hash lookup.
+     *  The index uses open addressing with linear probing and is kept at
+     *  most half full, so a lookup typically inspects a single slot. The
+     *  keys are stored together in a single buffer.
+     */
+    class static_index
+    {
+        public:
+            /**
+             *  Value returned when a key is not found
+             */
+            constexpr static std::size_t npos = static_cast<std::size_t>(-1);
+
+            /**
+             *  Add a key to the index, replacing the value
+             *  if the key was added before
+             *
+             *  @param  key     The key to add
+             *  @param  value   The value to store
+             */
+            void insert(std::string_view key, std::size_t value)
+            {
+                // make sure we have room for another key
+                if ((_size + 1) * 2 > _slots.size()) {
+                    rehash(_slots.empty() ? 16 : _slots.size() * 2);
+                }
+
+                // find the slot for the key
+                auto  code      = hash(key);
+                auto& target    = _slots[locate(key, code)];
+
+                // is this a new key?
+                if (target.hash == 0) {
+                    // store the key data
+                    target.hash     = code;
+                    target.offset   = static_cast<std::uint32_t>(_keys.size());
+                    target.length   = static_cast<std::uint32_t>(key.size());
+                    _keys.append(key);
+                    ++_size;
+                }
+
+                // store the value
+                target.value = value;
+            }
+
+            /**
+             *  Make room for the given number of keys
+             *
+             *  @param  count   The number of keys to make room for
+             */
+            void reserve(std::size_t count)
+            {
+                // the number of slots we need
+                std::size_t slots{ _slots.empty() ? 16 : _slots.size() };
+
+                while (count * 2 > slots) {
+                    slots *= 2;
+                }
+
+                // only ever grow the index
+                if (slots > _slots.size()) {
+                    rehash(slots);
+                }
+            }
+
+            /**
+             *  Find a key in the index
+             *
+             *  @param  key     The key to find
+             *  @return The stored value, or npos if not found
+             */
+            std::size_t find(std::string_view key) const noexcept
+            {
+                return find(key, hash(key));
+            }
+
+            /**
+             *  Find a key in the index, using a hash calculated earlier
+             *
+             *  @param  key     The key to find
+             *  @param  hash    The hash of the key
+             *  @return The stored value, or npos if not found
+             */
+            std::size_t find(std::string_view key, std::uint64_t hash) const noexcept
+            {
+                // an empty index contains nothing
+                if (_size == 0) {
+                    return npos;
+                }
+
+                // find the slot where the key should be
+                const auto& slot = _slots[locate(key, hash)];
+
+                // the slot is either empty or holds the key
+                return slot.hash == 0 ? npos : slot.value;
+            }
+
+            /**
+             *  Calculate the hash for a key
+             *
+             *  @param  key The key to hash
+             *  @return The hash, which is never zero
+             */
+            static std::uint64_t hash(std::string_view key) noexcept
+            {
+                // fnv-1a over the key data
+                std::uint64_t result{ 14695981039346656037ull };
+
+                for (char character : key) {
+                    result = (result ^ static_cast<unsigned char>(character)) * 1099511628211ull;
+                }
+
+                // zero is reserved for empty slots
+                return result | 1;
+            }
+
+            /**
+             *  Hint that a key is going to be looked up soon
+             *
+             *  This starts loading the slot for the key into the cache,
+             *  so that multiple lookups can wait for memory in parallel.
+             *
+             *  @param  hash    The hash of the key
+             */
+            void prefetch(std::uint64_t hash) const noexcept
+            {
+                // nothing to load from an empty index
+                if (_size == 0) {
+                    return;
+                }
+
+                #if defined(__GNUC__)
+                    __builtin_prefetch(&_slots[(hash ^ (hash >> 32)) & (_slots.size() - 1)]);
+                #else
+                    static_cast<void>(hash);
+                #endif
+            }
+
+            /**
+             *  Get the number of keys in the index
+             *
+             *  @return The number of keys
+             */
+            std::size_t size() const noexcept
+            {
+                return _size;
+            }
+        private:
+            /**
+             *  A slot in the index
+             */
+            struct slot
+            {
+                std::uint64_t   hash;   // the hash of the key, zero for an empty slot
+                std::uint32_t   offset; // the offset of the key data
+                std::uint32_t   length; // the size of the key
+                std::size_t     value;  // the value stored for the key
+            };
+
+            /**
+             *  Find the slot for a key, this is either the
+             *  slot holding the key or an empty slot
+             *
+             *  @param  key     The key to locate
+             *  @param  hash    The hash of the key
+             *  @return The index of the slot
+             */
+            std::size_t locate(std::string_view key, std::uint64_t hash) const noexcept
+            {
+                // the slot count is a power of two
+                std::size_t mask = _slots.size() - 1;
+
+                // probe until we find the key or an empty slot
+                for (std::size_t index = (hash ^ (hash >> 32)) & mask;; index = (index + 1) & mask) {
+                    // retrieve the slot to check
+                    const auto& current = _slots[index];
+
+                    // stop at an empty slot or the key we are looking for
+                    if (current.hash == 0 || (current.hash == hash && std::string_view{ _keys.data() + current.offset, current.length } == key)) {
+                        return index;
+                    }
+                }
+            }
+
+            /**
+             *  Redistribute the keys over a new number of slots
+             *
+             *  @param  count   The number of slots, a power of two
+             */
+            void rehash(std::size_t count)
+            {
+                // swap out the old slots
+                std::vector<slot> slots(count);
+                std::swap(slots, _slots);
+
+                // move all keys to their new slot
+                for (const auto& current : slots) {
+                    if (current.hash != 0) {
+                        _slots[locate({ _keys.data() + current.offset, current.length }, current.hash)] = current;
+                    }
+                }
+            }
+
+            std::vector<slot>   _slots;     // the slots holding the keys
+            std::string         _keys;      // the data for all keys
+            std::size_t         _size{};    // the number of keys stored
+    };
+
+}
@@ -0,0 +1,515 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace router {
+
+    /**
+     *  Counters describing how the endpoints of a table are routed
+     *
+     *  The counters are only maintained when ROUTER_INSTRUMENTATION is
+     *  defined, for example by configuring with -DROUTER_INSTRUMENTATION=ON.
+     *  Without it, nothing is counted and routing does not pay for it.
+     *
+     *  The counters are spread over a number of shards, every thread counts
+     *  in its own shard, so that threads routing at the same time do not
+     *  fight over the same cache lines. A snapshot adds up all the shards.
+     *  Every shard holds the counters for every route, so the memory used
+     *  grows with both the number of routes and the number of shards.
+     */
+    class statistics
+    {
+        public:
+            /**
+             *  Whether the counters are maintained
+             */
+            #if defined(ROUTER_INSTRUMENTATION)
+                constexpr static bool enabled = true;
+            #else
+                constexpr static bool enabled = false;
+            #endif
+
+            /**
+             *  Value for a lookup that found no route
+             */
+            constexpr static std::size_t npos = static_cast<std::size_t>(-1);
+
+            /**
+             *  The number of latency buckets, the first bucket holds lookups
+             *  taking less than a nanosecond, every bucket after it holds the
+             *  lookups taking up to twice as long as the bucket before it,
+             *  the last bucket also holds everything slower than that
+             */
+            constexpr static std::size_t buckets = 32;
+
+            /**
+             *  The counters for a single route
+             */
+            struct route
+            {
+                std::uint64_t   hits            {}; // the number of lookups finding the route
+                std::uint64_t   candidates      {}; // the number of times the route was tried
+                std::uint64_t   regex_calls     {}; // the number of regular expressions matched for the route
+                std::uint64_t   regex_time      {}; // the nanoseconds spent in those regular expressions
+            };
+
+            /**
+             *  The counters for a table, added up over all threads
+             */
+            struct snapshot
+            {
+                std::vector<route>                  routes;         // the counters for every route, in the order they were added
+                std::uint64_t                       not_found   {}; // the number of lookups not finding a route
+                std::uint64_t                       not_proxied {}; // the number of routed endpoints without a callback for the method
+                std::array<std::uint64_t, buckets>  latency     {}; // the number of lookups in every latency bucket
+            };
+
+            /**
+             *  Constructor
+             */
+            statistics() :
+                _shards(std::clamp<std::size_t>(std::thread::hardware_concurrency(), 1, max_shards))
+            {
+                // every shard starts out holding no routes
+                for (auto& shard : _shards) {
+                    shard = std::make_unique<std::atomic<std::uint64_t>[]>(route_counters);
+                }
+            }
+
+            /**
+             *  Copy constructor, this takes over the counts
+             *
+             *  @param  that    The statistics to copy
+             */
+            statistics(const statistics& that) :
+                _shards(that._shards.size()),
+                _routes{ that._routes },
+                _capacity{ that._capacity }
+            {
+                // copy the counters from every shard
+                for (std::size_t i{ 0 }; i < _shards.size(); ++i) {
+                    _shards[i] = copy(that._shards[i].get(), size(_capacity), size(_capacity));
+                }
+            }
+
+            /**
+             *  Copy assignment, this takes over the counts
+             *
+             *  @param  that    The statistics to copy
+             *  @return Same object for chaining
+             */
+            statistics& operator=(const statistics& that)
+            {
+                // copy to a temporary first, so we are unchanged when this fails
+                statistics copied{ that };
+
+                _shards     = std::move(copied._shards);
+                _routes     = copied._routes;
+                _capacity   = copied._capacity;
+
+                return *this;
+            }
+
+            /**
+             *  Set the number of routes to count for
+             *
+             *  This may not be called while lookups are counted on other threads.
+             *
+             *  @param  routes  The number of routes
+             */
+            void resize(std::size_t routes)
+            {
+                // grow the storage in steps, so adding routes one by one
+                // does not copy the counters for every single route
+                if (routes > _capacity) {
+                    // the new number of routes we have storage for
+                    auto capacity = std::max(routes, _capacity * 2);
+
+                    // the shards with the new storage, only replaced once all are allocated
+                    std::vector<shard> shards;
+
+                    for (const auto& current : _shards) {
+                        shards.push_back(copy(current.get(), size(_capacity), size(capacity)));
+                    }
+
+                    _shards     = std::move(shards);
+                    _capacity   = capacity;
+                }
+
+                _routes = routes;
+            }
+
+            /**
+             *  Get the number of routes counted for
+             *
+             *  @return The number of routes
+             */
+            std::size_t size() const noexcept
+            {
+                return _routes;
+            }
+
+            /**
+             *  Count a route being tried for an endpoint
+             *
+             *  @param  route   The index of the route
+             */
+            void candidate(std::size_t route) const noexcept
+            {
+                increment(route_counters + route * fields + candidates_field);
+            }
+
+            /**
+             *  Count a regular expression matched for a route
+             *
+             *  @param  route       The index of the route
+             *  @param  nanoseconds The time it took to match the expression
+             */
+            void regex(std::size_t route, std::uint64_t nanoseconds) const noexcept
+            {
+                increment(route_counters + route * fields + regex_calls_field);
+                increment(route_counters + route * fields + regex_time_field, nanoseconds);
+            }
+
+            /**
+             *  Count the outcome of a lookup
+             *
+             *  @param  route   The index of the route found, or npos if none was found
+             */
+            void record(std::size_t route) const noexcept
+            {
+                increment(route == npos ? not_found_counter : route_counters + route * fields + hits_field);
+            }
+
+            /**
+             *  Count the time a lookup took
+             *
+             *  @param  nanoseconds The duration of the lookup
+             */
+            void latency(std::uint64_t nanoseconds) const noexcept
+            {
+                increment(latency_counters + bucket(nanoseconds));
+            }
+
+            /**
+             *  Count an endpoint that was found, but without a callback for the method
+             */
+            void not_proxied() const noexcept
+            {
+                increment(not_proxied_counter);
+            }
+
+            /**
+             *  Add up the counters from all threads
+             *
+             *  Counters updated while the snapshot is taken may or
+             *  may not be included, they are never counted twice.
+             *
+             *  @return The counters for the table
+             */
+            snapshot collect() const
+            {
+                // the snapshot to fill
+                snapshot result{};
+                result.routes.resize(_routes);
+
+                // add up the counters from all shards
+                for (const auto& shard : _shards) {
+                    // load a counter from the shard
+                    auto load = [&shard](std::size_t index) {
+                        return shard[index].load(std::memory_order_relaxed);
+                    };
+
+                    result.not_found    += load(not_found_counter);
+                    result.not_proxied  += load(not_proxied_counter);
+
+                    for (std::size_t i{ 0 }; i < buckets; ++i) {
+                        result.latency[i] += load(latency_counters + i);
+                    }
+
+                    for (std::size_t i{ 0 }; i < _routes; ++i) {
+                        // the first counter for the route
+                        auto base = route_counters + i * fields;
+
+                        result.routes[i].hits           += load(base + hits_field);
+                        result.routes[i].candidates     += load(base + candidates_field);
+                        result.routes[i].regex_calls    += load(base + regex_calls_field);
+                        result.routes[i].regex_time     += load(base + regex_time_field);
+                    }
+                }
+
+                return result;
+            }
+
+            /**
+             *  Set all counters back to zero
+             *
+             *  Counters updated at the same time on other threads may be kept.
+             */
+            void reset() noexcept
+            {
+                for (auto& shard : _shards) {
+                    for (std::size_t i{ 0 }; i < size(_capacity); ++i) {
+                        shard[i].store(0, std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            /**
+             *  Find the latency bucket for a duration
+             *
+             *  @param  nanoseconds The duration to find the bucket for
+             *  @return The index of the bucket
+             */
+            constexpr static std::size_t bucket(std::uint64_t nanoseconds) noexcept
+            {
+                // the number of bits needed for the duration
+                std::size_t result{ 0 };
+
+                for (; nanoseconds != 0 && result < buckets - 1; nanoseconds >>= 1) {
+                    ++result;
+                }
+
+                return result;
+            }
+
+            /**
+             *  The lookup being counted on a thread
+             */
+            struct context
+            {
+                const statistics*   owner;  // the statistics to count in, if any
+                std::size_t         route;  // the route being tried
+            };
+
+            /**
+             *  Helper class attributing the work done for a lookup to the
+             *  statistics of a table, for its lifetime, on the current thread
+             *
+             *  This is how the candidates and regular expressions tried deep
+             *  inside a lookup end up with the right table and route.
+             */
+            class scope
+            {
+                public:
+                    /**
+                     *  Constructor
+                     *
+                     *  @param  owner   The statistics to count in
+                     */
+                    explicit scope(const statistics& owner) noexcept :
+                        _previous{ current() },
+                        _start{ std::chrono::steady_clock::now() }
+                    {
+                        current() = { &owner, npos };
+                    }
+
+                    /**
+                     *  Destructor
+                     */
+                    ~scope()
+                    {
+                        // lookups may be nested, for example in a callback
+                        current() = _previous;
+                    }
+
+                    /**
+                     *  Deleted copy and move, the scope is bound to the thread
+                     */
+                    scope(const scope&) = delete;
+                    scope& operator=(const scope&) = delete;
+
+                    /**
+                     *  Count the outcome of the lookup and the time it took
+                     *
+                     *  @param  route   The index of the route found, or npos if none was found
+                     */
+                    void finish(std::size_t route) const noexcept
+                    {
+                        // the time since the lookup started
+                        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start);
+
+                        current().owner->record(route);
+                        current().owner->latency(static_cast<std::uint64_t>(elapsed.count()));
+                    }
+                private:
+                    context                                 _previous;  // the scope we replaced, if any
+                    std::chrono::steady_clock::time_point   _start;     // the moment the lookup started
+            };
+
+            /**
+             *  Helper class counting a regular expression, and the time it
+             *  takes to match, for the route currently being tried
+             */
+            class regex_timer
+            {
+                public:
+                    /**
+                     *  Constructor
+                     */
+                    regex_timer() noexcept :
+                        _context{ current() }
+                    {
+                        // only spend time on the clock when anyone is counting
+                        if (_context.owner != nullptr) {
+                            _start = std::chrono::steady_clock::now();
+                        }
+                    }
+
+                    /**
+                     *  Destructor
+                     */
+                    ~regex_timer()
+                    {
+                        // is the expression matched for a route?
+                        if (_context.owner == nullptr || _context.route == npos) {
+                            return;
+                        }
+
+                        // the time it took to match
+                        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start);
+
+                        _context.owner->regex(_context.route, static_cast<std::uint64_t>(elapsed.count()));
+                    }
+
+                    /**
+                     *  Deleted copy and move, the timer is bound to the thread
+                     */
+                    regex_timer(const regex_timer&) = delete;
+                    regex_timer& operator=(const regex_timer&) = delete;
+                private:
+                    context                                 _context;    // the table and route being matched
+                    std::chrono::steady_clock::time_point   _start;     // the moment matching started
+            };
+
+            /**
+             *  Count a route being tried on the current thread, if a lookup
+             *  is being counted, regular expressions matched after this are
+             *  attributed to the route as well
+             *
+             *  @param  route   The index of the route
+             */
+            static void examine(std::size_t route) noexcept
+            {
+                // retrieve the lookup being counted
+                auto& context = current();
+
+                if (context.owner != nullptr) {
+                    context.route = route;
+                    context.owner->candidate(route);
+                }
+            }
+        private:
+            /**
+             *  The maximum number of shards to spread the counters over
+             */
+            constexpr static std::size_t max_shards = 16;
+
+            /**
+             *  The position of the counters in a shard, the counters
+             *  for the table come first, followed by every route
+             */
+            constexpr static std::size_t not_found_counter      = 0;
+            constexpr static std::size_t not_proxied_counter    = 1;
+            constexpr static std::size_t latency_counters       = 2;
+            constexpr static std::size_t route_counters         = latency_counters + buckets;
+
+            /**
+             *  The position of the counters for a route, relative to the first
+             */
+            constexpr static std::size_t hits_field             = 0;
+            constexpr static std::size_t candidates_field       = 1;
+            constexpr static std::size_t regex_calls_field      = 2;
+            constexpr static std::size_t regex_time_field       = 3;
+            constexpr static std::size_t fields                 = 4;
+
+            /**
+             *  The counters for a number of threads, for the table and all routes
+             */
+            using shard = std::unique_ptr<std::atomic<std::uint64_t>[]>;
+
+            /**
+             *  Retrieve the lookup being counted on the current thread
+             *
+             *  @return The context for the current thread
+             */
+            static context& current() noexcept
+            {
+                thread_local context result{ nullptr, npos };
+                return result;
+            }
+
+            /**
+             *  Get the shard index for the current thread
+             *
+             *  @return The index of the shard to use
+             */
+            static std::size_t shard_index() noexcept
+            {
+                // the index to give to the next thread
+                static std::atomic<std::size_t> next{ 0 };
+
+                // every thread gets the next shard, wrapping around
+                // when there are more threads than shards
+                thread_local std::size_t index{ next.fetch_add(1, std::memory_order_relaxed) };
+
+                return index;
+            }
+
+            /**
+             *  Get the number of counters in a shard
+             *
+             *  @param  routes  The number of routes in the shard
+             *  @return The number of counters
+             */
+            constexpr static std::size_t size(std::size_t routes) noexcept
+            {
+                return route_counters + routes * fields;
+            }
+
+            /**
+             *  Copy the counters of a shard into new storage
+             *
+             *  @param  counters    The counters to copy
+             *  @param  count       The number of counters to copy
+             *  @param  capacity    The number of counters to allocate, at least count
+             *  @return The new storage, the counters beyond the copied ones are zero
+             */
+            static shard copy(const std::atomic<std::uint64_t>* counters, std::size_t count, std::size_t capacity)
+            {
+                // allocate the new storage, which is zero-initialized
+                auto result = std::make_unique<std::atomic<std::uint64_t>[]>(capacity);
+
+                for (std::size_t i{ 0 }; i < count; ++i) {
+                    result[i].store(counters[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+                }
+
+                return result;
+            }
+
+            /**
+             *  Add to a counter in the shard of the current thread
+             *
+             *  @param  index   The index of the counter
+             *  @param  amount  The amount to add
+             */
+            void increment(std::size_t index, std::uint64_t amount = 1) const noexcept
+            {
+                _shards[shard_index() % _shards.size()][index].fetch_add(amount, std::memory_order_relaxed);
+            }
+
+            std::vector<shard>  _shards;            // the counters, spread over the threads
+            std::size_t         _routes     { 0 };  // the number of routes counted for
+            std::size_t         _capacity   { 0 };  // the number of routes the shards have storage for
+    };
+
+}
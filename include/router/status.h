@@ -0,0 +1,132 @@
+#pragma once
+
+#include <type_traits>
+#include <functional>
+#include <optional>
+#include <cstdint>
+#include <utility>
+
+
+namespace router {
+
+    /**
+     *  The outcome of routing an endpoint without exceptions
+     */
+    enum class status : std::uint8_t
+    {
+        ok,                 // the callback was invoked
+        not_found,          // no route matches the endpoint
+        method_not_allowed, // a route matches, but not for the method
+        conversion_failed   // the slugs could not be converted for the callback
+    };
+
+    /**
+     *  The result of routing an endpoint without exceptions, holding
+     *  either the value returned by the callback, or the reason why
+     *  the callback could not be invoked
+     */
+    template <typename T>
+    class result
+    {
+        public:
+            /**
+             *  Constructor for a failure
+             *
+             *  @param  error   The reason the callback was not invoked
+             */
+            result(status error) noexcept :
+                _error{ error }
+            {}
+
+            /**
+             *  Constructor for a success
+             *
+             *  @param  value   The value returned by the callback
+             */
+            result(T value) :
+                _error{ status::ok },
+                _value{ std::forward<T>(value) }
+            {}
+
+            /**
+             *  Check whether the callback was invoked
+             *
+             *  @return Whether the result holds a value
+             */
+            bool has_value() const noexcept { return _value.has_value(); }
+            explicit operator bool() const noexcept { return has_value(); }
+
+            /**
+             *  Get the reason the callback was not invoked
+             *
+             *  @return The status, which is ok if the result holds a value
+             */
+            status error() const noexcept
+            {
+                return _error;
+            }
+
+            /**
+             *  Retrieve the value returned by the callback, the
+             *  result must hold a value, check this first
+             *
+             *  @return The value
+             */
+            std::add_lvalue_reference_t<T>          value() &       { return *_value; }
+            std::add_lvalue_reference_t<const T>    value() const&  { return *_value; }
+            std::add_rvalue_reference_t<T>          value() &&      { return std::move(*_value); }
+
+            std::add_lvalue_reference_t<T>          operator*() &       { return value(); }
+            std::add_lvalue_reference_t<const T>    operator*() const&  { return value(); }
+            std::add_rvalue_reference_t<T>          operator*() &&      { return std::move(*this).value(); }
+
+            std::add_pointer_t<std::remove_reference_t<T>>          operator->()        { return &value(); }
+            std::add_pointer_t<const std::remove_reference_t<T>>    operator->() const  { return &value(); }
+        private:
+            /**
+             *  The type used to store the value, references are stored as a wrapper
+             */
+            using storage = std::conditional_t<std::is_reference_v<T>, std::reference_wrapper<std::remove_reference_t<T>>, T>;
+
+            status                  _error; // the reason the callback was not invoked, or ok
+            std::optional<storage>  _value; // the value returned by the callback, if invoked
+    };
+
+    /**
+     *  The result of routing an endpoint to a callback without a return value
+     */
+    template <>
+    class result<void>
+    {
+        public:
+            /**
+             *  Constructor
+             *
+             *  @param  error   The reason the callback was not invoked, or ok
+             */
+            result(status error = status::ok) noexcept :
+                _error{ error }
+            {}
+
+            /**
+             *  Check whether the callback was invoked
+             *
+             *  @return Whether the routing succeeded
+             */
+            bool has_value() const noexcept { return _error == status::ok; }
+            explicit operator bool() const noexcept { return has_value(); }
+
+            /**
+             *  Get the reason the callback was not invoked
+             *
+             *  @return The status, which is ok if the callback was invoked
+             */
+            status error() const noexcept
+            {
+                return _error;
+            }
+        private:
+            status _error; // the reason the callback was not invoked, or ok
+    };
+
+}
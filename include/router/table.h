@@ -1,11 +1,22 @@
 #pragma once
 
-#include <vector>
+#include <type_traits>
+#include <cstddef>
+#include <array>
+#include <tuple>
+#include <utility>
+#include <initializer_list>
 #include "path.h"
+#include "slug_list.h"
+#include "query.h"
 #include "proxy.h"
 #include "path_map.h"
 #include "path_callback.h"
+#include "route_match.h"
 #include "function_traits.h"
+#include "status.h"
+#include "impl/method_routing.h"
+#include "impl/exceptions.h"
 
 
 namespace router {
@@ -25,6 +36,45 @@ namespace router {
     class table<return_type(arguments...)>
     {
         public:
+            /**
+             *  The result of matching an endpoint
+             */
+            using match_type = route_match<return_type(arguments...)>;
+
+            /**
+             *  A route to add with add_all(), create these with make_route()
+             */
+            using route_type = std::pair<std::string_view, path_callback<return_type(arguments...)>>;
+
+            /**
+             *  Create a route for adding with add_all()
+             *
+             *  @tparam callback    The callback to route to
+             *  @param  endpoint    The path to add
+             *  @return The route to add
+             */
+            template <auto callback>
+            static std::enable_if_t<!std::is_member_function_pointer_v<decltype(callback)>, route_type>
+            make_route(std::string_view endpoint) noexcept
+            {
+                return { endpoint, in_place_value<callback>{} };
+            }
+
+            /**
+             *  Create a route for adding with add_all()
+             *
+             *  @tparam callback    The callback to route to
+             *  @param  endpoint    The path to add
+             *  @param  instance    The instance to invoke the callback on
+             *  @return The route to add
+             */
+            template <auto callback>
+            static std::enable_if_t<std::is_member_function_pointer_v<decltype(callback)>, route_type>
+            make_route(std::string_view endpoint, typename function_traits<decltype(callback)>::member_type* instance) noexcept
+            {
+                return { endpoint, { in_place_value<callback>{}, instance } };
+            }
+
             /**
              *  Add an endpoint to the routing table
              *
@@ -56,158 +106,195 @@ namespace router {
             }
 
             /**
-             *  Set a handler for endpoints that are not found
+             *  Add many endpoints to the routing table at once
              *
-             *  @tparam callback    The callback to route to
+             *  This gives the same result as adding the routes one by one
+             *  in the given order, but is faster for large numbers of routes.
+             *
+             *  @param  iter    Iterator to the first route to add
+             *  @param  last    Iterator past the last route to add
              */
-            template <auto callback>
-            std::enable_if_t<!std::is_member_function_pointer_v<decltype(callback)>>
-            set_not_found()
+            template <class input_iterator>
+            void add_all(input_iterator iter, input_iterator last)
             {
-                // store the function pointer, there is no instance
-                _not_found_handler.template set<callback>();
+                _paths.add_all(iter, last);
             }
 
             /**
-             *  Set a handler for endpoints that are not found
+             *  Add many endpoints to the routing table at once, compiling
+             *  the slug patterns in parallel on the given executor
              *
-             *  @tparam callback    The callback to route to
-             *  @param  instance    The instance to invoke the callback on
+             *  The routes are added in the given order, and if any route
+             *  is invalid, the error for the first invalid route is thrown
+             *  and no route is added, no matter the order the tasks ran in.
+             *
+             *  @param  iter    Iterator to the first route to add
+             *  @param  last    Iterator past the last route to add
+             *  @param  execute Callable that runs the given std::function<void()> task, on any thread
+             *  @param  tasks   The number of tasks to divide the work over
              */
-            template <auto callback>
-            std::enable_if_t<std::is_member_function_pointer_v<decltype(callback)>>
-            set_not_found(typename function_traits<decltype(callback)>::member_type* instance)
+            template <class forward_iterator, class executor>
+            std::enable_if_t<std::is_invocable_v<executor&, std::function<void()>>>
+            add_all(forward_iterator iter, forward_iterator last, executor&& execute, std::size_t tasks = std::thread::hardware_concurrency())
             {
-                // store the function pointer and instance
-                _not_found_handler.template set<callback>(instance);
+                _paths.add_all(iter, last, std::forward<executor>(execute), tasks);
             }
 
             /**
-             *  Check whether a given endpoint can be routed
-             *
-             *  Note that this function ignores the not-found
-             *  handler, since this would otherwise make this
-             *  function return true unconditionally.
+             *  Add many endpoints to the routing table at once, compiling
+             *  the slug patterns in parallel on the given number of threads
              *
-             *  @param  endpoint    The endpoint to check
-             *  @return Whether the endpoint can be routed
+             *  @param  iter    Iterator to the first route to add
+             *  @param  last    Iterator past the last route to add
+             *  @param  threads The number of threads to use
              */
-            bool routable(std::string_view endpoint) const noexcept
+            template <class forward_iterator>
+            void add_all(forward_iterator iter, forward_iterator last, std::size_t threads)
             {
-                // find the handler for the given endpoint
-                auto callback= get_handler(endpoint);
+                _paths.add_all(iter, last, threads);
+            }
 
-                // check whether the callback is valid
-                return callback.valid();
+            /**
+             *  Add many endpoints to the routing table at once
+             *
+             *  @param  routes  The routes to add, in order
+             */
+            void add_all(std::initializer_list<route_type> routes)
+            {
+                _paths.add_all(routes.begin(), routes.end());
             }
 
             /**
-             *  Check whether a fallback handler is installed
+             *  Compile all routes into a single automaton
              *
-             *  If a fallback handler is installed and no endpoint is
-             *  available when routing, the fallback handler is used.
-             *  This also means that routing will never fail due to a
-             *  missing endpoint.
+             *  This should be called after all routes were added. Lookups
+             *  then walk over the endpoint once, instead of trying all the
+             *  candidate routes one by one. Routes using a regular expression
+             *  for their slugs cannot be compiled, in which case the table
+             *  keeps working as before. Adding a route discards the automaton.
              *
-             *  @return Whether a fallback handler is installed
+             *  @param  max_states  The maximum number of states in the automaton
+             *  @return Whether the routes were compiled
              */
-            bool has_not_found_handler() const noexcept
+            bool compile(std::size_t max_states = 1 << 16)
             {
-                return _not_found_handler.valid();
+                return _paths.compile(max_states);
             }
 
             /**
-             *  Route a request to one of the callbacks
+             *  Freeze the routes into a compact layout
              *
-             *  @param  endpoint    The endpoint to route
-             *  @param  parameters  The arguments to give to the callback
-             *  @return The result of the callback
-             *  @throws std::out_of_range If no matching route and no not_found handler is available
+             *  This should be called after all routes were added. All routes
+             *  are copied into a few contiguous arrays, so routing touches less
+             *  memory. Routing gives the same results as before. Adding a route
+             *  discards the frozen layout again.
              */
-            return_type route(std::string_view endpoint, arguments... parameters) const
+            void freeze()
             {
-                // find the handler for the given endpoint
-                if (auto callback= get_handler(endpoint); callback.valid()) {
-                    // invoke the callback
-                    return callback(slugs(), std::forward<arguments>(parameters)...);
-                }
-
-                // do we have a handler for endpoints that aren't registered
-                if (_not_found_handler) {
-                    // invoke the handler
-                    return _not_found_handler({}, std::forward<arguments>(parameters)...);
-                }
-
-                // none of the paths matched
-                throw std::out_of_range{ "Route not matched" };
+                _paths.freeze();
             }
-        private:
+
             /**
-             *  Alias for the callback type used by the routing table
+             *  Cache the routes found for endpoints
+             *
+             *  When most requests go to a small number of endpoints, caching
+             *  them avoids matching the routes over and over again. Routing
+             *  remains safe to do from multiple threads. Adding a route empties
+             *  the cache, since the endpoints may now be routed elsewhere.
+             *
+             *  @param  capacity    The number of endpoints to cache, zero disables the cache
              */
-            using callback_type = path_callback<return_type(arguments...)>;
+            void enable_cache(std::size_t capacity)
+            {
+                _paths.enable_cache(capacity);
+            }
 
             /**
-             *  Retrieve the handler for a specific endpoint
+             *  Convert the slugs while matching the routes
              *
-             *  If a valid handler is found (i.e. the result contains a valid
-             *  callback) then _slugs is filled with the found slug data.
+             *  Normally, the slugs are converted for the callback after the
+             *  route was chosen, and a route whose slugs cannot be converted,
+             *  like a number that is too large, fails to route. With this
+             *  enabled, the slugs are converted for every candidate route, and
+             *  when that fails, the next candidate is tried instead, just like
+             *  when the route did not match. The converted slugs are kept, so
+             *  routing does not convert them again. This should be set before
+             *  routing starts, like the cache.
              *
-             *  @param  endpoint    The endpoint to find
-             *  @return The found match, which may be invalid
+             *  @param  enable  Whether to convert the slugs while matching
              */
-            callback_type get_handler(std::string_view endpoint) const noexcept
+            void enable_conversion_check(bool enable = true) noexcept
             {
-                if (auto* handler = _paths.find(slugs(), endpoint); handler != nullptr) {
-                    return *handler;
-                } else {
-                    return {};
-                }
+                _check_conversions = enable;
             }
 
             /**
-             *  Retrieve the slug data
+             *  Get the number of endpoints that were found in the cache
              *
-             *  @note   This data is stored locally per thread to ensure
-             *          that the table remains thread-safe, and can re-use
-             *          allocated data between calls.
+             *  @return The number of cache hits
+             */
+            std::size_t cache_hits() const noexcept
+            {
+                return _paths.cache() ? _paths.cache()->hits() : 0;
+            }
+
+            /**
+             *  Get the number of endpoints that were not found in the cache
              *
-             *  @return The slug data
+             *  @return The number of cache misses
              */
-            static std::vector<std::string_view>& slugs() noexcept
+            std::size_t cache_misses() const noexcept
             {
-                // the slugs to cache
-                thread_local std::vector<std::string_view> slugs;
-                return slugs;
+                return _paths.cache() ? _paths.cache()->misses() : 0;
             }
 
-            path_map<callback_type> _paths;             // all registered paths in the table
-            callback_type           _not_found_handler; // the optional handler for paths not found
-    };
+            /**
+             *  Share the compiled slug expressions with other tables
+             *
+             *  Slugs with the same pattern share a single compiled regular
+             *  expression. By default this is only done within the table,
+             *  routes added after this share them with all tables using the
+             *  same registry, even when these are built on other threads.
+             *
+             *  @param  registry    The registry to use, or a nullptr for a new registry
+             */
+            void share_matchers(std::shared_ptr<matcher_registry> registry)
+            {
+                _paths.share_matchers(std::move(registry));
+            }
 
-    /**
-     *  A routing table, containing paths to route and mapping
-     *  them to a proxy for further processing
-     */
-    template <class return_type, class... arguments, auto first, decltype(first)... rest>
-    class table<proxy<return_type(arguments...), first, rest...>>
-    {
-        public:
             /**
-             *  The proxy we route to
+             *  Retrieve the registry holding the compiled slug expressions
+             *
+             *  @return The registry, with statistics on the shared expressions
              */
-            using proxy_type = proxy<return_type(arguments...), first, rest...>;
+            const matcher_registry& matchers() const noexcept
+            {
+                return _paths.matchers();
+            }
 
             /**
-             *  Add an endpoint to the routing table, the callbacks
-             *  can be registered on the returned proxy
+             *  Retrieve the counters describing how endpoints were routed
              *
-             *  @param  endpoint    The path to add
+             *  This gives the hits, the candidates tried and the regular
+             *  expressions matched for every route, in the order they were
+             *  added, and a histogram of the time lookups took. Counting only
+             *  happens when ROUTER_INSTRUMENTATION is defined, otherwise the
+             *  snapshot is always empty and routing does not pay for it.
+             *
+             *  @return The counters, added up over all threads
              */
-            proxy_type& add(std::string_view endpoint)
+            router::statistics::snapshot statistics() const
             {
-                // add the endpoint to create a proxy
-                return _paths.add(endpoint);
+                return _paths.statistics();
+            }
+
+            /**
+             *  Set all routing counters back to zero
+             */
+            void reset_statistics() noexcept
+            {
+                _paths.reset_statistics();
             }
 
             /**
@@ -238,46 +325,93 @@ namespace router {
             }
 
             /**
-             *  Set a handler for endpoints without a method handler
+             *  Check whether a given endpoint can be routed
              *
-             *  @tparam callback    The callback to invoke
+             *  Note that this function ignores the not-found
+             *  handler, since this would otherwise make this
+             *  function return true unconditionally.
+             *
+             *  @param  endpoint    The endpoint to check
+             *  @return Whether the endpoint can be routed
              */
-            template <auto callback>
-            std::enable_if_t<!std::is_member_function_pointer_v<decltype(callback)>>
-            set_not_proxied()
+            bool routable(std::string_view endpoint) const noexcept
             {
-                // store the function pointer, there is no instance
-                _not_proxied_handler.template set<callback>();
+                // check whether a handler exists for the given endpoint
+                return match(endpoint).valid();
             }
 
             /**
-             *  Set a handler for endpoints without a method handler
+             *  Look up an endpoint, recording every route that is tried
              *
-             *  @tparam callback    The callback to invoke
-             *  @param  instance    The instance to invoke the callback on
+             *  This tells which routes were tried before the endpoint was
+             *  found, where each of them stopped matching, and how long it
+             *  took, which helps to find the routes that slow down lookups.
+             *  With the conversion check enabled, routes whose slugs cannot
+             *  be converted are skipped, and recorded with the conversion stage.
+             *
+             *  @param  endpoint    The endpoint to look up
+             *  @return The trace, with the index of the route found in the order they were added
              */
-            template <auto callback>
-            std::enable_if_t<std::is_member_function_pointer_v<decltype(callback)>>
-            set_not_proxied(typename function_traits<decltype(callback)>::member_type* instance)
+            trace explain(std::string_view endpoint) const
             {
-                // store the function pointer and instance
-                _not_proxied_handler.template set<callback>(instance);
+                // only the path is looked up, not the query
+                auto [path, parameters] = query::split(endpoint);
+
+                // without the conversion check, only the paths decide
+                if (!_check_conversions) {
+                    return _paths.explain(path);
+                }
+
+                // the slugs and their storage, the query is converted with them
+                slug_list           slugs;
+                impl::slug_storage  storage;
+
+                slugs.set_query(parameters);
+
+                // a route whose slugs cannot be converted did not match, like when routing
+                return _paths.explain(slugs, path, [&storage](const callback_type& callback, const slug_list& matched) {
+                    return callback.convert(matched, storage);
+                });
             }
 
             /**
-             *  Check whether a given endpoint can be routed
+             *  Find the callback for an endpoint without invoking it
              *
-             *  Note that this function ignores the not-found
-             *  handler, since this would otherwise make this
-             *  function return true unconditionally.
+             *  The returned match can be invoked later, possibly on
+             *  another thread, without having to look up the endpoint
+             *  again. Note that the not-found handler is not considered.
              *
-             *  @param  endpoint    The endpoint to check
-             *  @return Whether the endpoint can be routed
+             *  @param  endpoint    The endpoint to match, must outlive the match
+             *  @return The match, which is invalid if the endpoint was not found
              */
-            bool routable(std::string_view endpoint) const noexcept
+            match_type match(std::string_view endpoint) const noexcept
             {
-                // find the handler for the given endpoint
-                return _paths.find(slugs(), endpoint) != nullptr;
+                // the slug data matched from the endpoint
+                slug_list slugs;
+
+                // find the handler for the given endpoint, the slugs
+                // are converted again when the match is invoked
+                if (_check_conversions) {
+                    // the storage for the converted slugs, and whether any conversion failed
+                    impl::slug_storage  storage;
+                    bool                rejected{ false };
+
+                    if (auto* callback = find_converted(slugs, endpoint, storage, rejected); callback != nullptr) {
+                        return { *callback, slugs };
+                    }
+
+                    return {};
+                }
+
+                // split off the query, which is passed along with the slugs
+                auto [path, parameters] = query::split(endpoint);
+                slugs.set_query(parameters);
+
+                if (auto* callback = _paths.find(slugs, path); callback != nullptr) {
+                    return { *callback, slugs };
+                }
+
+                return {};
             }
 
             /**
@@ -299,33 +433,182 @@ namespace router {
              *  Route a request to one of the callbacks
              *
              *  @param  endpoint    The endpoint to route
-             *  @param  method      The method to proxy to
              *  @param  parameters  The arguments to give to the callback
              *  @return The result of the callback
-             *  @throws std::out_of_range If no matching route or not_found handler is found
+             *  @throws std::out_of_range If no matching route and no not_found handler is available
              */
-            return_type route(std::string_view endpoint, decltype(first) method,  arguments... parameters) const
+            return_type route(std::string_view endpoint, arguments... parameters) const
+            {
+                // should the slugs be converted while matching?
+                if (_check_conversions) {
+                    // the slug data matched from the endpoint, and the converted slugs
+                    slug_list           slugs;
+                    impl::slug_storage  storage;
+                    bool                rejected{ false };
+
+                    // invoke the handler with the slugs converted for it
+                    if (auto* callback = find_converted(slugs, endpoint, storage, rejected); callback != nullptr) {
+                        return callback->invoke(storage, std::forward<arguments>(parameters)...);
+                    }
+
+                    // no route could take the endpoint
+                    return dispatch(match_type{}, std::forward<arguments>(parameters)...);
+                }
+
+                // find the handler and invoke it
+                return dispatch(match(endpoint), std::forward<arguments>(parameters)...);
+            }
+
+            /**
+             *  Find the callback for an endpoint, without throwing
+             *
+             *  @param  endpoint    The endpoint to match, must outlive the match
+             *  @return The match, or status::not_found
+             */
+            result<match_type> try_match(std::string_view endpoint) const noexcept
             {
                 // find the handler for the given endpoint
-                if (auto proxy = _paths.find(slugs(), endpoint); proxy != nullptr) {
-                    // do we have a handler for the method
-                    if (proxy->get(method).valid()) {
-                        // invoke the callback
-                        return proxy->get(method)(slugs(), std::forward<arguments>(parameters)...);
-                    } else if (_not_proxied_handler.valid()) {
-                        // invoke the missing-method handler
-                        return _not_proxied_handler({}, std::forward<arguments>(parameters)...);
+                if (auto handler = match(endpoint); handler.valid()) {
+                    return handler;
+                }
+
+                return status::not_found;
+            }
+
+            /**
+             *  Route a request to one of the callbacks, without throwing
+             *
+             *  Unlike route(), this does not invoke the not_found handler,
+             *  and slugs that cannot be converted for the callback are
+             *  reported instead of throwing an exception. Exceptions thrown
+             *  by the callback itself are not caught.
+             *
+             *  @param  endpoint    The endpoint to route
+             *  @param  parameters  The arguments to give to the callback
+             *  @return The result of the callback, status::not_found if no route
+             *          matches or status::conversion_failed for invalid slugs
+             */
+            result<return_type> try_route(std::string_view endpoint, arguments... parameters) const
+            {
+                // should the slugs be converted while matching?
+                if (_check_conversions) {
+                    // the slug data matched from the endpoint, and the converted slugs
+                    slug_list           slugs;
+                    impl::slug_storage  storage;
+                    bool                rejected{ false };
+
+                    // find a handler that takes the slugs
+                    auto* callback = find_converted(slugs, endpoint, storage, rejected);
+
+                    // a route that matched, but could not take the slugs, is reported as such
+                    if (callback == nullptr) {
+                        return rejected ? status::conversion_failed : status::not_found;
+                    }
+
+                    // a callback without a result only reports success
+                    if constexpr (std::is_void_v<return_type>) {
+                        callback->invoke(storage, std::forward<arguments>(parameters)...);
+                        return status::ok;
+                    } else {
+                        return callback->invoke(storage, std::forward<arguments>(parameters)...);
                     }
                 }
 
-                // do we have a handler for endpoints that aren't registered
-                if (_not_found_handler) {
-                    // invoke the handler
-                    return _not_found_handler({}, std::forward<arguments>(parameters)...);
+                // find the handler and try to invoke it
+                return match(endpoint).try_invoke(std::forward<arguments>(parameters)...);
+            }
+
+            /**
+             *  Find the callbacks for a batch of endpoints
+             *
+             *  This gives the same results as calling match() for every
+             *  endpoint. The endpoints are looked up in chunks of 64: the
+             *  hashes for the exact match lookups of a chunk are calculated
+             *  first, and their slots are prefetched together, so the memory
+             *  accesses for these lookups overlap. Endpoints that need a route
+             *  with slugs are then matched one by one, like match() does.
+             *
+             *  @param  iter    Iterator to the first endpoint, all endpoints must outlive the matches
+             *  @param  last    Iterator past the last endpoint
+             *  @param  output  Iterator to write the matches to
+             *  @return Iterator past the last written match
+             */
+            template <class input_iterator, class output_iterator>
+            output_iterator match_batch(input_iterator iter, input_iterator last, output_iterator output) const
+            {
+                // the matches for a single chunk
+                std::array<match_type, batch_size> matches;
+
+                // process the endpoints chunk by chunk
+                while (iter != last) {
+                    // match the chunk and write the results
+                    for (std::size_t i{ 0 }, count{ match_chunk(iter, last, matches.data()) }; i < count; ++i) {
+                        *output++ = matches[i];
+                    }
                 }
 
-                // none of the paths matched
-                throw std::out_of_range{ "Route not matched" };
+                return output;
+            }
+
+            /**
+             *  Route a batch of requests to their callbacks
+             *
+             *  The endpoints are matched in chunks, like match_batch(), after
+             *  which the callbacks are invoked in the order of the endpoints.
+             *  When an endpoint cannot be routed, the exception is thrown after
+             *  the callbacks for the earlier endpoints have been invoked.
+             *
+             *  @param  iter        Iterator to the first endpoint
+             *  @param  last        Iterator past the last endpoint
+             *  @param  parameters  Iterator to the tuple of arguments for the first callback
+             *  @param  output      Iterator to write the results to
+             *  @return Iterator past the last written result
+             *  @throws std::out_of_range If no matching route and no not_found handler is available
+             */
+            template <class input_iterator, class argument_iterator, class output_iterator, class result = return_type>
+            std::enable_if_t<!std::is_void_v<result>, output_iterator>
+            route_batch(input_iterator iter, input_iterator last, argument_iterator parameters, output_iterator output) const
+            {
+                // the matches for a single chunk
+                std::array<match_type, batch_size> matches;
+
+                // process the endpoints chunk by chunk
+                while (iter != last) {
+                    // match the chunk and invoke the callbacks
+                    for (std::size_t i{ 0 }, count{ match_chunk(iter, last, matches.data()) }; i < count; ++i, ++parameters) {
+                        *output++ = std::apply([this, &matches, i](auto&&... values) {
+                            return dispatch(matches[i], std::forward<decltype(values)>(values)...);
+                        }, *parameters);
+                    }
+                }
+
+                return output;
+            }
+
+            /**
+             *  Route a batch of requests to callbacks without a result
+             *
+             *  @param  iter        Iterator to the first endpoint
+             *  @param  last        Iterator past the last endpoint
+             *  @param  parameters  Iterator to the tuple of arguments for the first callback
+             *  @throws std::out_of_range If no matching route and no not_found handler is available
+             */
+            template <class input_iterator, class argument_iterator, class result = return_type>
+            std::enable_if_t<std::is_void_v<result>>
+            route_batch(input_iterator iter, input_iterator last, argument_iterator parameters) const
+            {
+                // the matches for a single chunk
+                std::array<match_type, batch_size> matches;
+
+                // process the endpoints chunk by chunk
+                while (iter != last) {
+                    // match the chunk and invoke the callbacks
+                    for (std::size_t i{ 0 }, count{ match_chunk(iter, last, matches.data()) }; i < count; ++i, ++parameters) {
+                        std::apply([this, &matches, i](auto&&... values) {
+                            dispatch(matches[i], std::forward<decltype(values)>(values)...);
+                        }, *parameters);
+                    }
+                }
             }
         private:
             /**
@@ -334,24 +617,867 @@ namespace router {
             using callback_type = path_callback<return_type(arguments...)>;
 
             /**
-             *  Retrieve the slug data
-             *
-             *  @note   This data is stored locally per thread to ensure
-             *          that the table remains thread-safe, and can re-use
-             *          allocated data between calls.
+             *  The number of endpoints looked up together
+             */
+            constexpr static std::size_t batch_size = 64;
+
+            /**
+             *  Match the next chunk of endpoints
              *
-             *  @return The slug data
+             *  @param  iter    Iterator to the first endpoint, advanced past the chunk
+             *  @param  last    Iterator past the last endpoint
+             *  @param  matches The matches to fill, room for batch_size matches
+             *  @return The number of matches written
              */
-            static std::vector<std::string_view>& slugs() noexcept
+            template <class input_iterator>
+            std::size_t match_chunk(input_iterator& iter, input_iterator last, match_type* matches) const
             {
-                // the slugs to cache
-                thread_local std::vector<std::string_view> slugs;
-                return slugs;
+                // the endpoints, slugs and callbacks for the chunk
+                std::array<std::string_view, batch_size>        endpoints;
+                std::array<slug_list, batch_size>               slugs;
+                std::array<const callback_type*, batch_size>    callbacks;
+
+                // the number of endpoints in the chunk
+                std::size_t count{ 0 };
+
+                // the candidates are checked one by one when converting the slugs
+                if (_check_conversions) {
+                    for (; count < batch_size && iter != last; ++iter) {
+                        matches[count++] = match(*iter);
+                    }
+
+                    return count;
+                }
+
+                // collect the endpoints in the chunk
+                for (; count < batch_size && iter != last; ++iter, ++count) {
+                    // only the path is looked up, the query goes with the slugs
+                    auto [path, parameters] = query::split(*iter);
+
+                    endpoints[count] = path;
+                    slugs[count].set_query(parameters);
+                }
+
+                // look up all the endpoints together
+                _paths.find_batch(endpoints.data(), count, slugs.data(), callbacks.data());
+
+                // create the matches for the found callbacks
+                for (std::size_t i{ 0 }; i < count; ++i) {
+                    matches[i] = callbacks[i] == nullptr ? match_type{} : match_type{ *callbacks[i], slugs[i] };
+                }
+
+                return count;
+            }
+
+            /**
+             *  Find the callback for an endpoint that can take the slugs
+             *
+             *  @param  slugs       The slugs to fill if found
+             *  @param  endpoint    The endpoint to lookup
+             *  @param  storage     The storage for the slugs converted for the callback
+             *  @param  rejected    Set when a route matched, but could not take the slugs
+             *  @return The callback, or a nullptr
+             */
+            const callback_type* find_converted(slug_list& slugs, std::string_view endpoint, impl::slug_storage& storage, bool& rejected) const
+            {
+                // split off the query, so it can be converted together with the slugs
+                auto [path, parameters] = query::split(endpoint);
+                slugs.set_query(parameters);
+
+                return _paths.find(slugs, path, [&storage, &rejected](const callback_type& callback, const slug_list& matched) {
+                    // a route whose slugs cannot be converted did not match
+                    if (!callback.convert(matched, storage)) {
+                        rejected = true;
+                        return false;
+                    }
+
+                    return true;
+                });
+            }
+
+            /**
+             *  Invoke the callback for a match
+             *
+             *  @param  handler     The matched handler
+             *  @param  parameters  The arguments to give to the callback
+             *  @return The result of the callback
+             *  @throws std::out_of_range If the match is invalid and no not_found handler is available
+             */
+            return_type dispatch(const match_type& handler, arguments... parameters) const
+            {
+                // did we find a handler for the endpoint
+                if (handler.valid()) {
+                    // invoke the callback
+                    return handler(std::forward<arguments>(parameters)...);
+                }
+
+                // do we have a handler for endpoints that aren't registered
+                if (_not_found_handler) {
+                    // invoke the handler
+                    return _not_found_handler({}, std::forward<arguments>(parameters)...);
+                }
+
+                // none of the paths matched
+                impl::fail<std::out_of_range>("Route not matched");
+            }
+
+            path_map<callback_type> _paths;                         // all registered paths in the table
+            callback_type           _not_found_handler;             // the optional handler for paths not found
+            bool                    _check_conversions{ false };    // whether the slugs are converted while matching
+    };
+
+    /**
+     *  A routing table, containing paths to route and mapping
+     *  them to a proxy for further processing
+     */
+    template <class return_type, class... arguments, auto first, decltype(first)... rest>
+    class table<proxy<return_type(arguments...), first, rest...>>
+    {
+        public:
+            /**
+             *  The proxy we route to
+             */
+            using proxy_type = proxy<return_type(arguments...), first, rest...>;
+
+            /**
+             *  The result of matching an endpoint
+             */
+            using match_type = route_match<proxy_type>;
+
+            /**
+             *  A route to add with add_all()
+             */
+            using route_type = std::pair<std::string_view, proxy_type>;
+
+            /**
+             *  A set of methods, as passed to the handlers for methods that are not proxied
+             */
+            using method_set_type = typename proxy_type::method_set_type;
+
+            /**
+             *  Add an endpoint to the routing table, the callbacks
+             *  can be registered on the returned proxy
+             *
+             *  @param  endpoint    The path to add
+             */
+            proxy_type& add(std::string_view endpoint)
+            {
+                // add the endpoint to create a proxy
+                return _paths.add(endpoint);
+            }
+
+            /**
+             *  Add many endpoints to the routing table at once
+             *
+             *  This gives the same result as adding the routes one by one
+             *  in the given order, but is faster for large numbers of routes.
+             *  Every route consists of the path and the proxy to route to.
+             *
+             *  @param  iter    Iterator to the first route to add
+             *  @param  last    Iterator past the last route to add
+             */
+            template <class input_iterator>
+            void add_all(input_iterator iter, input_iterator last)
+            {
+                _paths.add_all(iter, last);
+            }
+
+            /**
+             *  Add many endpoints to the routing table at once, compiling
+             *  the slug patterns in parallel on the given executor
+             *
+             *  The routes are added in the given order, and if any route
+             *  is invalid, the error for the first invalid route is thrown
+             *  and no route is added, no matter the order the tasks ran in.
+             *
+             *  @param  iter    Iterator to the first route to add
+             *  @param  last    Iterator past the last route to add
+             *  @param  execute Callable that runs the given std::function<void()> task, on any thread
+             *  @param  tasks   The number of tasks to divide the work over
+             */
+            template <class forward_iterator, class executor>
+            std::enable_if_t<std::is_invocable_v<executor&, std::function<void()>>>
+            add_all(forward_iterator iter, forward_iterator last, executor&& execute, std::size_t tasks = std::thread::hardware_concurrency())
+            {
+                _paths.add_all(iter, last, std::forward<executor>(execute), tasks);
+            }
+
+            /**
+             *  Add many endpoints to the routing table at once, compiling
+             *  the slug patterns in parallel on the given number of threads
+             *
+             *  @param  iter    Iterator to the first route to add
+             *  @param  last    Iterator past the last route to add
+             *  @param  threads The number of threads to use
+             */
+            template <class forward_iterator>
+            void add_all(forward_iterator iter, forward_iterator last, std::size_t threads)
+            {
+                _paths.add_all(iter, last, threads);
+            }
+
+            /**
+             *  Add many endpoints to the routing table at once
+             *
+             *  @param  routes  The routes to add, in order
+             */
+            void add_all(std::initializer_list<route_type> routes)
+            {
+                _paths.add_all(routes.begin(), routes.end());
+            }
+
+            /**
+             *  Compile all routes into a single automaton
+             *
+             *  This should be called after all routes were added. Lookups
+             *  then walk over the endpoint once, instead of trying all the
+             *  candidate routes one by one. Routes using a regular expression
+             *  for their slugs cannot be compiled, in which case the table
+             *  keeps working as before. Adding a route discards the automaton.
+             *
+             *  @param  max_states  The maximum number of states in the automaton
+             *  @return Whether the routes were compiled
+             */
+            bool compile(std::size_t max_states = 1 << 16)
+            {
+                return _paths.compile(max_states);
+            }
+
+            /**
+             *  Freeze the routes into a compact layout
+             *
+             *  This should be called after all routes were added. All routes
+             *  are copied into a few contiguous arrays, so routing touches less
+             *  memory. Routing gives the same results as before. Adding a route
+             *  discards the frozen layout again.
+             */
+            void freeze()
+            {
+                _paths.freeze();
+            }
+
+            /**
+             *  Cache the routes found for endpoints
+             *
+             *  When most requests go to a small number of endpoints, caching
+             *  them avoids matching the routes over and over again. Routing
+             *  remains safe to do from multiple threads. Adding a route empties
+             *  the cache, since the endpoints may now be routed elsewhere.
+             *
+             *  @param  capacity    The number of endpoints to cache, zero disables the cache
+             */
+            void enable_cache(std::size_t capacity)
+            {
+                _paths.enable_cache(capacity);
+            }
+
+            /**
+             *  Get the number of endpoints that were found in the cache
+             *
+             *  @return The number of cache hits
+             */
+            std::size_t cache_hits() const noexcept
+            {
+                return _paths.cache() ? _paths.cache()->hits() : 0;
+            }
+
+            /**
+             *  Get the number of endpoints that were not found in the cache
+             *
+             *  @return The number of cache misses
+             */
+            std::size_t cache_misses() const noexcept
+            {
+                return _paths.cache() ? _paths.cache()->misses() : 0;
+            }
+
+            /**
+             *  Share the compiled slug expressions with other tables
+             *
+             *  Slugs with the same pattern share a single compiled regular
+             *  expression. By default this is only done within the table,
+             *  routes added after this share them with all tables using the
+             *  same registry, even when these are built on other threads.
+             *
+             *  @param  registry    The registry to use, or a nullptr for a new registry
+             */
+            void share_matchers(std::shared_ptr<matcher_registry> registry)
+            {
+                _paths.share_matchers(std::move(registry));
+            }
+
+            /**
+             *  Retrieve the registry holding the compiled slug expressions
+             *
+             *  @return The registry, with statistics on the shared expressions
+             */
+            const matcher_registry& matchers() const noexcept
+            {
+                return _paths.matchers();
+            }
+
+            /**
+             *  Retrieve the counters describing how endpoints were routed
+             *
+             *  This gives the hits, the candidates tried and the regular
+             *  expressions matched for every route, in the order they were
+             *  added, and a histogram of the time lookups took. Counting only
+             *  happens when ROUTER_INSTRUMENTATION is defined, otherwise the
+             *  snapshot is always empty and routing does not pay for it.
+             *
+             *  @return The counters, added up over all threads
+             */
+            router::statistics::snapshot statistics() const
+            {
+                return _paths.statistics();
+            }
+
+            /**
+             *  Set all routing counters back to zero
+             */
+            void reset_statistics() noexcept
+            {
+                _paths.reset_statistics();
+            }
+
+            /**
+             *  Set a handler for endpoints that are not found
+             *
+             *  @tparam callback    The callback to route to
+             */
+            template <auto callback>
+            std::enable_if_t<!std::is_member_function_pointer_v<decltype(callback)>>
+            set_not_found()
+            {
+                // store the function pointer, there is no instance
+                _not_found_handler.template set<callback>();
+            }
+
+            /**
+             *  Set a handler for endpoints that are not found
+             *
+             *  @tparam callback    The callback to route to
+             *  @param  instance    The instance to invoke the callback on
+             */
+            template <auto callback>
+            std::enable_if_t<std::is_member_function_pointer_v<decltype(callback)>>
+            set_not_found(typename function_traits<decltype(callback)>::member_type* instance)
+            {
+                // store the function pointer and instance
+                _not_found_handler.template set<callback>(instance);
+            }
+
+            /**
+             *  Set a handler for endpoints without a method handler
+             *
+             *  The handler may take the set of methods the endpoint does have
+             *  a handler for as an extra, final, parameter. This includes the
+             *  methods handled by a fallback or by the options handler, so it
+             *  can fill an Allow header without looking up the endpoint again.
+             *
+             *  @tparam callback    The callback to invoke
+             */
+            template <auto callback>
+            std::enable_if_t<!std::is_member_function_pointer_v<decltype(callback)>>
+            set_not_proxied()
+            {
+                // store the function pointer, there is no instance
+                if constexpr (takes_methods<callback>()) {
+                    _not_allowed_handler.template set<callback>();
+                    _not_proxied_handler = {};
+                } else {
+                    _not_proxied_handler.template set<callback>();
+                    _not_allowed_handler = {};
+                }
+            }
+
+            /**
+             *  Set a handler for endpoints without a method handler
+             *
+             *  @tparam callback    The callback to invoke
+             *  @param  instance    The instance to invoke the callback on
+             */
+            template <auto callback>
+            std::enable_if_t<std::is_member_function_pointer_v<decltype(callback)>>
+            set_not_proxied(typename function_traits<decltype(callback)>::member_type* instance)
+            {
+                // store the function pointer and instance
+                if constexpr (takes_methods<callback>()) {
+                    _not_allowed_handler.template set<callback>(instance);
+                    _not_proxied_handler = {};
+                } else {
+                    _not_proxied_handler.template set<callback>(instance);
+                    _not_allowed_handler = {};
+                }
+            }
+
+            /**
+             *  Route a method to the handler of another method, for endpoints
+             *  without a handler for the method itself, like HEAD to GET
+             *
+             *  @tparam method  The method to route elsewhere
+             *  @tparam target  The method whose handler to use
+             */
+            template <decltype(first) method, decltype(first) target>
+            void set_fallback() noexcept
+            {
+                // the index of the method to route elsewhere
+                constexpr auto index = lookup::find(method);
+                static_assert(index != lookup::npos, "Method is not proxied");
+                static_assert(lookup::find(target) != lookup::npos, "Method is not proxied");
+
+                // store the target for the method
+                _routing.set_fallback(index, target);
+            }
+
+            /**
+             *  Set a handler answering a method for endpoints without a handler
+             *  for it, like OPTIONS, the handler takes the set of methods the
+             *  endpoint handles as an extra, final, parameter
+             *
+             *  @tparam method      The method to answer
+             *  @tparam callback    The callback to invoke
+             */
+            template <decltype(first) method, auto callback>
+            std::enable_if_t<!std::is_member_function_pointer_v<decltype(callback)>>
+            set_options()
+            {
+                // store the method and the function pointer, there is no instance
+                _routing.set_options(options_index<method>());
+                _options_handler.template set<callback>();
+            }
+
+            /**
+             *  Set a handler answering a method for endpoints without a handler
+             *  for it, like OPTIONS, the handler takes the set of methods the
+             *  endpoint handles as an extra, final, parameter
+             *
+             *  @tparam method      The method to answer
+             *  @tparam callback    The callback to invoke
+             *  @param  instance    The instance to invoke the callback on
+             */
+            template <decltype(first) method, auto callback>
+            std::enable_if_t<std::is_member_function_pointer_v<decltype(callback)>>
+            set_options(typename function_traits<decltype(callback)>::member_type* instance)
+            {
+                // store the method, the function pointer and the instance
+                _routing.set_options(options_index<method>());
+                _options_handler.template set<callback>(instance);
+            }
+
+            /**
+             *  Check whether a given endpoint can be routed
+             *
+             *  Note that this function ignores the not-found
+             *  handler, since this would otherwise make this
+             *  function return true unconditionally.
+             *
+             *  @param  endpoint    The endpoint to check
+             *  @return Whether the endpoint can be routed
+             */
+            bool routable(std::string_view endpoint) const noexcept
+            {
+                // check whether a proxy exists for the given endpoint
+                return match(endpoint).valid();
+            }
+
+            /**
+             *  Look up an endpoint, recording every route that is tried
+             *
+             *  This tells which routes were tried before the endpoint was
+             *  found, where each of them stopped matching, and how long it
+             *  took, which helps to find the routes that slow down lookups.
+             *
+             *  @param  endpoint    The endpoint to look up
+             *  @return The trace, with the index of the route found in the order they were added
+             */
+            trace explain(std::string_view endpoint) const
+            {
+                // only the path is looked up, not the query
+                return _paths.explain(query::split(endpoint).first);
+            }
+
+            /**
+             *  Find the proxy for an endpoint without invoking it
+             *
+             *  The returned match can be invoked later, possibly on
+             *  another thread, without having to look up the endpoint
+             *  again. The table may not be modified while it is used.
+             *
+             *  @param  endpoint    The endpoint to match, must outlive the match
+             *  @return The match, which is invalid if the endpoint was not found
+             */
+            match_type match(std::string_view endpoint) const noexcept
+            {
+                // the slug data matched from the endpoint
+                slug_list slugs;
+
+                // split off the query, which is passed along with the slugs
+                auto [path, parameters] = query::split(endpoint);
+                slugs.set_query(parameters);
+
+                // find the proxy for the given path
+                if (auto* proxy = _paths.find(slugs, path); proxy != nullptr) {
+                    return { proxy, slugs, &_routing };
+                }
+
+                return {};
+            }
+
+            /**
+             *  Check whether a fallback handler is installed
+             *
+             *  If a fallback handler is installed and no endpoint is
+             *  available when routing, the fallback handler is used.
+             *  This also means that routing will never fail due to a
+             *  missing endpoint.
+             *
+             *  @return Whether a fallback handler is installed
+             */
+            bool has_not_found_handler() const noexcept
+            {
+                return _not_found_handler.valid();
+            }
+
+            /**
+             *  Route a request to one of the callbacks
+             *
+             *  @param  endpoint    The endpoint to route
+             *  @param  method      The method to proxy to
+             *  @param  parameters  The arguments to give to the callback
+             *  @return The result of the callback
+             *  @throws std::out_of_range If no matching route or not_found handler is found
+             */
+            return_type route(std::string_view endpoint, decltype(first) method,  arguments... parameters) const
+            {
+                // find the proxy and invoke the method
+                return dispatch(match(endpoint), method, std::forward<arguments>(parameters)...);
+            }
+
+            /**
+             *  Find the proxy for an endpoint, without throwing
+             *
+             *  @param  endpoint    The endpoint to match, must outlive the match
+             *  @return The match, or status::not_found
+             */
+            result<match_type> try_match(std::string_view endpoint) const noexcept
+            {
+                // find the proxy for the given endpoint
+                if (auto proxy = match(endpoint); proxy.valid()) {
+                    return proxy;
+                }
+
+                return status::not_found;
+            }
+
+            /**
+             *  Route a request to one of the callbacks, without throwing
+             *
+             *  Fallbacks and the options handler are used like with route(),
+             *  but instead of invoking the not_found, not_allowed or not_proxied
+             *  handlers, the failure is reported. Slugs that cannot be converted
+             *  for the callback are reported instead of throwing an exception.
+             *  Exceptions thrown by the callback itself are not caught.
+             *
+             *  @param  endpoint    The endpoint to route
+             *  @param  method      The method to proxy to
+             *  @param  parameters  The arguments to give to the callback
+             *  @return The result of the callback, status::not_found if no route matches,
+             *          status::method_not_allowed if the method is not handled for the
+             *          route or status::conversion_failed for invalid slugs
+             */
+            result<return_type> try_route(std::string_view endpoint, decltype(first) method, arguments... parameters) const
+            {
+                // find the proxy for the endpoint
+                auto proxy = match(endpoint);
+
+                // did we find a proxy for the endpoint
+                if (!proxy.valid()) {
+                    return status::not_found;
+                }
+
+                // do we have a handler for the method
+                if (proxy.valid(method)) {
+                    // invoke the callback
+                    return proxy.try_invoke(method, std::forward<arguments>(parameters)...);
+                }
+
+                // the index of the method, to find the alternatives
+                auto index = lookup::find(method);
+
+                // is the method routed to the handler of another method?
+                if (_routing.has_fallback(index) && proxy.valid(_routing.fallback(index))) {
+                    // invoke the callback of the other method
+                    return proxy.try_invoke(_routing.fallback(index), std::forward<arguments>(parameters)...);
+                }
+
+                // is the method answered from the allowed methods?
+                if (_routing.options(index) && _options_handler.valid()) {
+                    // invoke the options handler
+                    return _options_handler.try_call({}, std::forward<arguments>(parameters)..., proxy.allowed());
+                }
+
+                #if defined(ROUTER_INSTRUMENTATION)
+                    // the endpoint is routed, but not for this method
+                    _paths.counters().not_proxied();
+                #endif
+
+                return status::method_not_allowed;
+            }
+
+            /**
+             *  Find the proxies for a batch of endpoints
+             *
+             *  This gives the same results as calling match() for every
+             *  endpoint. The endpoints are looked up in chunks of 64: the
+             *  hashes for the exact match lookups of a chunk are calculated
+             *  first, and their slots are prefetched together, so the memory
+             *  accesses for these lookups overlap. Endpoints that need a route
+             *  with slugs are then matched one by one, like match() does.
+             *
+             *  @param  iter    Iterator to the first endpoint, all endpoints must outlive the matches
+             *  @param  last    Iterator past the last endpoint
+             *  @param  output  Iterator to write the matches to
+             *  @return Iterator past the last written match
+             */
+            template <class input_iterator, class output_iterator>
+            output_iterator match_batch(input_iterator iter, input_iterator last, output_iterator output) const
+            {
+                // the matches for a single chunk
+                std::array<match_type, batch_size> matches;
+
+                // process the endpoints chunk by chunk
+                while (iter != last) {
+                    // match the chunk and write the results
+                    for (std::size_t i{ 0 }, count{ match_chunk(iter, last, matches.data()) }; i < count; ++i) {
+                        *output++ = matches[i];
+                    }
+                }
+
+                return output;
+            }
+
+            /**
+             *  Route a batch of requests to their callbacks
+             *
+             *  The endpoints are matched in chunks, like match_batch(), after
+             *  which the callbacks are invoked in the order of the endpoints.
+             *  Every tuple of arguments starts with the method to proxy to.
+             *  When an endpoint cannot be routed, the exception is thrown after
+             *  the callbacks for the earlier endpoints have been invoked.
+             *
+             *  @param  iter        Iterator to the first endpoint
+             *  @param  last        Iterator past the last endpoint
+             *  @param  parameters  Iterator to the tuple of method and arguments for the first callback
+             *  @param  output      Iterator to write the results to
+             *  @return Iterator past the last written result
+             *  @throws std::out_of_range If no matching route or not_found handler is found
+             */
+            template <class input_iterator, class argument_iterator, class output_iterator, class result = return_type>
+            std::enable_if_t<!std::is_void_v<result>, output_iterator>
+            route_batch(input_iterator iter, input_iterator last, argument_iterator parameters, output_iterator output) const
+            {
+                // the matches for a single chunk
+                std::array<match_type, batch_size> matches;
+
+                // process the endpoints chunk by chunk
+                while (iter != last) {
+                    // match the chunk and invoke the callbacks
+                    for (std::size_t i{ 0 }, count{ match_chunk(iter, last, matches.data()) }; i < count; ++i, ++parameters) {
+                        *output++ = std::apply([this, &matches, i](auto&&... values) {
+                            return dispatch(matches[i], std::forward<decltype(values)>(values)...);
+                        }, *parameters);
+                    }
+                }
+
+                return output;
+            }
+
+            /**
+             *  Route a batch of requests to callbacks without a result
+             *
+             *  @param  iter        Iterator to the first endpoint
+             *  @param  last        Iterator past the last endpoint
+             *  @param  parameters  Iterator to the tuple of method and arguments for the first callback
+             *  @throws std::out_of_range If no matching route or not_found handler is found
+             */
+            template <class input_iterator, class argument_iterator, class result = return_type>
+            std::enable_if_t<std::is_void_v<result>>
+            route_batch(input_iterator iter, input_iterator last, argument_iterator parameters) const
+            {
+                // the matches for a single chunk
+                std::array<match_type, batch_size> matches;
+
+                // process the endpoints chunk by chunk
+                while (iter != last) {
+                    // match the chunk and invoke the callbacks
+                    for (std::size_t i{ 0 }, count{ match_chunk(iter, last, matches.data()) }; i < count; ++i, ++parameters) {
+                        std::apply([this, &matches, i](auto&&... values) {
+                            dispatch(matches[i], std::forward<decltype(values)>(values)...);
+                        }, *parameters);
+                    }
+                }
+            }
+        private:
+            /**
+             *  Alias for the callback type used by the routing table
+             */
+            using callback_type = path_callback<return_type(arguments...)>;
+
+            /**
+             *  The number of endpoints looked up together
+             */
+            constexpr static std::size_t batch_size = 64;
+
+            /**
+             *  Match the next chunk of endpoints
+             *
+             *  @param  iter    Iterator to the first endpoint, advanced past the chunk
+             *  @param  last    Iterator past the last endpoint
+             *  @param  matches The matches to fill, room for batch_size matches
+             *  @return The number of matches written
+             */
+            template <class input_iterator>
+            std::size_t match_chunk(input_iterator& iter, input_iterator last, match_type* matches) const
+            {
+                // the endpoints, slugs and proxies for the chunk
+                std::array<std::string_view, batch_size>    endpoints;
+                std::array<slug_list, batch_size>           slugs;
+                std::array<const proxy_type*, batch_size>   proxies;
+
+                // collect the endpoints in the chunk
+                std::size_t count{ 0 };
+
+                for (; count < batch_size && iter != last; ++iter, ++count) {
+                    // only the path is looked up, the query goes with the slugs
+                    auto [path, parameters] = query::split(*iter);
+
+                    endpoints[count] = path;
+                    slugs[count].set_query(parameters);
+                }
+
+                // look up all the endpoints together
+                _paths.find_batch(endpoints.data(), count, slugs.data(), proxies.data());
+
+                // create the matches for the found proxies
+                for (std::size_t i{ 0 }; i < count; ++i) {
+                    matches[i] = { proxies[i], slugs[i], &_routing };
+                }
+
+                return count;
+            }
+
+            /**
+             *  The lookup for the method indices
+             */
+            using lookup = variadic_index<first, rest...>;
+
+            /**
+             *  Alias for handlers taking the set of allowed methods
+             */
+            using methods_callback_type = path_callback<return_type(arguments..., method_set_type)>;
+
+            /**
+             *  Check whether a callback takes the set of allowed methods
+             *
+             *  @tparam callback    The callback to check
+             *  @return Whether the final parameter is a method set
+             */
+            template <auto callback>
+            constexpr static bool takes_methods() noexcept
+            {
+                // the traits for the callback
+                using traits = function_traits<decltype(callback)>;
+
+                // the method set comes after the regular arguments
+                if constexpr (traits::arity == sizeof...(arguments) + 1) {
+                    return std::is_same_v<std::decay_t<typename traits::template argument_type<sizeof...(arguments)>>, method_set_type>;
+                } else {
+                    return false;
+                }
+            }
+
+            /**
+             *  Get the index of the method to answer with the options handler
+             *
+             *  @tparam method  The method to answer
+             *  @return The index of the method
+             */
+            template <decltype(first) method>
+            constexpr static std::size_t options_index() noexcept
+            {
+                // the index of the method
+                constexpr auto index = lookup::find(method);
+                static_assert(index != lookup::npos, "Method is not proxied");
+
+                return index;
+            }
+
+            /**
+             *  Invoke the callback for a matched proxy
+             *
+             *  @param  proxy       The matched proxy
+             *  @param  method      The method to proxy to
+             *  @param  parameters  The arguments to give to the callback
+             *  @return The result of the callback
+             *  @throws std::out_of_range If no matching route or not_found handler is found
+             */
+            return_type dispatch(const match_type& proxy, decltype(first) method, arguments... parameters) const
+            {
+                // did we find a proxy for the endpoint
+                if (proxy.valid()) {
+                    // do we have a handler for the method
+                    if (proxy.valid(method)) {
+                        // invoke the callback
+                        return proxy(method, std::forward<arguments>(parameters)...);
+                    }
+
+                    // the index of the method, to find the alternatives
+                    auto index = lookup::find(method);
+
+                    // is the method routed to the handler of another method?
+                    if (_routing.has_fallback(index) && proxy.valid(_routing.fallback(index))) {
+                        // invoke the callback of the other method
+                        return proxy(_routing.fallback(index), std::forward<arguments>(parameters)...);
+                    }
+
+                    // is the method answered from the allowed methods?
+                    if (_routing.options(index) && _options_handler.valid()) {
+                        // invoke the options handler
+                        return _options_handler({}, std::forward<arguments>(parameters)..., proxy.allowed());
+                    }
+
+                    #if defined(ROUTER_INSTRUMENTATION)
+                        // the endpoint is routed, but not for this method
+                        _paths.counters().not_proxied();
+                    #endif
+
+                    // do we have a handler for the missing method?
+                    if (_not_allowed_handler.valid()) {
+                        // invoke the missing-method handler with the allowed methods
+                        return _not_allowed_handler({}, std::forward<arguments>(parameters)..., proxy.allowed());
+                    } else if (_not_proxied_handler.valid()) {
+                        // invoke the missing-method handler
+                        return _not_proxied_handler({}, std::forward<arguments>(parameters)...);
+                    }
+                }
+
+                // do we have a handler for endpoints that aren't registered
+                if (_not_found_handler) {
+                    // invoke the handler
+                    return _not_found_handler({}, std::forward<arguments>(parameters)...);
+                }
+
+                // none of the paths matched
+                impl::fail<std::out_of_range>("Route not matched");
             }
 
-            path_map<proxy_type>    _paths;                 // all registered paths in the table
-            callback_type           _not_found_handler;     // the optional handler for paths not found
-            callback_type           _not_proxied_handler;   // the optional handler for when a method is not proxied
+            path_map<proxy_type>                                    _paths;                         // all registered paths in the table
+            callback_type                                           _not_found_handler;             // the optional handler for paths not found
+            callback_type                                           _not_proxied_handler;           // the optional handler for when a method is not proxied
+            methods_callback_type                                   _not_allowed_handler;           // the same handler, when it takes the allowed methods
+            methods_callback_type                                   _options_handler;               // the optional handler answering the options method
+            impl::method_routing<first, rest...>                    _routing;                       // the fallbacks and the options method
     };
 
 }
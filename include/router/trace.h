@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string_view>
+#include <chrono>
+#include <vector>
+#include <cstddef>
+
+
+namespace router {
+
+    /**
+     *  A description of how an endpoint was looked up
+     *
+     *  This lists every route that was tried, in order, together with
+     *  the reason it did not match and the time it took to find out.
+     *  It helps finding the routes that make a lookup slow.
+     */
+    struct trace
+    {
+        /**
+         *  Value for a lookup that found no route
+         */
+        constexpr static std::size_t npos = static_cast<std::size_t>(-1);
+
+        /**
+         *  The part of a route where matching stopped
+         */
+        enum class stage
+        {
+            matched,    // the route matched the endpoint
+            prefix,     // the endpoint does not start with the prefix
+            slug,       // a slug did not match
+            suffix,     // the literal data after a slug did not match
+            trailing,   // the endpoint continues after the route ended
+            conversion  // the route matched, but its slugs could not be converted
+        };
+
+        /**
+         *  A route that was tried
+         */
+        struct candidate
+        {
+            std::size_t                 route       {};                 // the index of the route, in the order it was added
+            std::string_view            prefix      {};                 // the literal prefix of the route
+            stage                       failed      { stage::matched }; // where matching stopped
+            std::size_t                 slug        {};                 // the slug that failed, or that is followed by the failing suffix
+            std::size_t                 consumed    {};                 // the number of characters of the endpoint that matched
+            std::chrono::nanoseconds    time        {};                 // the time it took to try the route
+        };
+
+        std::size_t                 route       { npos };   // the route found, or npos
+        bool                        exact       { false };  // whether the route was found without trying any candidates
+        std::vector<candidate>      candidates;             // the routes tried, in order
+        std::chrono::nanoseconds    time        {};         // the time the whole lookup took
+    };
+
+}
@@ -5,6 +5,8 @@
 #include <string_view>
 #include <string>
 #include "impl/variables.h"
+#include "slug_list.h"
+#include "query.h"
 #include "fields.h"
 
 
@@ -47,22 +49,92 @@ namespace router {
          *  Parse all slug data into the given
          *  data transfer object.
          *
-         *  @param  slugs   The slug data to parse
+         *  @param  slugs   The slug data to parse, a slug_list or a vector of string views
          *  @param  output  The object to fill
          */
-        static void to_dto(const std::vector<std::string_view>& slugs, data_type& output)
+        template <typename slug_container>
+        static void to_dto(const slug_container& slugs, data_type& output)
         {
             // ensure the number of slugs is correct
             if (slugs.size() != size()) {
                 // we cannot parse the data
-                throw std::logic_error{ "Cannot convert slugs to dto: slug count mismatch" };
+                impl::fail<std::logic_error>("Cannot convert slugs to dto: slug count mismatch");
             }
 
             // iterator to use in the fold expression
             auto iter = begin(slugs);
 
             // fold the fields into the output object
-            (process_field(*iter++, output.*members), ...);
+            (impl::process_slug(*iter++, output.*members), ...);
+        }
+
+        /**
+         *  Parse all slug data into the given data
+         *  transfer object, without throwing
+         *
+         *  @param  slugs   The slug data to parse, a slug_list or a vector of string views
+         *  @param  output  The object to fill
+         *  @return Whether the number of slugs is correct and all fields could be set
+         */
+        template <typename slug_container>
+        static bool try_to_dto(const slug_container& slugs, data_type& output)
+        {
+            // iterator to use in the fold expression
+            auto iter = begin(slugs);
+
+            // fold the fields into the output object, stopping at the first failure
+            return slugs.size() == size() && (impl::try_slug(*iter++, output.*members) && ...);
+        }
+    };
+
+    /**
+     *  Templated class describing bindings between
+     *  query parameters and struct members.
+     *
+     *  The struct is templated on the struct we need
+     *  to bind to, as well as all the parameters that
+     *  need binding.
+     */
+    template <typename data_type, typename... fields>
+    struct query_dto
+    {
+        /**
+         *  Bind a query parameter to a field.
+         *
+         *  Parameters are found by their name, which must be a constant
+         *  character array. A parameter that is not given leaves the field
+         *  untouched, and when it is given more than once, the first value
+         *  is used.
+         *
+         *  @tparam field   The field to bind
+         *  @tparam name    The name of the parameter
+         */
+        template <auto field, const char* name>
+        using bind = query_dto<data_type, fields..., impl::query_field<field, name>>;
+
+        /**
+         *  Parse the query parameters into the
+         *  given data transfer object.
+         *
+         *  @param  parameters  The query to parse
+         *  @param  output      The object to fill
+         */
+        static void to_query(query parameters, data_type& output)
+        {
+            (fields::process(parameters, output), ...);
+        }
+
+        /**
+         *  Parse the query parameters into the given
+         *  data transfer object, without throwing
+         *
+         *  @param  parameters  The query to parse
+         *  @param  output      The object to fill
+         *  @return Whether all given parameters could be converted
+         */
+        static bool try_to_query(query parameters, data_type& output)
+        {
+            return (fields::parse(parameters, output) && ...);
         }
     };
 
@@ -80,12 +152,12 @@ namespace router {
     struct is_dto_type<T, std::void_t<
         /**
          *  It must have a dto specialization on the type to be considered valid,
-         *  and it must be able process a vector of slugs onto the given data type
+         *  and it must be able process a list of slugs onto the given data type
          */
         std::enable_if_t<std::is_same_v<
             void,
             decltype(T::dto::to_dto(
-                std::declval<const std::vector<std::string_view>&>(),
+                std::declval<const slug_list&>(),
                 std::declval<T&>()
             ))
         >>
@@ -118,27 +190,107 @@ namespace router {
     constexpr bool is_dto_tuple_v = is_dto_tuple<T>::value;
 
     /**
-     *  Read a vector of slugs and parse them
+     *  Type trait for a type without query bindings
+     */
+    template <typename T, typename = void>
+    struct is_query_dto_type : std::false_type {};
+
+    /**
+     *  Type trait for a type with a query_dto alias
+     */
+    template <typename T>
+    struct is_query_dto_type<T, std::void_t<
+        std::enable_if_t<std::is_same_v<
+            void,
+            decltype(T::query_dto::to_query(
+                std::declval<query>(),
+                std::declval<T&>()
+            ))
+        >>
+    >> : std::true_type {};
+
+    /**
+     *  Value alias for query dto type deduction
+     */
+    template <typename T>
+    constexpr bool is_query_dto_type_v = is_query_dto_type<T>::value;
+
+    /**
+     *  Read a list of slugs and parse them
      *  into the given dto type
      */
-    template <typename data_type>
+    template <typename slug_container, typename data_type>
     std::enable_if_t<is_dto_type_v<data_type>>
-    to_dto(const std::vector<std::string_view>& slugs, data_type& output)
+    to_dto(const slug_container& slugs, data_type& output)
     {
         // invoke the conversion routine on the types dto alias
         data_type::dto::to_dto(slugs, output);
     }
 
     /**
-     *  Read a vector of slugs and parse them
+     *  Read a list of slugs and parse them
      *  into the given tuple
      */
-    template <typename... types>
+    template <typename slug_container, typename... types>
     std::enable_if_t<is_dto_tuple_v<std::tuple<types...>>>
-    to_dto(const std::vector<std::string_view>& slugs, std::tuple<types...>& output)
+    to_dto(const slug_container& slugs, std::tuple<types...>& output)
     {
         // create integer sequence for retrieving types from the tuple
         impl::to_dto(slugs, output, std::make_index_sequence<sizeof...(types)>());
     }
 
+    /**
+     *  Read a list of slugs and parse them into
+     *  the given dto type, without throwing
+     *
+     *  @return Whether all slugs could be converted
+     */
+    template <typename slug_container, typename data_type>
+    std::enable_if_t<is_dto_type_v<data_type>, bool>
+    try_to_dto(const slug_container& slugs, data_type& output)
+    {
+        // invoke the conversion routine on the types dto alias
+        return data_type::dto::try_to_dto(slugs, output);
+    }
+
+    /**
+     *  Read a list of slugs and parse them into
+     *  the given tuple, without throwing
+     *
+     *  @return Whether all slugs could be converted
+     */
+    template <typename slug_container, typename... types>
+    std::enable_if_t<is_dto_tuple_v<std::tuple<types...>>, bool>
+    try_to_dto(const slug_container& slugs, std::tuple<types...>& output)
+    {
+        // create integer sequence for retrieving types from the tuple
+        return impl::try_to_dto(slugs, output, std::make_index_sequence<sizeof...(types)>());
+    }
+
+    /**
+     *  Read the query parameters into
+     *  the given query dto type
+     */
+    template <typename data_type>
+    std::enable_if_t<is_query_dto_type_v<data_type>>
+    to_query(query parameters, data_type& output)
+    {
+        // invoke the conversion routine on the types query_dto alias
+        data_type::query_dto::to_query(parameters, output);
+    }
+
+    /**
+     *  Read the query parameters into the given
+     *  query dto type, without throwing
+     *
+     *  @return Whether all given parameters could be converted
+     */
+    template <typename data_type>
+    std::enable_if_t<is_query_dto_type_v<data_type>, bool>
+    try_to_query(query parameters, data_type& output)
+    {
+        // invoke the conversion routine on the types query_dto alias
+        return data_type::query_dto::try_to_query(parameters, output);
+    }
+
 }
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <type_traits>
 #include <stdexcept>
+#include <cstdint>
 #include <cstddef>
+#include <array>
+#include "impl/exceptions.h"
 
 
 namespace router {
@@ -14,8 +18,286 @@ namespace router {
         } else if constexpr(sizeof...(haystack) > 0) {
             return variadic_lookup<index + 1, haystack...>(needle);
         } else {
-            throw std::invalid_argument{ "Lookup failed: needle not found in variadic list" };
+            impl::fail<std::invalid_argument>("Lookup failed: needle not found in variadic list");
         }
     }
 
+    /**
+     *  A constant-time lookup of the index of a value in a list of values
+     *
+     *  The values must be integers or enumerations. When the values lie close
+     *  together, as with most enumerations, the index is stored in a table
+     *  covering every possible value between the lowest and the highest one.
+     *  Otherwise, a perfect hash is searched for at compile time, mapping the
+     *  values to a small table without any collisions. Either way, finding
+     *  an index takes a single table lookup.
+     */
+    template <auto first, decltype(first)... rest>
+    class variadic_index
+    {
+        public:
+            /**
+             *  The type of values to look up
+             */
+            using value_type = decltype(first);
+
+            /**
+             *  The number of values in the list
+             */
+            constexpr static std::size_t size = 1 + sizeof...(rest);
+
+            /**
+             *  Value returned for values that are not in the list
+             */
+            constexpr static std::size_t npos = static_cast<std::size_t>(-1);
+
+            /**
+             *  Find the index of a value, when a value occurs
+             *  multiple times, the first index is returned
+             *
+             *  @param  needle  The value to find
+             *  @return The index of the value, or npos if not found
+             */
+            constexpr static std::size_t find(value_type needle) noexcept
+            {
+                // the key to look up
+                auto code = key(needle);
+
+                // do we use a dense table?
+                if constexpr (dense) {
+                    // values outside the range are not in the list
+                    if (code - lowest >= range) {
+                        return npos;
+                    }
+
+                    // look up the index directly
+                    auto index = dense_table[code - lowest];
+                    return index == empty ? npos : index;
+                } else {
+                    // find the slot the value hashes to
+                    const auto& slot = sparse_table.slots[hash(code, sparse_table.multiplier, sparse_table.bits)];
+
+                    // the slot may hold another value
+                    return slot.index == empty || slot.key != code ? npos : slot.index;
+                }
+            }
+        private:
+            static_assert(std::is_integral_v<value_type> || std::is_enum_v<value_type>, "Only integers and enumerations can be looked up");
+            static_assert(size < 255, "Too many values to look up");
+
+            /**
+             *  Marker for an unused table entry
+             */
+            constexpr static std::uint8_t empty = 255;
+
+            /**
+             *  Convert a value to the key to look up
+             *
+             *  @param  value   The value to convert
+             *  @return The key for the value
+             */
+            constexpr static std::uint64_t key(value_type value) noexcept
+            {
+                if constexpr (std::is_enum_v<value_type>) {
+                    return static_cast<std::uint64_t>(static_cast<std::underlying_type_t<value_type>>(value));
+                } else {
+                    return static_cast<std::uint64_t>(value);
+                }
+            }
+
+            /**
+             *  All the keys, in order
+             */
+            constexpr static std::array<std::uint64_t, size> keys{ key(first), key(rest)... };
+
+            /**
+             *  Find the lowest key, compared as signed values so that
+             *  negative values come before the positive ones
+             *
+             *  @return The lowest key
+             */
+            constexpr static std::uint64_t find_lowest() noexcept
+            {
+                // start with the first key
+                std::uint64_t result{ keys[0] };
+
+                // and find anything lower
+                for (auto current : keys) {
+                    if (static_cast<std::int64_t>(current) < static_cast<std::int64_t>(result)) {
+                        result = current;
+                    }
+                }
+
+                return result;
+            }
+
+            /**
+             *  Find the number of keys between the lowest and the highest key
+             *
+             *  @return The number of possible keys, or zero if this does not fit
+             */
+            constexpr static std::uint64_t find_range() noexcept
+            {
+                // find the highest key
+                std::uint64_t highest{ keys[0] };
+
+                for (auto current : keys) {
+                    if (static_cast<std::int64_t>(current) > static_cast<std::int64_t>(highest)) {
+                        highest = current;
+                    }
+                }
+
+                // the distance between the keys, unsigned arithmetic wraps
+                // around correctly for negative keys, except when the range
+                // covers all 64 bits, which certainly is not dense
+                std::uint64_t distance{ highest - find_lowest() };
+                return distance == static_cast<std::uint64_t>(-1) ? 0 : distance + 1;
+            }
+
+            /**
+             *  The lowest key and the number of keys from there to the highest key
+             */
+            constexpr static std::uint64_t lowest   = find_lowest();
+            constexpr static std::uint64_t range    = find_range();
+
+            /**
+             *  Whether the keys are close enough together to use
+             *  a table covering all keys in between them
+             */
+            constexpr static bool dense = range != 0 && range <= 4 * size + 16;
+
+            /**
+             *  Build the table covering all possible keys
+             *
+             *  @return The index for every key in the range
+             */
+            constexpr static auto build_dense() noexcept
+            {
+                // the table to fill, it is not used when the keys are far apart
+                std::array<std::uint8_t, dense ? range : 1> result{};
+
+                for (auto& entry : result) {
+                    entry = empty;
+                }
+
+                // store the index for every key, keeping the first occurrence
+                for (std::size_t i{ 0 }; dense && i < size; ++i) {
+                    if (result[keys[i] - lowest] == empty) {
+                        result[keys[i] - lowest] = static_cast<std::uint8_t>(i);
+                    }
+                }
+
+                return result;
+            }
+
+            /**
+             *  The table for the dense lookup
+             */
+            constexpr static auto dense_table = build_dense();
+
+            /**
+             *  Hash a key for the sparse lookup
+             *
+             *  @param  code        The key to hash
+             *  @param  multiplier  The multiplier to use
+             *  @param  bits        The number of bits in the result
+             *  @return The slot for the key
+             */
+            constexpr static std::size_t hash(std::uint64_t code, std::uint64_t multiplier, std::size_t bits) noexcept
+            {
+                return static_cast<std::size_t>((code * multiplier) >> (64 - bits));
+            }
+
+            /**
+             *  The number of bits used for the sparse slots, so that
+             *  there are at least twice as many slots as keys
+             */
+            constexpr static std::size_t slot_bits = [] {
+                std::size_t result{ 1 };
+
+                while ((std::size_t{ 1 } << result) < 2 * size) {
+                    ++result;
+                }
+
+                return result;
+            }();
+
+            /**
+             *  A slot in the sparse table
+             */
+            struct slot
+            {
+                std::uint64_t   key;    // the key stored in the slot
+                std::uint8_t    index;  // the index for the key, or empty
+            };
+
+            /**
+             *  The table for the sparse lookup
+             */
+            struct sparse
+            {
+                std::array<slot, (std::size_t{ 1 } << (slot_bits + 2))> slots;      // the slots, for the largest number of bits we try
+                std::uint64_t                                           multiplier; // the multiplier for the hash
+                std::size_t                                             bits;       // the number of bits for the hash
+            };
+
+            /**
+             *  Search a multiplier hashing all keys to a different slot
+             *
+             *  @return The table using the multiplier that was found
+             */
+            constexpr static sparse build_sparse()
+            {
+                // the table to fill
+                sparse result{};
+
+                // the keys are far apart, so we need a hash, we first try the
+                // smallest table, and only use more slots when that fails
+                for (std::size_t bits{ slot_bits }; !dense && bits <= slot_bits + 2; ++bits) {
+                    for (std::uint64_t seed{ 1 }; seed < 4096; ++seed) {
+                        // an odd multiplier, spreading the bits of the seed
+                        std::uint64_t multiplier{ (seed * 0x9e3779b97f4a7c15ull) | 1 };
+
+                        // start with an empty table
+                        for (auto& current : result.slots) {
+                            current = { 0, empty };
+                        }
+
+                        // try to store all keys
+                        bool collision{ false };
+
+                        for (std::size_t i{ 0 }; i < size && !collision; ++i) {
+                            auto& target = result.slots[hash(keys[i], multiplier, bits)];
+
+                            if (target.index == empty) {
+                                target = { keys[i], static_cast<std::uint8_t>(i) };
+                            } else if (target.key != keys[i]) {
+                                collision = true;
+                            }
+                        }
+
+                        // did we store all keys?
+                        if (!collision) {
+                            result.multiplier   = multiplier;
+                            result.bits         = bits;
+                            return result;
+                        }
+                    }
+                }
+
+                // the keys are dense, or we failed to find a multiplier, which
+                // is a compile time error when the sparse table is needed
+                if (!dense) {
+                    impl::fail<std::logic_error>("No perfect hash found for the values");
+                }
+
+                return result;
+            }
+
+            /**
+             *  The table for the sparse lookup
+             */
+            constexpr static sparse sparse_table = build_sparse();
+    };
+
 }
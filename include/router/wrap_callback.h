@@ -2,86 +2,427 @@
 
 #include "function_traits.h"
 #include "variables.h"
+#include "slug_list.h"
+#include "status.h"
+#include "query.h"
+#include "impl/slug_storage.h"
+#include "impl/decoded_slugs.h"
 #include <string_view>
-#include <vector>
+#include <tuple>
 
 
 namespace router {
 
-    /**
-     *  Wrap a callback to create a uniform handler
-     *
-     *  @tparam callback    The callback to wrap
-     *  @param  slugs       The slug data from the target
-     *  @param  instance    The instance to invoke the callback on
-     *  @param  parameters  Additional arguments to pass to the callback
-     */
-    template <auto callback, typename return_type, typename... arguments>
-    return_type wrap_callback(const std::vector<std::string_view>& slugs, void* instance, arguments&&... parameters)
-    {
-        // the number of arguments our callback function takes
-        // ignoring the extra variable parameter it may take
-        constexpr std::size_t arity = sizeof...(arguments);
+    namespace impl {
 
-        // traits for the callback function, and the data type used for the variables
-        using traits = function_traits<decltype(callback)>;
+        /**
+         *  The ways a callback can take the slug data
+         */
+        enum class slug_passing
+        {
+            none,       // the callback takes no slugs
+            object,     // the slugs are converted to a dto, passed as the last argument
+            arguments   // the slugs are converted to separate arguments
+        };
 
-        // does the callback require slug parsing?
-        if constexpr (traits::arity == arity) {
-            // is it a member function?
-            if constexpr (!traits::is_member_function) {
-                // it is not, we can invoke the callback directly
-                return callback(std::forward<arguments>(parameters)...);
+        /**
+         *  The ways a callback can take the query
+         */
+        enum class query_passing
+        {
+            none,       // the callback does not take the query
+            view,       // the query is passed as a router::query
+            object      // the query is converted to a query dto
+        };
+
+        /**
+         *  Determine how a callback takes the slug data
+         *
+         *  @tparam callback    The callback to check
+         *  @tparam arity       The number of arguments before the slugs
+         *  @return The way the callback takes the slugs
+         */
+        template <auto callback, std::size_t arity>
+        constexpr slug_passing slug_passing_for() noexcept
+        {
+            // traits for the callback function
+            using traits = function_traits<decltype(callback)>;
+
+            if constexpr (traits::arity == arity) {
+                return slug_passing::none;
+            } else if constexpr (traits::arity == arity + 1 && (is_dto_type_v<std::remove_reference_t<typename traits::template argument_type<arity>>> || is_dto_tuple_v<std::remove_reference_t<typename traits::template argument_type<arity>>>)) {
+                return slug_passing::object;
             } else {
-                // invoke the function on the given instance
-                return (static_cast<typename traits::member_type*>(instance)->*callback)(std::forward<arguments>(parameters)...);
+                return slug_passing::arguments;
             }
-        } else if constexpr (traits::arity == arity + 1 && (is_dto_type_v<std::remove_reference_t<typename traits::template argument_type<arity>>> || is_dto_tuple_v<std::remove_reference_t<typename traits::template argument_type<arity>>>)) {
-            // determine the type used for the slug data, this comes as the optional
-            // last parameter the function may take, elements are zero-based
-            using variable_type = std::remove_reference_t<typename traits::template argument_type<arity>>;
+        }
 
-            // create the variables to be filled and try to match the target
-            variable_type variables{};
+        /**
+         *  Determine how a callback takes the query, which
+         *  comes right after the arguments given by the caller
+         *
+         *  @tparam callback    The callback to check
+         *  @tparam arity       The number of arguments given by the caller
+         *  @return The way the callback takes the query
+         */
+        template <auto callback, std::size_t arity>
+        constexpr query_passing query_passing_for() noexcept
+        {
+            // traits for the callback function
+            using traits = function_traits<decltype(callback)>;
 
-            // parse the variables
-            to_dto(slugs, variables);
+            if constexpr (traits::arity > arity) {
+                // the type of the argument that could take the query
+                using argument = std::remove_cv_t<std::remove_reference_t<typename traits::template argument_type<arity>>>;
 
-            // is it a member function?
-            if constexpr (!traits::is_member_function) {
-                // invoke the wrapped callback and return the result
-                return callback(std::forward<arguments>(parameters)..., std::move(variables));
+                if constexpr (std::is_same_v<argument, query>) {
+                    return query_passing::view;
+                } else if constexpr (is_query_dto_type_v<argument>) {
+                    return query_passing::object;
+                } else {
+                    return query_passing::none;
+                }
             } else {
-                // invoke the function on the given instance
-                return (static_cast<typename traits::member_type*>(instance)->*callback)(std::forward<arguments>(parameters)..., std::move(variables));
+                return query_passing::none;
             }
-        } else {
+        }
+
+        /**
+         *  The type the query is converted to for a callback not taking it
+         */
+        template <auto callback, std::size_t arity, query_passing = query_passing_for<callback, arity>()>
+        struct query_variables
+        {
+            using type = std::tuple<>;
+        };
+
+        /**
+         *  The type the query is converted to for a callback taking the view
+         */
+        template <auto callback, std::size_t arity>
+        struct query_variables<callback, arity, query_passing::view>
+        {
+            using type = std::tuple<query>;
+        };
+
+        /**
+         *  The type the query is converted to for a callback taking a query dto
+         */
+        template <auto callback, std::size_t arity>
+        struct query_variables<callback, arity, query_passing::object>
+        {
+            using type = std::tuple<std::remove_cv_t<std::remove_reference_t<typename function_traits<decltype(callback)>::template argument_type<arity>>>>;
+        };
+
+        /**
+         *  The type the slug data is converted to for a callback
+         */
+        template <auto callback, std::size_t arity, slug_passing = slug_passing_for<callback, arity>()>
+        struct slug_variables
+        {
             // the variable type is a tuple of the slug arguments
             // which is unpacked later using std::apply
-            using variable_type = typename traits::template arguments_slice<arity>;
+            using type = typename function_traits<decltype(callback)>::template arguments_slice<arity>;
+        };
+
+        /**
+         *  The type the slug data is converted to for a callback taking a dto
+         */
+        template <auto callback, std::size_t arity>
+        struct slug_variables<callback, arity, slug_passing::object>
+        {
+            // the slug data comes as the last parameter the function takes
+            using type = std::tuple<std::remove_reference_t<typename function_traits<decltype(callback)>::template argument_type<arity>>>;
+        };
+
+        /**
+         *  Type trait for a field taking decoded slug data
+         */
+        template <typename T>
+        struct is_decoded_field : std::false_type {};
+
+        /**
+         *  Match for a decoded field
+         */
+        template <typename T>
+        struct is_decoded_field<decoded<T>> : std::true_type {};
+
+        /**
+         *  Type trait for whether the slugs converted to a dto may need
+         *  decoding, which is assumed for dtos with their own conversion
+         */
+        template <typename T>
+        struct decodes_members : std::true_type {};
+
+        /**
+         *  Match for a dto binding the members
+         */
+        template <typename data_type, auto... members>
+        struct decodes_members<dto<data_type, members...>> :
+            std::bool_constant<(... || is_decoded_field<std::remove_reference_t<decltype(std::declval<data_type&>().*members)>>::value)> {};
+
+        /**
+         *  Type trait for whether the slugs converted to a type need decoding
+         */
+        template <typename T>
+        struct decodes_slugs : decodes_members<typename T::dto> {};
+
+        /**
+         *  Match for a tuple of fields
+         */
+        template <typename... T>
+        struct decodes_slugs<std::tuple<T...>> : std::bool_constant<(... || is_decoded_field<T>::value)> {};
+
+        /**
+         *  Determine whether the slug data for a callback is decoded
+         *
+         *  @tparam mode        The way the callback takes the slugs
+         *  @tparam variables   The type the slug data is converted to
+         *  @return Whether any of the fields takes decoded data
+         */
+        template <slug_passing mode, typename variables>
+        constexpr bool decodes_slugs_for() noexcept
+        {
+            if constexpr (mode == slug_passing::object) {
+                return decodes_slugs<std::tuple_element_t<0, variables>>::value;
+            } else {
+                return decodes_slugs<variables>::value;
+            }
+        }
+
+        /**
+         *  Placeholder for the buffer of callbacks that do not decode slugs
+         */
+        struct no_buffer {};
+
+        /**
+         *  Get the buffer to decode slugs in
+         *
+         *  @param  buffer  The buffer, or the placeholder for callbacks that do not decode slugs
+         *  @return Pointer to the buffer, if any
+         */
+        inline decode_buffer* buffer_pointer(decode_buffer& buffer) noexcept   { return &buffer;   }
+        inline decode_buffer* buffer_pointer(no_buffer&) noexcept              { return nullptr;   }
+
+        /**
+         *  Create a tuple of rvalue references to the elements of a tuple
+         *
+         *  @param  input   The tuple to move from
+         *  @return The references to the elements
+         */
+        template <typename... types>
+        std::tuple<types&&...> move_elements(std::tuple<types...>& input) noexcept
+        {
+            return std::apply([](types&... elements) {
+                return std::forward_as_tuple(std::move(elements)...);
+            }, input);
+        }
+
+        /**
+         *  The data converted from the slugs and the query for a callback
+         *
+         *  @tparam callback    The callback to convert the data for
+         *  @tparam arity       The number of arguments given by the caller
+         */
+        template <auto callback, std::size_t arity>
+        struct callback_data
+        {
+            /**
+             *  How the callback takes the query and the slugs, which come after the query
+             */
+            constexpr static query_passing  query_mode  = query_passing_for<callback, arity>();
+            constexpr static std::size_t    offset      = query_mode == query_passing::none ? arity : arity + 1;
+            constexpr static slug_passing   slug_mode   = slug_passing_for<callback, offset>();
+
+            /**
+             *  Whether the callback has fields taking decoded slugs
+             */
+            constexpr static bool decodes = decodes_slugs_for<slug_mode, typename slug_variables<callback, offset>::type>();
+
+            /**
+             *  The buffer to decode slugs in, which only exists when they are decoded
+             */
+            using buffer_type = std::conditional_t<decodes, decode_buffer, no_buffer>;
+
+            typename query_variables<callback, arity>::type query;  // the query, if the callback takes it
+            typename slug_variables<callback, offset>::type slugs;  // the slug data, if the callback takes it
+
+            /**
+             *  Convert the slug data and the query
+             *
+             *  @param  input   The slug data and query from the target
+             *  @param  buffer  The buffer to decode slugs with escapes in, if they are decoded
+             */
+            void process(const slug_list& input, decode_buffer* buffer)
+            {
+                // convert the query, if the callback takes it
+                if constexpr (query_mode == query_passing::view) {
+                    std::get<0>(query) = input.query();
+                } else if constexpr (query_mode == query_passing::object) {
+                    to_query(input.query(), std::get<0>(query));
+                }
+
+                // and the decoded slugs, which are stored as a tuple or a dto
+                if constexpr (slug_mode == slug_passing::object) {
+                    router::to_dto(decoded_slugs{ input, buffer }, std::get<0>(slugs));
+                } else if constexpr (slug_mode == slug_passing::arguments) {
+                    router::to_dto(decoded_slugs{ input, buffer }, slugs);
+                }
+            }
+
+            /**
+             *  Convert the slug data and the query, without throwing
+             *
+             *  @param  input   The slug data and query from the target
+             *  @param  buffer  The buffer to decode slugs with escapes in, if they are decoded
+             *  @return Whether all data could be converted
+             */
+            bool parse(const slug_list& input, decode_buffer* buffer)
+            {
+                // convert the query, if the callback takes it
+                if constexpr (query_mode == query_passing::view) {
+                    std::get<0>(query) = input.query();
+                } else if constexpr (query_mode == query_passing::object) {
+                    if (!try_to_query(input.query(), std::get<0>(query))) {
+                        return false;
+                    }
+                }
+
+                // and the decoded slugs, which are stored as a tuple or a dto
+                if constexpr (slug_mode == slug_passing::object) {
+                    return router::try_to_dto(decoded_slugs{ input, buffer }, std::get<0>(slugs));
+                } else if constexpr (slug_mode == slug_passing::arguments) {
+                    return router::try_to_dto(decoded_slugs{ input, buffer }, slugs);
+                } else {
+                    return true;
+                }
+            }
+        };
 
-            // create the variables to be filled and try to match the target
-            variable_type variables{};
+        /**
+         *  Invoke a callback with the converted data
+         *
+         *  @tparam callback    The callback to invoke
+         *  @param  instance    The instance to invoke the callback on
+         *  @param  data        The converted query and slug data
+         *  @param  parameters  Additional arguments to pass to the callback
+         */
+        template <auto callback, typename return_type, typename... arguments>
+        return_type invoke_callback(void* instance, callback_data<callback, sizeof...(arguments)>& data, arguments&&... parameters)
+        {
+            // traits for the callback function
+            using traits = function_traits<decltype(callback)>;
 
-            // parse the variables
-            to_dto(slugs, variables);
+            // the arguments come first, followed by the query and the slugs
+            auto values = std::tuple_cat(
+                std::forward_as_tuple(std::forward<arguments>(parameters)...),
+                move_elements(data.query),
+                move_elements(data.slugs)
+            );
 
             // is it a member function?
             if constexpr (!traits::is_member_function) {
                 // invoke the wrapped callback and return the result
-                return std::apply(callback, std::tuple_cat(
-                    std::forward_as_tuple(std::forward<arguments>(parameters)...),
-                    std::move(variables)
-                ));
+                return std::apply(callback, std::move(values));
             } else {
                 // invoke the function on the given instance
                 return std::apply(callback, std::tuple_cat(
-                    std::forward_as_tuple(static_cast<typename traits::member_type*>(instance)),
-                    std::forward_as_tuple(std::forward<arguments>(parameters)...),
-                    std::move(variables)
+                    std::make_tuple(static_cast<typename traits::member_type*>(instance)),
+                    std::move(values)
                 ));
             }
         }
+
+    }
+
+    /**
+     *  Wrap a callback to create a uniform handler
+     *
+     *  @tparam callback    The callback to wrap
+     *  @param  slugs       The slug data and query from the target
+     *  @param  instance    The instance to invoke the callback on
+     *  @param  parameters  Additional arguments to pass to the callback
+     */
+    template <auto callback, typename return_type, typename... arguments>
+    return_type wrap_callback(const slug_list& slugs, void* instance, arguments&&... parameters)
+    {
+        // create the variables to be filled, and the buffer for decoded slugs, if needed
+        using data_type = impl::callback_data<callback, sizeof...(arguments)>;
+
+        data_type                       data{};
+        typename data_type::buffer_type buffer;
+
+        // parse the variables
+        data.process(slugs, impl::buffer_pointer(buffer));
+
+        // and invoke the callback with them
+        return impl::invoke_callback<callback, return_type>(instance, data, std::forward<arguments>(parameters)...);
+    }
+
+    /**
+     *  Wrap a callback to create a uniform handler, which reports slugs
+     *  that cannot be converted for the callback instead of throwing
+     *
+     *  @tparam callback    The callback to wrap
+     *  @param  slugs       The slug data and query from the target
+     *  @param  instance    The instance to invoke the callback on
+     *  @param  parameters  Additional arguments to pass to the callback
+     *  @return The result of the callback, or status::conversion_failed
+     */
+    template <auto callback, typename return_type, typename... arguments>
+    result<return_type> try_wrap_callback(const slug_list& slugs, void* instance, arguments&&... parameters)
+    {
+        // create the variables to be filled, and the buffer for decoded slugs, if needed
+        using data_type = impl::callback_data<callback, sizeof...(arguments)>;
+
+        data_type                       data{};
+        typename data_type::buffer_type buffer;
+
+        // parse the variables
+        if (!data.parse(slugs, impl::buffer_pointer(buffer))) {
+            return status::conversion_failed;
+        }
+
+        // a callback without a result only reports success
+        if constexpr (std::is_void_v<return_type>) {
+            impl::invoke_callback<callback, return_type>(instance, data, std::forward<arguments>(parameters)...);
+            return status::ok;
+        } else {
+            return impl::invoke_callback<callback, return_type>(instance, data, std::forward<arguments>(parameters)...);
+        }
+    }
+
+    /**
+     *  Convert the slug data for a callback ahead of invoking it
+     *
+     *  @tparam callback    The callback to convert the slugs for
+     *  @param  slugs       The slug data and query from the target
+     *  @param  storage     The storage to keep the converted data in
+     *  @return Whether the slugs could be converted
+     */
+    template <auto callback, typename return_type, typename... arguments>
+    bool convert_callback(const slug_list& slugs, impl::slug_storage& storage)
+    {
+        // the type of the variables
+        using data_type = impl::callback_data<callback, sizeof...(arguments)>;
+
+        // create the variables to be filled, and parse them
+        return storage.emplace<data_type>().parse(slugs, data_type::decodes ? &storage.buffer() : nullptr);
+    }
+
+    /**
+     *  Invoke a callback with slug data converted by convert_callback()
+     *
+     *  @tparam callback    The callback to invoke
+     *  @param  storage     The storage holding the converted data
+     *  @param  instance    The instance to invoke the callback on
+     *  @param  parameters  Additional arguments to pass to the callback
+     */
+    template <auto callback, typename return_type, typename... arguments>
+    return_type invoke_converted(impl::slug_storage& storage, void* instance, arguments&&... parameters)
+    {
+        // invoke the callback with the variables that were converted before
+        return impl::invoke_callback<callback, return_type>(instance, storage.get<impl::callback_data<callback, sizeof...(arguments)>>(), std::forward<arguments>(parameters)...);
     }
 
 }
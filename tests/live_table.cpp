@@ -0,0 +1,121 @@
+#include <router/live_table.h>
+
+#include <atomic>
+#include <thread>
+
+#include <catch2/catch_all.hpp>
+
+static int first_version(int value) { return value; }
+static int second_version(int value) { return value * 2; }
+
+TEST_CASE("live tables can be replaced", "[live-table]") {
+    using table_type = router::table<int()>;
+
+    // the table to start with
+    table_type initial;
+    initial.add<&first_version>("/version/{\\d+}");
+
+    router::live_table<int()> table{ std::move(initial) };
+
+    REQUIRE(table.route("/version/10") == 10);
+    REQUIRE(table.routable("/other") == false);
+
+    SECTION("new requests use the published table") {
+        table_type next;
+        next.add<&second_version>("/version/{\\d+}");
+        next.add<&first_version>("/other/{\\d+}");
+
+        table.publish(std::move(next));
+
+        REQUIRE(table.route("/version/10") == 20);
+        REQUIRE(table.route("/other/5") == 5);
+    }
+
+    SECTION("requests in progress finish on the old table") {
+        std::atomic<bool> reading{ false };
+        std::atomic<bool> published{ false };
+        std::atomic<bool> release{ false };
+        std::atomic<int>  result{ 0 };
+
+        // a reader that keeps using the old table for a while
+        std::thread reader{ [&]() {
+            table.read([&](const table_type& current) {
+                reading = true;
+
+                // wait until we are allowed to continue
+                while (!release) {
+                    std::this_thread::yield();
+                }
+
+                // the old table must still be intact
+                result = current.route("/version/10");
+            });
+        } };
+
+        while (!reading) {
+            std::this_thread::yield();
+        }
+
+        // publish a new table while the reader is busy
+        std::thread writer{ [&]() {
+            table_type next;
+            next.add<&second_version>("/version/{\\d+}");
+            table.publish(std::move(next));
+            published = true;
+        } };
+
+        // the new table is visible, but the old one is not destroyed yet
+        while (table.route("/version/10") != 20) {
+            std::this_thread::yield();
+        }
+
+        REQUIRE(published == false);
+
+        // let the reader finish, after which publishing completes
+        release = true;
+        reader.join();
+        writer.join();
+
+        REQUIRE(published == true);
+        REQUIRE(result == 10);
+    }
+
+    SECTION("routing while tables are published") {
+        std::atomic<bool> done{ false };
+        std::atomic<bool> failed{ false };
+        std::vector<std::thread> readers;
+
+        for (std::size_t i{ 0 }; i < 4; ++i) {
+            readers.emplace_back([&]() {
+                while (!done) {
+                    // every table routes the endpoint in one of two ways
+                    auto result = table.route("/version/21");
+
+                    if (result != 21 && result != 42) {
+                        failed = true;
+                    }
+                }
+            });
+        }
+
+        for (std::size_t i{ 0 }; i < 200; ++i) {
+            table_type next;
+
+            if (i % 2 == 0) {
+                next.add<&second_version>("/version/{\\d+}");
+            } else {
+                next.add<&first_version>("/version/{\\d+}");
+            }
+
+            table.publish(std::move(next));
+        }
+
+        done = true;
+
+        for (auto& reader : readers) {
+            reader.join();
+        }
+
+        REQUIRE(failed == false);
+    }
+}
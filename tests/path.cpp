@@ -1,4 +1,6 @@
 #include <router/path.h>
+#include <router/slug_list.h>
+#include <string>
 
 #include <catch2/catch_all.hpp>
 
@@ -60,4 +62,98 @@ TEST_CASE("paths should correctly identify and parse slugs", "[path]") {
         REQUIRE(path.match("/test/10/test", slugs) == true);
         REQUIRE(path.match("/test/1/test", slugs) == false);
     }
+
+    SECTION("matching into a slug list") {
+        router::path        path    { "/test/{\\d+}/{\\w+}/test" };
+        router::slug_list   list    {};
+
+        REQUIRE(path.match("/test/10/abc/test", list) == true);
+        REQUIRE(list.size() == 2);
+        REQUIRE(list[0] == "10");
+        REQUIRE(list[1] == "abc");
+        REQUIRE(std::vector<std::string_view>(begin(list), end(list)) == std::vector<std::string_view>{ "10", "abc" });
+
+        REQUIRE(path.match("/test/10/abc/testing", list) == false);
+    }
+
+    SECTION("typed slugs are stored with their value") {
+        router::path        path    { "/test/{n:int}/{f:float}/{\\w+}" };
+        router::slug_list   list    {};
+        int                 number  {};
+        double              ratio   {};
+        std::int8_t         small   {};
+
+        REQUIRE(path.match("/test/-42/2.5/abc", list) == true);
+        REQUIRE(list.value(0).type() == router::slug_value::kind::signed_integer);
+        REQUIRE(list.value(0).get(number) == true);
+        REQUIRE(number == -42);
+        REQUIRE(list.value(1).get(ratio) == true);
+        REQUIRE(ratio == 2.5);
+        REQUIRE(list.value(2).type() == router::slug_value::kind::none);
+
+        // values that do not fit the field are not given
+        REQUIRE(path.match("/test/300/2.5/abc", list) == true);
+        REQUIRE(list.value(0).get(small) == false);
+        REQUIRE(list.value(1).get(number) == false);
+    }
+
+    SECTION("only the values of the first typed slugs are stored") {
+        router::path        path    { "/{a:int}/{\\w+}/{b:int}/{c:int}/{d:int}/{e:int}" };
+        router::slug_list   list    {};
+        int                 number  {};
+
+        REQUIRE(path.match("/1/x/2/3/4/5", list) == true);
+        REQUIRE(list.size() == 6);
+        REQUIRE(list.value(1).type() == router::slug_value::kind::none);
+
+        for (std::size_t index : { 0, 2, 3, 4 }) {
+            REQUIRE(list.value(index).get(number) == true);
+            REQUIRE(std::to_string(number) == list[index]);
+        }
+
+        // the last one is parsed from the data by the callback
+        REQUIRE(list.value(5).type() == router::slug_value::kind::none);
+        REQUIRE(list[5] == "5");
+    }
+}
+
+TEST_CASE("paths tell where they stop matching", "[path]") {
+    router::path path{ "/users/{\\d+}/posts/{\\w+}" };
+
+    SECTION("matching the whole input") {
+        auto result = path.explain("/users/10/posts/first");
+
+        REQUIRE(result.failed == router::trace::stage::matched);
+        REQUIRE(result.consumed == 21);
+    }
+
+    SECTION("failing in the prefix") {
+        auto result = path.explain("/user/10");
+
+        REQUIRE(result.failed == router::trace::stage::prefix);
+        REQUIRE(result.consumed == 5);
+    }
+
+    SECTION("failing in a slug") {
+        auto result = path.explain("/users/10/posts/-");
+
+        REQUIRE(result.failed == router::trace::stage::slug);
+        REQUIRE(result.slug == 1);
+        REQUIRE(result.consumed == 16);
+    }
+
+    SECTION("failing in a suffix") {
+        auto result = path.explain("/users/10/comments/first");
+
+        REQUIRE(result.failed == router::trace::stage::suffix);
+        REQUIRE(result.slug == 0);
+        REQUIRE(result.consumed == 9);
+    }
+
+    SECTION("leaving trailing input") {
+        auto result = path.explain("/users/10/posts/first/");
+
+        REQUIRE(result.failed == router::trace::stage::trailing);
+        REQUIRE(result.consumed == 21);
+    }
 }
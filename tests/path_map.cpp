@@ -0,0 +1,628 @@
+#include <router/path_map.h>
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+#include <catch2/catch_all.hpp>
+
+TEST_CASE("paths are found in priority order", "[path-map]") {
+    // a map to test with, the values identify the added path
+    router::path_map<int> map;
+
+    // a container to hold slug matches
+    std::vector<std::string_view> slugs;
+
+    SECTION("never find anything in an empty map") {
+        REQUIRE(map.find(slugs, "/test") == nullptr);
+        REQUIRE(map.find(slugs, "") == nullptr);
+    }
+
+    SECTION("paths sharing part of their prefix") {
+        map.add("/api/users", 1);
+        map.add("/api/user/{\\d+}", 2);
+        map.add("/api/items/{\\d+}", 3);
+        map.add("/a", 4);
+
+        REQUIRE(*map.find(slugs, "/api/users") == 1);
+        REQUIRE(*map.find(slugs, "/api/user/10") == 2);
+        REQUIRE(*map.find(slugs, "/api/items/20") == 3);
+        REQUIRE(*map.find(slugs, "/a") == 4);
+
+        REQUIRE(map.find(slugs, "/api/user") == nullptr);
+        REQUIRE(map.find(slugs, "/api/items/abc") == nullptr);
+        REQUIRE(map.find(slugs, "/ap") == nullptr);
+    }
+
+    SECTION("sibling prefixes are all considered") {
+        map.add("/a/{\\d+}", 1);
+        map.add("/a/b{\\d+}", 2);
+        map.add("/a/c{\\d+}", 3);
+
+        REQUIRE(*map.find(slugs, "/a/10") == 1);
+        REQUIRE(*map.find(slugs, "/a/b10") == 2);
+        REQUIRE(*map.find(slugs, "/a/c10") == 3);
+    }
+
+    SECTION("shorter prefixes take precedence") {
+        map.add("/test/{\\w+}", 1);
+        map.add("/test/abc{\\w*}", 2);
+
+        REQUIRE(*map.find(slugs, "/test/abcdef") == 1);
+    }
+
+    SECTION("later paths take precedence over earlier paths with the same prefix") {
+        map.add("/test/{\\d+}", 1);
+        map.add("/test/{\\w+}", 2);
+
+        REQUIRE(*map.find(slugs, "/test/10") == 2);
+        REQUIRE(*map.find(slugs, "/test/abc") == 2);
+    }
+
+    SECTION("paths without a prefix are tried last") {
+        map.add("{\\w+}/{\\d+}", 1);
+        map.add("test/{\\d+}", 2);
+
+        REQUIRE(*map.find(slugs, "test/10") == 2);
+        REQUIRE(*map.find(slugs, "other/10") == 1);
+        REQUIRE(slugs.size() == 2);
+        REQUIRE(slugs[0] == "other");
+        REQUIRE(slugs[1] == "10");
+    }
+}
+
+TEST_CASE("compiled paths match like regular lookups", "[path-map]") {
+    // the patterns to add, using only scanner slugs
+    std::string_view patterns[] = {
+        "/health", "/v1/status", "/v1/users/{\\d+}", "/v1/users/{\\w+}",
+        "/v1/users/{\\d+}/items/{[0-9a-f]{4}}", "/v1/{[^/]+}/{\\d*}", "/v1/users/me",
+        "{[a-z]+}/{\\d+}", "/files/{.+}", "/files/{*3:\\w+}.txt", "/a{\\d?}{\\d}b",
+        "/v1/users/{\\d+}",
+    };
+
+    // the endpoints to look up
+    std::string_view endpoints[] = {
+        "", "/", "/health", "/healthz", "/v1/status", "/v1/users/10", "/v1/users/abc",
+        "/v1/users/10/items/beef", "/v1/users/10/items/bee", "/v1/users/10/items/beeef",
+        "/v1/users/me", "/v1/users/", "/v1/users", "/v1/x/", "/v1/x/12", "abc/12", "abc/",
+        "/files/a/b/c.txt", "/files/abc.txt", "/files/abcd.txt", "/a1b", "/a12b", "/ab", "/a123b",
+    };
+
+    router::path_map<std::size_t> map;
+    router::path_map<std::size_t> compiled;
+
+    for (std::size_t i{ 0 }; i < std::size(patterns); ++i) {
+        map.add(patterns[i], i);
+        compiled.add(patterns[i], i);
+    }
+
+    REQUIRE(compiled.compile() == true);
+    REQUIRE(compiled.compiled() == true);
+
+    for (auto endpoint : endpoints) {
+        std::vector<std::string_view> expected_slugs;
+        std::vector<std::string_view> slugs;
+
+        auto* expected  = map.find(expected_slugs, endpoint);
+        auto* found     = compiled.find(slugs, endpoint);
+
+        INFO("endpoint " << endpoint);
+        REQUIRE((expected == nullptr) == (found == nullptr));
+
+        if (expected != nullptr) {
+            REQUIRE(*expected == *found);
+            REQUIRE(expected_slugs == slugs);
+        }
+    }
+
+    // adding another path discards the automaton
+    compiled.add("/new", 100);
+    REQUIRE(compiled.compiled() == false);
+}
+
+TEST_CASE("paths with regular expressions cannot be compiled", "[path-map]") {
+    router::path_map<int> map;
+    std::vector<std::string_view> slugs;
+
+    map.add("/test/{\\d+|abc}", 1);
+
+    REQUIRE(map.compile() == false);
+    REQUIRE(*map.find(slugs, "/test/abc") == 1);
+}
+
+TEST_CASE("paths without slugs are matched exactly", "[path-map]") {
+    router::path_map<int> map;
+    std::vector<std::string_view> slugs;
+
+    map.add("/test/{\\w+}", 1);
+    map.add("/test/exact", 2);
+    map.add("/test", 3);
+    map.add("", 4);
+
+    SECTION("exact matches take precedence") {
+        REQUIRE(*map.find(slugs, "/test/exact") == 2);
+        REQUIRE(slugs.empty());
+        REQUIRE(*map.find(slugs, "/test/other") == 1);
+        REQUIRE(slugs.size() == 1);
+        REQUIRE(*map.find(slugs, "/test/exact") == 2);
+        REQUIRE(slugs.empty());
+    }
+
+    SECTION("exact matches only") {
+        REQUIRE(*map.find(slugs, "/test") == 3);
+        REQUIRE(*map.find(slugs, "") == 4);
+        REQUIRE(map.find(slugs, "/tes") == nullptr);
+        REQUIRE(map.find(slugs, "/test/exact/") == nullptr);
+    }
+
+    SECTION("later paths replace earlier ones") {
+        map.add("/test", 5);
+        REQUIRE(*map.find(slugs, "/test") == 5);
+    }
+
+    SECTION("many paths") {
+        for (int i{ 0 }; i < 1000; ++i) {
+            map.add("/generated/" + std::to_string(i), 100 + i);
+        }
+
+        for (int i{ 0 }; i < 1000; ++i) {
+            REQUIRE(*map.find(slugs, "/generated/" + std::to_string(i)) == 100 + i);
+        }
+
+        REQUIRE(*map.find(slugs, "/test/exact") == 2);
+        REQUIRE(map.find(slugs, "/generated/1000") == nullptr);
+    }
+
+    SECTION("compiled maps check exact matches first") {
+        REQUIRE(map.compile() == true);
+        REQUIRE(*map.find(slugs, "/test/exact") == 2);
+        REQUIRE(*map.find(slugs, "/test/other") == 1);
+        REQUIRE(*map.find(slugs, "/test") == 3);
+    }
+}
+
+TEST_CASE("paths cannot contain more slugs than fit in a slug list", "[path-map]") {
+    router::path_map<int> map;
+
+    // build a path with too many slugs
+    std::string pattern;
+
+    for (std::size_t i{ 0 }; i <= router::slug_list::capacity; ++i) {
+        pattern += "/{\\d+}";
+    }
+
+    REQUIRE_THROWS_AS(map.add(pattern, 1), std::length_error);
+}
+
+/**
+ *  A value whose constructor fails for negative numbers
+ */
+struct checked_value
+{
+    int number;
+
+    checked_value(int number) : number{ number }
+    {
+        if (number < 0) {
+            throw std::invalid_argument{ "negative number" };
+        }
+    }
+};
+
+TEST_CASE("paths are not found when their value cannot be created", "[path-map]") {
+    router::path_map<checked_value> map;
+    std::vector<std::string_view>   slugs;
+
+    map.add("/first/{\\d+}", 1);
+
+    REQUIRE_THROWS_AS(map.add("/second/{\\d+}", -1), std::invalid_argument);
+    REQUIRE_THROWS_AS(map.add("/third", -1), std::invalid_argument);
+
+    REQUIRE(map.find(slugs, "/second/5") == nullptr);
+    REQUIRE(map.find(slugs, "/third") == nullptr);
+
+    // the paths added afterwards are found as usual
+    map.add("/second/{\\d+}", 2);
+    map.add("/third", 3);
+
+    REQUIRE(map.find(slugs, "/first/5")->number == 1);
+    REQUIRE(map.find(slugs, "/second/5")->number == 2);
+    REQUIRE(map.find(slugs, "/third")->number == 3);
+}
+
+TEST_CASE("batched lookups find the same entries as single lookups", "[path-map]") {
+    router::path_map<int> map;
+
+    map.add("/users/{\\d+}", 1);
+    map.add("/users/{\\d+}/posts/{\\d+}", 2);
+    map.add("/users/me", 3);
+    map.add("/{\\w+}/list", 4);
+    map.add("/usage/{[a-z]+}", 5);
+    map.add("/users/{\\d+}/posts", 6);
+
+    // a mix of exact, slug and missing endpoints, in no particular order
+    std::vector<std::string_view> endpoints{
+        "/users/12/posts/7", "/users/me", "/items/list", "/users/12",
+        "/usage/cpu", "/users/12/posts", "/missing", "/users/abc",
+        "/usage/", "/users/list", "", "/users/9/posts/x"
+    };
+
+    auto check = [&map, &endpoints]() {
+        std::vector<std::vector<std::string_view>>  slugs(endpoints.size());
+        std::vector<const int*>                     values(endpoints.size());
+
+        map.find_batch(endpoints.data(), endpoints.size(), slugs.data(), values.data());
+
+        for (std::size_t i{ 0 }; i < endpoints.size(); ++i) {
+            std::vector<std::string_view> expected;
+            auto* value = map.find(expected, endpoints[i]);
+
+            REQUIRE(values[i] == value);
+
+            if (value != nullptr) {
+                REQUIRE(slugs[i] == expected);
+            }
+        }
+    };
+
+    SECTION("uncompiled") {
+        check();
+    }
+
+    SECTION("compiled") {
+        REQUIRE(map.compile() == true);
+        check();
+    }
+}
+
+TEST_CASE("cached lookups find the same entries", "[path-map]") {
+    router::path_map<int> map;
+
+    map.add("/feed/{\\d+}/{\\w+}", 2);
+    map.add("/feed/{\\d+}/items", 1);
+    map.add("/feed/top", 3);
+
+    map.enable_cache(16);
+
+    std::vector<std::string_view> slugs;
+
+    SECTION("repeated lookups are cached") {
+        REQUIRE(*map.find(slugs, "/feed/123/items") == 1);
+        REQUIRE(*map.find(slugs, "/feed/123/items") == 1);
+        REQUIRE(slugs == std::vector<std::string_view>{ "123" });
+
+        REQUIRE(*map.find(slugs, "/feed/42/posts") == 2);
+        REQUIRE(*map.find(slugs, "/feed/42/posts") == 2);
+        REQUIRE(slugs == std::vector<std::string_view>{ "42", "posts" });
+
+        REQUIRE(map.cache()->hits() == 2);
+        REQUIRE(map.cache()->misses() == 2);
+    }
+
+    SECTION("exact matches and missing endpoints are not cached") {
+        REQUIRE(*map.find(slugs, "/feed/top") == 3);
+        REQUIRE(map.find(slugs, "/feed/abc") == nullptr);
+        REQUIRE(map.find(slugs, "/feed/abc") == nullptr);
+
+        REQUIRE(map.cache()->hits() == 0);
+    }
+
+    SECTION("slugs refer to the endpoint that was looked up") {
+        std::string first{ "/feed/7/items" };
+        std::string second{ "/feed/7/items" };
+
+        map.find(slugs, first);
+        map.find(slugs, second);
+
+        REQUIRE(map.cache()->hits() == 1);
+        REQUIRE(slugs.front().data() == second.data() + 6);
+    }
+
+    SECTION("adding a path empties the cache") {
+        REQUIRE(*map.find(slugs, "/feed/123/items") == 1);
+
+        map.add("/feed/{\\d+}/items", 4);
+
+        REQUIRE(*map.find(slugs, "/feed/123/items") == 4);
+        REQUIRE(map.cache()->hits() == 0);
+    }
+
+    SECTION("long endpoints are not cached") {
+        std::string endpoint{ "/feed/1/" + std::string(router::route_cache<int>::max_key, 'a') };
+
+        REQUIRE(*map.find(slugs, endpoint) == 2);
+        REQUIRE(*map.find(slugs, endpoint) == 2);
+        REQUIRE(map.cache()->hits() == 0);
+    }
+
+    SECTION("lookups from multiple threads") {
+        std::vector<std::thread>    threads;
+        std::atomic<bool>           failed{ false };
+
+        for (std::size_t i{ 0 }; i < 4; ++i) {
+            threads.emplace_back([&map, &failed, i]() {
+                std::vector<std::string_view> slugs;
+
+                for (std::size_t j{ 0 }; j < 10000; ++j) {
+                    // a small set of endpoints that keep replacing each other
+                    std::string endpoint{ "/feed/" + std::to_string((i + j) % 40) + "/items" };
+
+                    auto* value = map.find(slugs, endpoint);
+
+                    if (value == nullptr || *value != 1 || slugs.size() != 1 || slugs.front() != std::to_string((i + j) % 40)) {
+                        failed = true;
+                    }
+                }
+            });
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        REQUIRE(failed == false);
+        REQUIRE(map.cache()->hits() + map.cache()->misses() == 40000);
+    }
+}
+
+TEST_CASE("frozen maps find the same entries", "[path-map]") {
+    router::path_map<int> map;
+
+    map.add("/users/{\\d+}", 1);
+    map.add("/users/{\\d+}/posts/{\\d+}", 2);
+    map.add("/users/me", 3);
+    map.add("/{\\w+}/list", 4);
+    map.add("/users/{\\d+}|{[a-z]+}", 5);
+    map.add("/usage/{*3:\\d+}", 6);
+    map.add("/users/{\\d+}/posts/{\\d+}", 7);
+
+    std::vector<std::string_view> endpoints{
+        "/users/12/posts/7", "/users/me", "/items/list", "/users/12",
+        "/users/12|abc", "/usage/123", "/usage/1234", "/missing", "", "/users/"
+    };
+
+    // look up all endpoints before freezing the map
+    std::vector<const int*>                     expected;
+    std::vector<std::vector<std::string_view>>  expected_slugs;
+
+    for (auto endpoint : endpoints) {
+        expected.push_back(map.find(expected_slugs.emplace_back(), endpoint));
+    }
+
+    map.freeze();
+    REQUIRE(map.frozen() == true);
+
+    for (std::size_t i{ 0 }; i < endpoints.size(); ++i) {
+        std::vector<std::string_view> slugs;
+
+        REQUIRE(map.find(slugs, endpoints[i]) == expected[i]);
+        REQUIRE(slugs == expected_slugs[i]);
+    }
+
+    // the frozen layout uses the slugs of its own map, so a copy outlives the original
+    auto copy = std::make_unique<router::path_map<int>>(map);
+    auto moved{ std::move(*copy) };
+    copy.reset();
+
+    std::vector<std::string_view> slugs;
+
+    REQUIRE(moved.frozen() == true);
+    REQUIRE(*moved.find(slugs, "/items/list") == 4);
+    REQUIRE(slugs == std::vector<std::string_view>{ "items" });
+
+    // adding a path discards the frozen layout
+    map.add("/other", 8);
+    REQUIRE(map.frozen() == false);
+}
+
+TEST_CASE("adding paths at once gives the same result as adding them one by one", "[path-map]") {
+    // a mix of paths, including duplicates and paths sharing a prefix
+    std::vector<std::pair<std::string, int>> paths{
+        { "/users/{\\d+}",              1 },
+        { "/users/{\\d+}/posts",        2 },
+        { "/users/me",                  3 },
+        { "/{\\w+}/list",               4 },
+        { "/users/{\\d+}",              5 },
+        { "/users/me",                  6 },
+        { "/items/{\\d+}",              7 },
+        { "/users/{\\w+}",              8 },
+        { "/",                          9 },
+    };
+
+    router::path_map<int> single;
+    router::path_map<int> bulk;
+
+    for (const auto& [endpoint, value] : paths) {
+        single.add(endpoint, value);
+    }
+
+    // add a path first, so that the bulk paths are added to a non-empty map
+    single.add("/first", 10);
+    bulk.add("/first", 10);
+    bulk.add_all(begin(paths), end(paths));
+
+    std::vector<std::string_view> slugs_single;
+    std::vector<std::string_view> slugs_bulk;
+
+    for (std::string_view endpoint : { "/users/12", "/users/12/posts", "/users/me", "/users/abc", "/items/list", "/items/7", "/", "/first", "/missing" }) {
+        auto* expected  = single.find(slugs_single, endpoint);
+        auto* found     = bulk.find(slugs_bulk, endpoint);
+
+        REQUIRE((expected == nullptr) == (found == nullptr));
+
+        if (expected != nullptr) {
+            REQUIRE(*expected == *found);
+            REQUIRE(slugs_single == slugs_bulk);
+        }
+    }
+
+    // paths with too many slugs are rejected before anything is added
+    std::string pattern;
+
+    for (std::size_t i{ 0 }; i <= router::slug_list::capacity; ++i) {
+        pattern += "/{\\d+}";
+    }
+
+    std::vector<std::pair<std::string, int>> invalid{ { "/valid/{\\d+}", 11 }, { pattern, 12 } };
+
+    REQUIRE_THROWS_AS(bulk.add_all(begin(invalid), end(invalid)), std::length_error);
+    REQUIRE(bulk.find(slugs_bulk, "/valid/1") == nullptr);
+}
+
+TEST_CASE("slugs with the same pattern share a compiled expression", "[path-map]") {
+    std::vector<std::string_view> slugs;
+
+    // a map interns its expressions by default, simple slugs use a scanner
+    router::path_map<int> map;
+    map.add("/a/{\\d+-\\w+}",   1);
+    map.add("/b/{\\d+-\\w+}",   2);
+    map.add("/c/{[a-z]+x}",     3);
+    map.add("/d/{\\d+}",        4);
+
+    REQUIRE(map.matchers().size()       == 2);
+    REQUIRE(map.matchers().requests()   == 3);
+    REQUIRE(map.matchers().reused()     == 1);
+    REQUIRE(*map.find(slugs, "/b/12-ab") == 2);
+    REQUIRE(slugs == std::vector<std::string_view>{ "12-ab" });
+
+    // maps can share their expressions through a registry
+    auto registry = std::make_shared<router::matcher_registry>();
+
+    {
+        router::path_map<int> first;
+        router::path_map<int> second;
+
+        first.share_matchers(registry);
+        second.share_matchers(registry);
+        first.add("/a/{\\d+-\\w+}",     1);
+        second.add("/b/{\\d+-\\w+}",    2);
+        second.add("/c/{[a-z]+x}",      3);
+
+        REQUIRE(registry->size()    == 2);
+        REQUIRE(registry->reused()  == 1);
+        REQUIRE(&first.matchers()   == registry.get());
+
+        // an invalid pattern is not registered
+        REQUIRE_THROWS_AS(first.add("/e/{(\\d+}", 5), router::pattern_error);
+        REQUIRE(registry->size() == 2);
+    }
+
+    // the expressions are gone once no slug uses them anymore
+    REQUIRE(registry->size() == 0);
+
+    // and their patterns are removed as new ones are added
+    for (std::size_t i{ 0 }; i < 1000; ++i) {
+        registry->expression("a{" + std::to_string(i) + "}");
+    }
+
+    REQUIRE(registry->size() == 0);
+    REQUIRE(registry->entries() <= 64);
+}
+
+TEST_CASE("paths can be parsed in parallel", "[path-map]") {
+    // paths with regular expressions, many of them sharing the same one
+    std::vector<std::pair<std::string, int>> paths;
+
+    for (int i{ 0 }; i < 200; ++i) {
+        switch (i % 4) {
+            case 0:  paths.emplace_back("/users/{\\d+-\\w+}/" + std::to_string(i), i); break;
+            case 1:  paths.emplace_back("/items/{[a-f]+x|y}",                          i); break;
+            case 2:  paths.emplace_back("/{\\w+}/list/" + std::to_string(i),         i); break;
+            default: paths.emplace_back("/static/" + std::to_string(i),                i); break;
+        }
+    }
+
+    router::path_map<int> single;
+    router::path_map<int> threaded;
+    router::path_map<int> executed;
+
+    single.add_all(begin(paths), end(paths));
+    threaded.add_all(begin(paths), end(paths), 4);
+
+    // an executor running the tasks on the calling thread
+    std::size_t tasks{ 0 };
+
+    executed.add_all(begin(paths), end(paths), [&tasks](std::function<void()> task) {
+        ++tasks;
+        task();
+    }, 3);
+
+    // there are only two distinct expressions to compile
+    REQUIRE(tasks == 2);
+    REQUIRE(threaded.matchers().size() == 2);
+    REQUIRE(executed.matchers().size() == 2);
+
+    // paths without regular expressions are added without running any tasks
+    std::vector<std::pair<std::string, int>> simple{ { "/users/{\\d+}", 1 }, { "/items/{id:uint}", 2 }, { "/static", 3 } };
+    router::path_map<int>                       scanned;
+    std::vector<std::string_view>               scanned_slugs;
+
+    scanned.add_all(begin(simple), end(simple), [&tasks](std::function<void()> task) {
+        ++tasks;
+        task();
+    });
+
+    REQUIRE(tasks == 2);
+    REQUIRE(scanned.matchers().size() == 0);
+    REQUIRE(*scanned.find(scanned_slugs, "/items/5") == 2);
+
+    std::vector<std::string_view> slugs_single;
+    std::vector<std::string_view> slugs_other;
+
+    for (std::string_view endpoint : { "/users/1-a/0", "/users/1-a/4", "/items/abx", "/items/y", "/abc/list/2", "/static/3", "/static/4" }) {
+        auto* expected = single.find(slugs_single, endpoint);
+
+        for (auto* map : { &threaded, &executed }) {
+            auto* found = map->find(slugs_other, endpoint);
+
+            REQUIRE((expected == nullptr) == (found == nullptr));
+
+            if (expected != nullptr) {
+                REQUIRE(*expected == *found);
+                REQUIRE(slugs_single == slugs_other);
+            }
+        }
+    }
+
+    // the error for the first invalid path is reported, and nothing is added
+    paths.emplace_back("/bad/{[a-}/first", 1000);
+    paths.emplace_back("/bad/{(x}/second", 1001);
+
+    router::path_map<int> failed;
+
+    try {
+        failed.add_all(begin(paths), end(paths), 8);
+        FAIL("invalid paths were added");
+    } catch (const router::pattern_error& error) {
+        REQUIRE(error.pattern()     == "/bad/{[a-}/first");
+        REQUIRE(error.position()    == 5);
+    }
+
+    REQUIRE(failed.find(slugs_other, "/static/3") == nullptr);
+
+    // invalid slugs are reported the same way, whether added in parallel or not
+    for (std::string_view invalid : { "/b/{(x}", "/b/{x", "/b/{[a-}", "/b/{y:(}" }) {
+        std::vector<std::pair<std::string, int>>    routes{ { "/a/{\\d+-\\w+}", 1 }, { std::string{ invalid }, 2 } };
+        router::path_map<int>                       serial;
+        router::path_map<int>                       parallel;
+
+        std::string expected;
+        std::string found;
+
+        try {
+            serial.add_all(begin(routes), end(routes));
+        } catch (const router::pattern_error& error) {
+            expected = error.what();
+        }
+
+        try {
+            parallel.add_all(begin(routes), end(routes), [](std::function<void()> task) { task(); }, 2);
+        } catch (const router::pattern_error& error) {
+            found = error.what();
+        }
+
+        REQUIRE(!expected.empty());
+        REQUIRE(found == expected);
+    }
+}
@@ -103,3 +103,256 @@ TEST_CASE("paths and methods can be matched", "[path-method]") {
         REQUIRE(tester.post_invoked == true);
     }
 }
+
+static int value_callback(int value) { return value; }
+
+TEST_CASE("proxied endpoints can be matched and invoked later", "[path-method]") {
+    enum class method { get, put };
+
+    router::table<router::proxy<int(), method::get, method::put>> table;
+
+    table.add("/test/{\\d+}")
+        .set<method::get, &value_callback>();
+
+    auto match = table.match("/test/10");
+
+    REQUIRE(match.valid() == true);
+    REQUIRE(match.valid(method::get) == true);
+    REQUIRE(match.valid(method::put) == false);
+    REQUIRE(match(method::get) == 10);
+    REQUIRE_THROWS_AS(match(method::put), std::bad_function_call);
+
+    REQUIRE(table.match("/test/abc").valid() == false);
+    REQUIRE(table.match("/test/abc").valid(method::get) == false);
+}
+
+static void count_callback(int& total, int value) { total += value; }
+
+TEST_CASE("proxied endpoints can be routed in batches", "[path-method]") {
+    enum class method { get, put };
+
+    router::table<router::proxy<void(int&), method::get, method::put>> table;
+
+    table.add("/count/{\\d+}")
+        .set<method::get, &count_callback>();
+
+    std::vector<std::string_view>               endpoints{ "/count/1", "/count/2", "/count/3" };
+    int                                         total{ 0 };
+    std::vector<std::tuple<method, int&>>       parameters(endpoints.size(), std::tuple<method, int&>{ method::get, total });
+
+    table.route_batch(begin(endpoints), end(endpoints), begin(parameters));
+
+    REQUIRE(total == 6);
+
+    // a method without a handler cannot be routed
+    std::get<0>(parameters[1]) = method::put;
+
+    REQUIRE_THROWS_AS(table.route_batch(begin(endpoints), end(endpoints), begin(parameters)), std::out_of_range);
+    REQUIRE(total == 7);
+}
+
+TEST_CASE("proxied routes can be added at once", "[path-method]") {
+    enum class method { get, put };
+
+    using table_type = router::table<router::proxy<int(), method::get, method::put>>;
+
+    table_type::route_type::second_type proxy;
+    proxy.set<method::get, &value_callback>();
+
+    table_type table;
+    table.add_all({ { "/first/{\\d+}", proxy }, { "/second/{\\d+}", proxy } });
+
+    REQUIRE(table.route("/first/1", method::get) == 1);
+    REQUIRE(table.route("/second/2", method::get) == 2);
+    REQUIRE(table.routable("/third/3") == false);
+
+    // the patterns can also be compiled on multiple threads
+    std::vector<table_type::route_type> routes{ { "/first/{\\d+}", proxy }, { "/second/{\\d+}", proxy } };
+
+    table_type threaded;
+    threaded.add_all(begin(routes), end(routes), 2);
+
+    REQUIRE(threaded.route("/second/2", method::get) == 2);
+}
+
+TEST_CASE("methods are found with a single lookup", "[path-method]") {
+    enum class method { get, put, post, patch };
+
+    // methods lying close together use a dense table
+    using dense = router::variadic_index<method::post, method::get, method::patch, method::get>;
+
+    REQUIRE(dense::find(method::post)   == 0);
+    REQUIRE(dense::find(method::get)    == 1);
+    REQUIRE(dense::find(method::patch)  == 2);
+    REQUIRE(dense::find(method::put)    == dense::npos);
+
+    // values far apart use a perfect hash
+    using sparse = router::variadic_index<-5, 1000, 1 << 20, 7, 1000>;
+
+    REQUIRE(sparse::find(-5)        == 0);
+    REQUIRE(sparse::find(1000)      == 1);
+    REQUIRE(sparse::find(1 << 20)   == 2);
+    REQUIRE(sparse::find(7)         == 3);
+    REQUIRE(sparse::find(8)         == sparse::npos);
+    REQUIRE(sparse::find(0)         == sparse::npos);
+
+    static_assert(sparse::find(1 << 20) == 2, "the lookup can be done at compile time");
+}
+
+enum class sparse_method { get, put, post, remove };
+
+template <> constexpr bool router::sparse_proxy<sparse_method> = true;
+
+TEST_CASE("proxies can store only the methods that are set", "[path-method]") {
+    enum class method { get, put, post, remove };
+
+    using sparse_type   = router::proxy<int(), sparse_method::get, sparse_method::put, sparse_method::post, sparse_method::remove>;
+    using dense_type    = router::proxy<int(), method::get, method::put, method::post, method::remove>;
+
+    REQUIRE(sizeof(sparse_type) < sizeof(dense_type));
+
+    // every method slot holds no more than the callback and its instance
+    REQUIRE(sizeof(router::path_callback<int()>) == 2 * sizeof(void*));
+
+    router::table<sparse_type> table;
+
+    table.add("/test/{\\d+}")
+        .set<sparse_method::remove, &value_callback>()
+        .set<sparse_method::put, &value_callback>();
+
+    REQUIRE(table.route("/test/4", sparse_method::remove) == 4);
+    REQUIRE(table.route("/test/5", sparse_method::put) == 5);
+    REQUIRE(table.match("/test/6").valid(sparse_method::get) == false);
+    REQUIRE(table.match("/test/6").valid(sparse_method::post) == false);
+
+    // an unknown method is never valid
+    REQUIRE(table.match("/test/6").valid(static_cast<sparse_method>(42)) == false);
+}
+
+enum class http_method { get, head, put, options };
+
+using http_table = router::table<router::proxy<int(), http_method::get, http_method::head, http_method::put, http_method::options>>;
+
+static int get_callback() { return -1; }
+static int allowed_callback(http_table::method_set_type allowed) { return static_cast<int>(allowed.bits()); }
+
+TEST_CASE("proxy tables pass the allowed methods to the handlers", "[path-method]") {
+    http_table table;
+
+    table.add("/resource")
+        .set<http_method::get, &get_callback>();
+    table.add("/upload")
+        .set<http_method::put, &get_callback>();
+
+    // the allowed methods are available from a match
+    auto allowed = table.match("/resource").allowed();
+
+    REQUIRE(allowed.contains(http_method::get)     == true);
+    REQUIRE(allowed.contains(http_method::head)    == false);
+    REQUIRE(allowed.size() == 1);
+
+    // the missing-method handler receives the allowed methods
+    table.set_not_proxied<&allowed_callback>();
+
+    REQUIRE(table.route("/resource", http_method::put) == 0b0001);
+    REQUIRE(table.route("/upload", http_method::get) == 0b0100);
+
+    // head can be routed to the get handler
+    table.set_fallback<http_method::head, http_method::get>();
+
+    REQUIRE(table.route("/resource", http_method::head) == -1);
+    REQUIRE(table.route("/resource", http_method::put) == 0b0011);
+    REQUIRE(table.route("/upload", http_method::head) == 0b0100);
+
+    // options is answered with the allowed methods
+    table.set_options<http_method::options, &allowed_callback>();
+
+    REQUIRE(table.route("/resource", http_method::options) == 0b1011);
+    REQUIRE(table.route("/upload", http_method::options) == 0b1100);
+
+    // the match allows the same methods, listed in order
+    std::vector<http_method> methods;
+    table.match("/resource").allowed().for_each([&methods](http_method method) { methods.push_back(method); });
+
+    REQUIRE(methods == std::vector<http_method>{ http_method::get, http_method::head, http_method::options });
+    REQUIRE(table.match("/upload").allowed().bits() == 0b1100);
+    REQUIRE(table.match("/missing").allowed().empty());
+}
+
+static int other_callback() { return -2; }
+
+TEST_CASE("a callback can be set for multiple methods at once", "[path-method]") {
+    // a dense and a sparse proxy, which deduplicates the callbacks
+    router::proxy<int(), http_method::get, http_method::head, http_method::put, http_method::options>                       dense;
+    router::proxy<int(), sparse_method::get, sparse_method::put, sparse_method::post, sparse_method::remove>                 sparse;
+
+    dense.set<&get_callback>({ http_method::get, http_method::head });
+    sparse.set<&get_callback>({ sparse_method::get, sparse_method::remove });
+
+    REQUIRE(dense.allowed() == http_table::method_set_type{ http_method::get, http_method::head });
+    REQUIRE(dense.get(http_method::head)({}) == -1);
+    REQUIRE(sparse.get(sparse_method::remove)({}) == -1);
+    REQUIRE(sparse.get(sparse_method::put).valid() == false);
+
+    // replacing the callback for some of the methods keeps the others
+    dense.set<&other_callback>({ http_method::head, http_method::put });
+    sparse.set<&other_callback>({ sparse_method::get, sparse_method::put });
+
+    REQUIRE(dense.get(http_method::get)({}) == -1);
+    REQUIRE(dense.get(http_method::head)({}) == -2);
+    REQUIRE(dense.get(http_method::put)({}) == -2);
+    REQUIRE(sparse.get(sparse_method::get)({}) == -2);
+    REQUIRE(sparse.get(sparse_method::put)({}) == -2);
+    REQUIRE(sparse.get(sparse_method::remove)({}) == -1);
+
+    // the last method using a callback can switch to another one
+    sparse.set<sparse_method::remove, &other_callback>();
+
+    REQUIRE(sparse.get(sparse_method::remove)({}) == -2);
+    REQUIRE(sparse.get(sparse_method::post).valid() == false);
+}
+
+static int number_callback(int value) { return value; }
+
+TEST_CASE("proxied requests can be routed without exceptions", "[path-method]") {
+    http_table table;
+
+    table.add("/number/{[a-z0-9]+}")
+        .set<http_method::get, &number_callback>();
+
+    // failures are reported instead of thrown
+    REQUIRE(*table.try_route("/number/42", http_method::get) == 42);
+    REQUIRE(table.try_route("/other", http_method::get).error() == router::status::not_found);
+    REQUIRE(table.try_route("/number/42", http_method::put).error() == router::status::method_not_allowed);
+    REQUIRE(table.try_route("/number/abc", http_method::get).error() == router::status::conversion_failed);
+    REQUIRE(table.try_match("/other").error() == router::status::not_found);
+
+    // the missing-method handler is not invoked
+    table.set_not_proxied<&allowed_callback>();
+
+    REQUIRE(table.route("/number/42", http_method::put) == 0b0001);
+    REQUIRE(table.try_route("/number/42", http_method::put).error() == router::status::method_not_allowed);
+
+    // but fallbacks and the options handler are
+    table.set_fallback<http_method::head, http_method::get>();
+    table.set_options<http_method::options, &allowed_callback>();
+
+    REQUIRE(*table.try_route("/number/7", http_method::head) == 7);
+    REQUIRE(*table.try_route("/number/7", http_method::options) == 0b1011);
+    REQUIRE(table.try_route("/number/x", http_method::head).error() == router::status::conversion_failed);
+}
+
+static int seven_callback() { return 7; }
+static int integer_allowed(router::method_set<1, 2, 3> allowed) { return static_cast<int>(allowed.bits()); }
+
+TEST_CASE("proxies can use integer methods", "[path-method]") {
+    router::table<router::proxy<int(), 1, 2, 3>> table;
+
+    table.add("/a").set<3, &seven_callback>();
+    table.set_not_proxied<&integer_allowed>();
+
+    REQUIRE(table.route("/a", 3) == 7);
+    REQUIRE(table.route("/a", 1) == 0b100);
+    REQUIRE(table.match("/a").allowed() == router::method_set<1, 2, 3>{ 3 });
+    REQUIRE(router::method_set<1, 2, 3>::from_bits(0b011) == router::method_set<1, 2, 3>{ 1, 2 });
+}
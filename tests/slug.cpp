@@ -1,5 +1,7 @@
 #include <router/slug.h>
 
+#include <optional>
+
 #include <catch2/catch_all.hpp>
 
 TEST_CASE("slugs should correctly detect start and end", "[slug]") {
@@ -34,3 +36,215 @@ TEST_CASE("slugs should correctly detect start and end", "[slug]") {
         REQUIRE(pattern == "/test");
     }
 }
+
+TEST_CASE("simple slugs match exactly like regular expressions", "[slug]") {
+    // patterns handled by the scanner, and some that are not
+    std::string_view expressions[] = {
+        "\\d+", "\\w+", "\\s*", "\\D?", "\\W{2}", "\\S{1,3}", ".+", ".{2,}",
+        "[^/]+", "[0-9a-f]{24}", "[a-z0-9-]+", "[A-Za-z0-9_.~-]*",
+        "[\\d\\-]{0,4}", "[^\\w/]+", "[a-]+", "\\d+?", "\\d+|abc", "(\\d+)",
+    };
+
+    // inputs to test with, including every possible character
+    std::vector<std::string> inputs{
+        "", "123", "123abc", "abc/def", "  x", "5f1d7c3b2a9e8f7d6c5b4a3b", "a-b-c",
+        "5f1d7c3b2a9e8f7d6c5b4a3b9", "--12", "\n\r.", "a.b~c_d",
+    };
+
+    for (int character = 0; character < 256; ++character) {
+        inputs.emplace_back(2, static_cast<char>(character));
+    }
+
+    for (auto expression : expressions) {
+        // create the slug from the expression
+        std::string     pattern { "{" + std::string{ expression } + "}" };
+        std::string_view data   { pattern };
+        router::slug    slug    { data };
+        std::regex      regex   { begin(expression), end(expression) };
+
+        for (const auto& input : inputs) {
+            // match using the slug
+            std::string_view slug_input { input };
+            std::string_view slug_output{};
+            bool             matched    { slug.match(slug_input, slug_output) };
+
+            // match using the regular expression
+            std::match_results<std::string::const_iterator> results;
+            bool expected = std::regex_search(input.cbegin(), input.cend(), results, regex) && results.position(0) == 0;
+
+            INFO("expression " << expression << ", input " << input);
+            REQUIRE(matched == expected);
+
+            if (expected) {
+                REQUIRE(slug_output == input.substr(0, results.length(0)));
+                REQUIRE(slug_input.size() == input.size() - slug_output.size());
+            }
+        }
+    }
+}
+
+TEST_CASE("only simple patterns get a scanner", "[slug]") {
+    REQUIRE(router::scanner::parse("\\d+").has_value());
+    REQUIRE(router::scanner::parse("[0-9a-f]{24}").has_value());
+    REQUIRE(router::scanner::parse("[^/]+").has_value());
+
+    REQUIRE(!router::scanner::parse("").has_value());
+    REQUIRE(!router::scanner::parse("\\d+?").has_value());
+    REQUIRE(!router::scanner::parse("\\d+/\\d+").has_value());
+    REQUIRE(!router::scanner::parse("[]").has_value());
+    REQUIRE(!router::scanner::parse("\\d{3,2}").has_value());
+    REQUIRE(!router::scanner::parse("[\\n]").has_value());
+    REQUIRE(!router::scanner::parse("a+").has_value());
+}
+
+TEST_CASE("slugs can limit the data they look at", "[slug]") {
+    // a long input that the slugs should never fully scan
+    std::string input(4096, 'a');
+
+    SECTION("bounded scanner") {
+        std::string_view pattern{ "{*8:\\w+}/test" };
+        router::slug     slug   { pattern };
+
+        REQUIRE(pattern == "/test");
+        REQUIRE(slug.max_length() == 8);
+
+        std::string_view data   { input };
+        std::string_view output {};
+
+        REQUIRE(slug.match(data, output) == true);
+        REQUIRE(output == "aaaaaaaa");
+        REQUIRE(data.size() == input.size() - 8);
+    }
+
+    SECTION("bounded regular expression") {
+        std::string_view pattern{ "{*4:a+b}" };
+        router::slug     slug   { pattern };
+
+        std::string_view data   { input };
+        std::string_view output {};
+
+        REQUIRE(slug.match(data, output) == false);
+
+        std::string_view short_data{ "aab/test" };
+        REQUIRE(slug.match(short_data, output) == true);
+        REQUIRE(output == "aab");
+        REQUIRE(short_data == "/test");
+    }
+
+    SECTION("angle brackets belong to the pattern") {
+        std::string_view pattern{ "{<12>foo}" };
+        router::slug     slug   { pattern };
+
+        std::string_view data   { "<12>foo" };
+        std::string_view output {};
+
+        REQUIRE(slug.max_length() == std::string_view::npos);
+        REQUIRE(slug.match(data, output) == true);
+        REQUIRE(output == "<12>foo");
+    }
+
+    SECTION("an asterisk without a length is not a valid pattern") {
+        std::string_view pattern{ "{*a:b}" };
+
+        REQUIRE_THROWS_AS(router::slug{ pattern }, std::regex_error);
+    }
+
+    SECTION("regular expressions only match at the start") {
+        std::string_view pattern{ "{\\d+|x}" };
+        router::slug     slug   { pattern };
+
+        std::string_view data   { "abc123" };
+        std::string_view output {};
+
+        REQUIRE(slug.match(data, output) == false);
+        REQUIRE(data == "abc123");
+    }
+}
+
+TEST_CASE("typed slugs check their value while matching", "[slug]") {
+    // match a typed slug against the given data
+    auto match = [](std::string_view pattern, std::string_view data) -> std::optional<std::string_view> {
+        router::slug        slug    { pattern };
+        std::string_view    output  {};
+
+        if (!slug.match(data, output)) {
+            return std::nullopt;
+        }
+
+        return output;
+    };
+
+    SECTION("typed slugs have a name and a type") {
+        std::string_view pattern{ "{id:int}/rest" };
+        router::slug     slug   { pattern };
+
+        REQUIRE(pattern == "/rest");
+        REQUIRE(slug.type() != nullptr);
+        REQUIRE(slug.type()->name() == "id");
+        REQUIRE(slug.type()->type() == router::slug_type::kind::integer);
+        REQUIRE(slug.matcher() == nullptr);
+    }
+
+    SECTION("regular expressions are not typed") {
+        std::string_view pattern{ "{[a-z]+:\\d}" };
+        router::slug     slug   { pattern };
+
+        REQUIRE(slug.type() == nullptr);
+    }
+
+    SECTION("unknown types are regular expressions") {
+        std::string_view pattern{ "{id:integer}" };
+        router::slug     slug   { pattern };
+
+        REQUIRE(slug.type() == nullptr);
+        REQUIRE(match("{a:b}", "a:b/x") == "a:b");
+        REQUIRE(match("{a:b}", "5") == std::nullopt);
+    }
+
+    SECTION("integers are checked against their range") {
+        REQUIRE(match("{n:int}", "-42/x") == "-42");
+        REQUIRE(match("{n:int}", "2147483647") == "2147483647");
+        REQUIRE(match("{n:int}", "2147483648") == std::nullopt);
+        REQUIRE(match("{n:int}", "-2147483648") == "-2147483648");
+        REQUIRE(match("{n:int}", "-2147483649") == std::nullopt);
+        REQUIRE(match("{n:int}", "-") == std::nullopt);
+        REQUIRE(match("{n:int64}", "9223372036854775807") == "9223372036854775807");
+        REQUIRE(match("{n:int64}", "9223372036854775808") == std::nullopt);
+        REQUIRE(match("{n:int64}", "-9223372036854775808") == "-9223372036854775808");
+        REQUIRE(match("{n:int64}", "-9223372036854775809") == std::nullopt);
+        REQUIRE(match("{n:int8}", "127") == "127");
+        REQUIRE(match("{n:int8}", "128") == std::nullopt);
+        REQUIRE(match("{n:int8}", "-128") == "-128");
+        REQUIRE(match("{n:uint}", "4294967295") == "4294967295");
+        REQUIRE(match("{n:uint}", "4294967296") == std::nullopt);
+        REQUIRE(match("{n:uint}", "-1") == std::nullopt);
+        REQUIRE(match("{n:uint64}", "18446744073709551615") == "18446744073709551615");
+        REQUIRE(match("{n:uint64}", "18446744073709551616") == std::nullopt);
+        REQUIRE(match("{n:uint16}", "65535") == "65535");
+        REQUIRE(match("{n:uint16}", "65536") == std::nullopt);
+    }
+
+    SECTION("floats are decimal numbers that fit a double") {
+        REQUIRE(match("{f:float}", "1.5/x") == "1.5");
+        REQUIRE(match("{f:float}", "-.5") == "-.5");
+        REQUIRE(match("{f:float}", "2.") == "2.");
+        REQUIRE(match("{f:float}", "1e3") == "1e3");
+        REQUIRE(match("{f:float}", "1e") == "1");
+        REQUIRE(match("{f:float}", "1e999") == std::nullopt);
+        REQUIRE(match("{f:float}", ".") == std::nullopt);
+        REQUIRE(match("{f:float}", "inf") == std::nullopt);
+    }
+
+    SECTION("segments, hex and uuids") {
+        REQUIRE(match("{s:segment}", "abc/def") == "abc");
+        REQUIRE(match("{s:segment}", "/def") == std::nullopt);
+        REQUIRE(match("{h:hex}", "00fFz") == "00fF");
+        REQUIRE(match("{u:uuid}", "123e4567-e89b-12d3-a456-426614174000/x") == "123e4567-e89b-12d3-a456-426614174000");
+        REQUIRE(match("{u:uuid}", "123e4567-e89b-12d3-a456-42661417400") == std::nullopt);
+        REQUIRE(match("{u:uuid}", "123e4567e89b-12d3-a456-426614174000x") == std::nullopt);
+    }
+
+    SECTION("typed slugs respect the maximum length") {
+        REQUIRE(match("{*2:n:int}", "123") == "12");
+    }
+}
@@ -0,0 +1,172 @@
+#include <router/statistics.h>
+#include <router/table.h>
+
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_all.hpp>
+
+static int found() { return 1; }
+static int number(int value) { return value; }
+static int not_proxied() { return -1; }
+
+TEST_CASE("statistics add up the counters from all threads", "[statistics]") {
+    router::statistics statistics;
+    statistics.resize(2);
+
+    SECTION("counters start at zero") {
+        auto snapshot = statistics.collect();
+
+        REQUIRE(snapshot.routes.size() == 2);
+        REQUIRE(snapshot.routes[0].hits == 0);
+        REQUIRE(snapshot.not_found == 0);
+        REQUIRE(std::accumulate(begin(snapshot.latency), end(snapshot.latency), std::uint64_t{ 0 }) == 0);
+    }
+
+    SECTION("counters from other threads are included") {
+        // count from a number of threads at the same time
+        std::vector<std::thread> threads;
+
+        for (std::size_t i{ 0 }; i < 4; ++i) {
+            threads.emplace_back([&statistics]() {
+                for (std::size_t j{ 0 }; j < 1000; ++j) {
+                    statistics.record(1);
+                    statistics.candidate(0);
+                    statistics.regex(0, 10);
+                    statistics.record(router::statistics::npos);
+                    statistics.not_proxied();
+                }
+            });
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        auto snapshot = statistics.collect();
+
+        REQUIRE(snapshot.routes[0].hits == 0);
+        REQUIRE(snapshot.routes[1].hits == 4000);
+        REQUIRE(snapshot.routes[0].candidates == 4000);
+        REQUIRE(snapshot.routes[0].regex_calls == 4000);
+        REQUIRE(snapshot.routes[0].regex_time == 40000);
+        REQUIRE(snapshot.not_found == 4000);
+        REQUIRE(snapshot.not_proxied == 4000);
+    }
+
+    SECTION("counters are kept when adding routes") {
+        statistics.record(1);
+        statistics.resize(100);
+        statistics.record(99);
+
+        auto snapshot = statistics.collect();
+
+        REQUIRE(snapshot.routes.size() == 100);
+        REQUIRE(snapshot.routes[1].hits == 1);
+        REQUIRE(snapshot.routes[99].hits == 1);
+    }
+
+    SECTION("copies take over the counters") {
+        statistics.record(0);
+
+        router::statistics copy{ statistics };
+        copy.record(0);
+
+        REQUIRE(statistics.collect().routes[0].hits == 1);
+        REQUIRE(copy.collect().routes[0].hits == 2);
+    }
+
+    SECTION("counters can be reset") {
+        statistics.record(0);
+        statistics.latency(100);
+        statistics.reset();
+
+        auto snapshot = statistics.collect();
+
+        REQUIRE(snapshot.routes[0].hits == 0);
+        REQUIRE(snapshot.latency[router::statistics::bucket(100)] == 0);
+    }
+
+    SECTION("latencies are bucketed on their magnitude") {
+        REQUIRE(router::statistics::bucket(0) == 0);
+        REQUIRE(router::statistics::bucket(1) == 1);
+        REQUIRE(router::statistics::bucket(2) == 2);
+        REQUIRE(router::statistics::bucket(3) == 2);
+        REQUIRE(router::statistics::bucket(1024) == 11);
+        REQUIRE(router::statistics::bucket(~std::uint64_t{ 0 }) == router::statistics::buckets - 1);
+    }
+}
+
+TEST_CASE("tables count how endpoints are routed", "[statistics]") {
+    router::table<int()> table;
+    table.add<&found>("/static");
+    table.add<&number>("/items/{\\d+}");
+    table.add<&number>("/items/{[0-9]+}/{\\d+}");
+
+    table.route("/static");
+    table.route("/items/42");
+    table.route("/items/42");
+    table.routable("/items/x");
+
+    auto snapshot = table.statistics();
+
+    if constexpr (!router::statistics::enabled) {
+        // without instrumentation nothing is counted
+        REQUIRE(snapshot.routes.empty());
+        REQUIRE(snapshot.not_found == 0);
+    } else {
+        REQUIRE(snapshot.routes.size() == 3);
+        REQUIRE(snapshot.routes[0].hits == 1);
+        REQUIRE(snapshot.routes[1].hits == 2);
+        REQUIRE(snapshot.routes[2].hits == 0);
+        REQUIRE(snapshot.not_found == 1);
+
+        // the most recently added path is tried first
+        REQUIRE(snapshot.routes[0].candidates == 0);
+        REQUIRE(snapshot.routes[1].candidates == 3);
+        REQUIRE(snapshot.routes[2].candidates == 3);
+
+        // the slugs use a scanner, so no regular expression is involved
+        REQUIRE(snapshot.routes[1].regex_calls == 0);
+
+        // every lookup ended up in a latency bucket
+        REQUIRE(std::accumulate(begin(snapshot.latency), end(snapshot.latency), std::uint64_t{ 0 }) == 4);
+
+        SECTION("slugs needing a regular expression are timed") {
+            router::table<int()> expressions;
+            expressions.add<&found>("/{(en|nl)}/home");
+
+            expressions.route("/en/home");
+
+            REQUIRE(expressions.statistics().routes[0].regex_calls == 1);
+        }
+
+        SECTION("frozen and compiled tables count as well") {
+            table.reset_statistics();
+            table.freeze();
+            table.route("/items/42");
+
+            REQUIRE(table.statistics().routes[1].hits == 1);
+            REQUIRE(table.statistics().routes[1].candidates == 1);
+
+            table.compile();
+            table.route("/items/42");
+
+            REQUIRE(table.statistics().routes[1].hits == 2);
+        }
+    }
+}
+
+TEST_CASE("proxy tables count methods that are not proxied", "[statistics]") {
+    enum class method { get, put };
+
+    router::table<router::proxy<int(), method::get, method::put>> table;
+    table.add("/resource").set<method::get, &found>();
+    table.set_not_proxied<&not_proxied>();
+
+    table.route("/resource", method::get);
+    table.route("/resource", method::put);
+
+    REQUIRE(table.statistics().not_proxied == (router::statistics::enabled ? 1 : 0));
+}
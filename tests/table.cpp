@@ -182,3 +182,543 @@ TEST_CASE("paths can be matched", "[path]") {
         REQUIRE(tester.slug() == "hello_callback");
     }
 }
+
+static std::size_t first_callback() { return 1; }
+static std::size_t second_callback(std::size_t value) { return value; }
+
+TEST_CASE("compiled tables route like regular tables", "[table]") {
+    router::table<std::size_t()> table;
+
+    table.add<&first_callback>("/first");
+    table.add<&second_callback>("/second/{\\d+}");
+
+    REQUIRE(table.compile() == true);
+
+    REQUIRE(table.route("/first") == 1);
+    REQUIRE(table.route("/second/42") == 42);
+    REQUIRE(table.routable("/second/abc") == false);
+}
+
+static std::size_t add_callback(std::size_t offset, std::size_t value) { return offset + value; }
+
+TEST_CASE("endpoints can be matched and invoked later", "[table]") {
+    router::table<std::size_t(std::size_t)> table;
+
+    table.add<&add_callback>("/add/{\\d+}");
+
+    // match the endpoint without invoking anything
+    std::string endpoint{ "/add/40" };
+    auto match = table.match(endpoint);
+
+    REQUIRE(match.valid() == true);
+    REQUIRE(match.slugs().size() == 1);
+    REQUIRE(match.slugs()[0] == "40");
+
+    // the match can be invoked multiple times
+    REQUIRE(match(2) == 42);
+    REQUIRE(match(3) == 43);
+
+    // unknown endpoints give an invalid match
+    auto missing = table.match("/subtract/40");
+
+    REQUIRE(missing.valid() == false);
+    REQUIRE_THROWS_AS(missing(2), std::bad_function_call);
+}
+
+TEST_CASE("endpoints can be matched and routed in batches", "[table]") {
+    router::table<std::size_t(std::size_t)> table;
+
+    table.add<&add_callback>("/add/{\\d+}");
+
+    // enough endpoints to span multiple chunks
+    std::vector<std::string> endpoints;
+
+    for (std::size_t i{ 0 }; i < 150; ++i) {
+        endpoints.push_back("/add/" + std::to_string(i));
+    }
+
+    SECTION("matching") {
+        std::vector<router::table<std::size_t(std::size_t)>::match_type> matches;
+        table.match_batch(begin(endpoints), end(endpoints), std::back_inserter(matches));
+
+        REQUIRE(matches.size() == endpoints.size());
+
+        for (std::size_t i{ 0 }; i < matches.size(); ++i) {
+            REQUIRE(matches[i].valid() == true);
+            REQUIRE(matches[i](1) == i + 1);
+        }
+    }
+
+    SECTION("routing") {
+        std::vector<std::tuple<std::size_t>>    parameters(endpoints.size(), std::make_tuple(std::size_t{ 10 }));
+        std::vector<std::size_t>                results;
+
+        table.route_batch(begin(endpoints), end(endpoints), begin(parameters), std::back_inserter(results));
+
+        REQUIRE(results.size() == endpoints.size());
+
+        for (std::size_t i{ 0 }; i < results.size(); ++i) {
+            REQUIRE(results[i] == i + 10);
+        }
+    }
+
+    SECTION("unknown endpoints") {
+        endpoints[100] = "/subtract/100";
+
+        std::vector<router::table<std::size_t(std::size_t)>::match_type> matches;
+        table.match_batch(begin(endpoints), end(endpoints), std::back_inserter(matches));
+
+        REQUIRE(matches[99].valid() == true);
+        REQUIRE(matches[100].valid() == false);
+
+        std::vector<std::tuple<std::size_t>>    parameters(endpoints.size(), std::make_tuple(std::size_t{ 0 }));
+        std::vector<std::size_t>                results;
+
+        REQUIRE_THROWS_AS(table.route_batch(begin(endpoints), end(endpoints), begin(parameters), std::back_inserter(results)), std::out_of_range);
+        REQUIRE(results.size() == 100);
+    }
+}
+
+TEST_CASE("routes can be added at once", "[table]") {
+    using table_type = router::table<std::size_t(std::size_t)>;
+
+    table_type table;
+
+    table.add_all({
+        table_type::make_route<&add_callback>("/add/{\\d+}"),
+        table_type::make_route<&second_callback>("/second"),
+    });
+
+    REQUIRE(table.route("/add/40", 2) == 42);
+    REQUIRE(table.route("/second", 7) == 7);
+
+    // the patterns can also be compiled on multiple threads
+    std::vector<table_type::route_type> routes{
+        table_type::make_route<&add_callback>("/add/{\\d+|x}"),
+        table_type::make_route<&second_callback>("/second/{\\d+|x}"),
+    };
+
+    table_type threaded;
+    threaded.add_all(begin(routes), end(routes), 2);
+
+    REQUIRE(threaded.route("/add/40", 2) == 42);
+    REQUIRE(threaded.route("/second/x", 7) == 7);
+    REQUIRE(threaded.matchers().size() == 1);
+}
+
+TEST_CASE("lookups can be explained", "[table]") {
+    router::table<void()> table;
+    table.add<&free_callback>("/static");
+    table.add<&free_callback>("/{\\w+}/items");
+    table.add<&free_callback>("/items/{\\d+}");
+    table.add<&free_callback>("/items/{\\d+}/tags");
+    table.add<&free_callback>("{[^f]+}feed");
+
+    SECTION("exact matches try no candidates") {
+        auto trace = table.explain("/static");
+
+        REQUIRE(trace.exact == true);
+        REQUIRE(trace.route == 0);
+        REQUIRE(trace.candidates.empty());
+    }
+
+    SECTION("candidates are listed in the order they are tried") {
+        auto trace = table.explain("/items/42");
+
+        REQUIRE(trace.exact == false);
+        REQUIRE(trace.route == 2);
+        REQUIRE(trace.candidates.size() == 3);
+        REQUIRE(trace.candidates[0].route == 1);
+        REQUIRE(trace.candidates[0].prefix == "/");
+        REQUIRE(trace.candidates[0].failed == router::trace::stage::suffix);
+        REQUIRE(trace.candidates[0].consumed == 6);
+        REQUIRE(trace.candidates[1].route == 3);
+        REQUIRE(trace.candidates[1].failed == router::trace::stage::suffix);
+        REQUIRE(trace.candidates[1].consumed == 9);
+        REQUIRE(trace.candidates[2].route == 2);
+        REQUIRE(trace.candidates[2].failed == router::trace::stage::matched);
+    }
+
+    SECTION("paths without a prefix are tried last") {
+        auto trace = table.explain("/items/feed");
+
+        REQUIRE(trace.route == 4);
+        REQUIRE(trace.candidates.size() == 4);
+        REQUIRE(trace.candidates[1].failed == router::trace::stage::slug);
+        REQUIRE(trace.candidates[2].failed == router::trace::stage::slug);
+        REQUIRE(trace.candidates[3].route == 4);
+        REQUIRE(trace.candidates[3].prefix.empty());
+    }
+
+    SECTION("endpoints that are not found") {
+        auto trace = table.explain("/other");
+
+        REQUIRE(trace.route == router::trace::npos);
+        REQUIRE(trace.candidates.size() == 2);
+        REQUIRE(trace.candidates[0].failed == router::trace::stage::suffix);
+        REQUIRE(trace.candidates[1].failed == router::trace::stage::suffix);
+    }
+}
+
+static int number(int value) { return value; }
+static int small_number(std::uint8_t value) { return value; }
+static int any_number(std::int64_t value) { return static_cast<int>(value % 1000); }
+static int ratio(double value) { return static_cast<int>(value * 10); }
+static int segment(std::string_view name, std::string_view id) { return static_cast<int>(name.size() + id.size()); }
+
+TEST_CASE("typed slugs are checked before routing", "[table]") {
+    router::table<int()> table;
+    table.add<&any_number>("/numbers/{n:int}");
+    table.add<&small_number>("/numbers/{n:uint8}");
+    table.add<&ratio>("/ratio/{r:float}");
+
+    // values that do not fit the type do not match the route
+    REQUIRE(table.route("/numbers/200") == 200);
+    REQUIRE(table.route("/numbers/1200") == 200);
+    REQUIRE(table.route("/numbers/-5") == -5);
+    REQUIRE(table.routable("/numbers/99999999999999999999") == false);
+
+    // int matches the width of a C++ int, so the callback can always take it
+    router::table<int()> widths;
+    widths.add<&number>("/number/{n:int}");
+
+    REQUIRE(widths.route("/number/2147483647") == 2147483647);
+    REQUIRE(widths.routable("/number/3000000000") == false);
+
+    // floats are converted for the callback
+    REQUIRE(table.route("/ratio/2.5") == 25);
+    REQUIRE(table.routable("/ratio/x") == false);
+
+    SECTION("typed slugs can be compiled") {
+        router::table<int()> compiled;
+        compiled.add<&segment>("/segment/{name:segment}/{id:hex}");
+        compiled.add<&any_number>("/numbers/{n:int}");
+
+        REQUIRE(compiled.compile() == false);
+
+        router::table<int()> segments;
+        segments.add<&segment>("/segment/{name:segment}/{id:hex}");
+
+        REQUIRE(segments.compile() == true);
+        REQUIRE(segments.route("/segment/abc/ff") == 5);
+        REQUIRE(segments.routable("/segment/abc/fg") == false);
+    }
+}
+
+static int missing() { return -1; }
+static void store(int& output, int value) { output = value; }
+
+TEST_CASE("requests can be routed without exceptions", "[table]") {
+    router::table<int()> table;
+    table.add<&number>("/number/{[a-z0-9]+}");
+
+    // the result holds the value returned by the callback
+    auto found = table.try_route("/number/42");
+
+    REQUIRE(found.has_value() == true);
+    REQUIRE(found.error() == router::status::ok);
+    REQUIRE(*found == 42);
+
+    // failures are reported instead of thrown
+    REQUIRE(table.try_route("/other").error() == router::status::not_found);
+    REQUIRE(table.try_route("/number/abc").error() == router::status::conversion_failed);
+    REQUIRE(table.try_route("/number/99999999999").error() == router::status::conversion_failed);
+    REQUIRE_THROWS_AS(table.route("/number/abc"), std::range_error);
+
+    SECTION("matches can be invoked without exceptions") {
+        REQUIRE(table.try_match("/other").error() == router::status::not_found);
+
+        auto match = table.try_match("/number/abc");
+
+        REQUIRE(match.has_value() == true);
+        REQUIRE(match->try_invoke().error() == router::status::conversion_failed);
+    }
+
+    SECTION("the not-found handler is not invoked") {
+        table.set_not_found<&missing>();
+
+        REQUIRE(table.route("/other") == -1);
+        REQUIRE(table.try_route("/other").error() == router::status::not_found);
+    }
+
+    SECTION("callbacks without a result") {
+        router::table<void(int&)> stores;
+        stores.add<&store>("/store/{[a-z0-9]+}");
+
+        int output{ 0 };
+
+        REQUIRE(stores.try_route("/store/7", output).has_value() == true);
+        REQUIRE(stores.try_route("/store/x", output).error() == router::status::conversion_failed);
+        REQUIRE(output == 7);
+    }
+}
+
+static int item_name(std::string_view name) { return -static_cast<int>(name.size()); }
+
+namespace {
+
+    // a field counting how often it is converted
+    struct counted {
+        int value;
+    };
+
+    std::size_t conversions{ 0 };
+
+    void process_field(std::string_view input, counted& output) {
+        ++conversions;
+        router::process_field(input, output.value);
+    }
+
+    bool parse_field(std::string_view input, counted& output) {
+        ++conversions;
+        return router::parse_field(input, output.value);
+    }
+
+}
+
+static int counted_callback(counted value) { return value.value; }
+
+TEST_CASE("routes whose slugs cannot be converted can be skipped", "[table]") {
+    router::table<int()> table;
+    table.add<&item_name>("/items/{[a-z0-9]+}");
+    table.add<&number>("/items/{[a-z0-9]+}");
+
+    // without checking, the most recent route fails to convert
+    REQUIRE(table.route("/items/42") == 42);
+    REQUIRE_THROWS_AS(table.route("/items/99999999999999999999"), std::range_error);
+    REQUIRE(table.try_route("/items/abc").error() == router::status::conversion_failed);
+
+    table.enable_conversion_check();
+
+    SECTION("the next candidate is tried") {
+        REQUIRE(table.route("/items/42") == 42);
+        REQUIRE(table.route("/items/99999999999999999999") == -20);
+        REQUIRE(*table.try_route("/items/abc") == -3);
+        REQUIRE(table.match("/items/abc")() == -3);
+    }
+
+    SECTION("the trace shows the routes that were skipped") {
+        auto trace = table.explain("/items/abc");
+
+        REQUIRE(trace.route == 0);
+        REQUIRE(trace.candidates.size() == 2);
+        REQUIRE(trace.candidates[0].route == 1);
+        REQUIRE(trace.candidates[0].failed == router::trace::stage::conversion);
+        REQUIRE(trace.candidates[1].failed == router::trace::stage::matched);
+        REQUIRE(table.explain("/items/42").route == 1);
+    }
+
+    SECTION("with a compiled, frozen or cached table") {
+        REQUIRE(table.compile() == true);
+        REQUIRE(table.route("/items/abc") == -3);
+
+        table.freeze();
+        REQUIRE(table.route("/items/abc") == -3);
+
+        table.enable_cache(16);
+        REQUIRE(table.route("/items/abc") == -3);
+        REQUIRE(table.route("/items/abc") == -3);
+        REQUIRE(table.route("/items/42") == 42);
+        REQUIRE(table.route("/items/42") == 42);
+        REQUIRE(table.cache_hits() == 2);
+    }
+
+    SECTION("routes that cannot take the slugs are not found") {
+        router::table<int()> numbers;
+        numbers.add<&number>("/items/{[a-z0-9]+}");
+        numbers.set_not_found<&missing>();
+        numbers.enable_conversion_check();
+
+        REQUIRE(numbers.routable("/items/abc") == false);
+        REQUIRE(numbers.route("/items/abc") == -1);
+        REQUIRE(numbers.try_route("/items/abc").error() == router::status::conversion_failed);
+        REQUIRE(numbers.try_route("/other").error() == router::status::not_found);
+    }
+
+    SECTION("the slugs are converted once") {
+        router::table<int()> counting;
+        counting.add<&counted_callback>("/counted/{[a-z0-9]+}");
+        counting.enable_conversion_check();
+
+        conversions = 0;
+
+        REQUIRE(counting.route("/counted/5") == 5);
+        REQUIRE(*counting.try_route("/counted/6") == 6);
+        REQUIRE(conversions == 2);
+    }
+}
+
+namespace names {
+    constexpr char page[] = "page";
+}
+
+namespace {
+
+    struct paging
+    {
+        int page{ 1 };
+
+        using query_dto = router::query_dto<paging>
+            ::bind<&paging::page, names::page>;
+    };
+
+}
+
+static int query_item(router::query parameters, int id) { return id * 10 + static_cast<int>(parameters.find("page").value_or("").size()); }
+static int paged_item(paging parameters, int id) { return id * 10 + parameters.page; }
+static int paged_list(const paging& parameters) { return parameters.page; }
+
+TEST_CASE("the query is split from the endpoint", "[table]") {
+    router::table<int()> table;
+
+    table.add<&query_item>("/items/{\\d+}");
+    table.add<&paged_item>("/pages/{\\d+}");
+    table.add<&paged_list>("/pages");
+
+    SECTION("the path is matched without the query") {
+        REQUIRE(table.routable("/pages?page=2") == true);
+        REQUIRE(table.route("/pages") == 1);
+        REQUIRE(table.route("/pages?page=4") == 4);
+        REQUIRE(table.route("/items/5?page=22") == 52);
+        REQUIRE(table.route("/items/5") == 50);
+    }
+
+    SECTION("the query is converted for the callback") {
+        REQUIRE(table.route("/pages/3?page=7") == 37);
+        REQUIRE(table.match("/pages/3?other&page=2")() == 32);
+        REQUIRE(table.try_route("/pages/3?page=x").error() == router::status::conversion_failed);
+        REQUIRE_THROWS(table.route("/pages/3?page=x"));
+    }
+
+    SECTION("the query is checked while matching") {
+        table.enable_conversion_check();
+
+        REQUIRE(table.route("/pages/3?page=7") == 37);
+        REQUIRE(table.try_route("/pages/3?page=x").error() == router::status::conversion_failed);
+    }
+
+    SECTION("the query is kept when matching in batches") {
+        std::vector<std::string_view>                   targets{ "/pages?page=5", "/items/2?page=1", "/missing?page=1" };
+        std::vector<decltype(table)::match_type>        matches;
+
+        table.match_batch(targets.begin(), targets.end(), std::back_inserter(matches));
+
+        REQUIRE(matches.size() == 3);
+        REQUIRE(matches[0]() == 5);
+        REQUIRE(matches[1]() == 21);
+        REQUIRE(matches[2].valid() == false);
+    }
+}
+
+static std::string decoded_name(router::decoded<std::string_view> first, router::decoded<std::string> second) { return std::string{ *first } + "|" + *second; }
+static std::string escaped_name(std::string_view first, router::decoded<std::string> second) { return std::string{ first } + "|" + *second; }
+static std::size_t decoded_size(router::decoded<std::string_view> name) { return name->size(); }
+static int decoded_number(router::decoded<int> value) { return *value; }
+
+/**
+ *  A dto with its own conversion, which reads every slug twice
+ */
+struct twice_decoded
+{
+    std::string first;
+    std::string second;
+
+    struct dto
+    {
+        template <typename slug_container>
+        static void to_dto(const slug_container& slugs, twice_decoded& output)
+        {
+            // the fields taking the decoded data
+            router::decoded<std::string_view> first;
+            router::decoded<std::string_view> second;
+
+            for (std::size_t i{ 0 }; i < 2; ++i) {
+                auto iter = begin(slugs);
+
+                router::impl::process_slug(*iter++, first);
+                router::impl::process_slug(*iter++, second);
+            }
+
+            output.first    = std::string{ *first   } + std::string{ *first     };
+            output.second   = std::string{ *second  } + std::string{ *second    };
+        }
+
+        template <typename slug_container>
+        static bool try_to_dto(const slug_container& slugs, twice_decoded& output)
+        {
+            to_dto(slugs, output);
+            return true;
+        }
+    };
+};
+
+static std::string twice_name(twice_decoded&& names) { return names.first + "|" + names.second; }
+
+TEST_CASE("slugs are percent-decoded for the callback", "[table]") {
+    router::table<std::string()> names;
+    names.add<&decoded_name>("/names/{[^/]+}/{[^/]+}");
+
+    SECTION("slugs with escapes are decoded") {
+        REQUIRE(names.route("/names/a%20b/c%2Fd") == "a b|c/d");
+        REQUIRE(names.route("/names/plain/text") == "plain|text");
+        REQUIRE(names.match("/names/%41%62/x")() == "Ab|x");
+        REQUIRE(*names.try_route("/names/%e2%82%ac/x") == "\xe2\x82\xac|x");
+    }
+
+    SECTION("invalid escapes are kept") {
+        REQUIRE(names.route("/names/100%/%zz%4") == "100%|%zz%4");
+    }
+
+    SECTION("slugs are decoded when converted while matching") {
+        names.enable_conversion_check();
+
+        REQUIRE(names.route("/names/a%20b/c") == "a b|c");
+        REQUIRE(*names.try_route("/names/a/%7E") == "a|~");
+    }
+
+    SECTION("long slugs are decoded") {
+        router::table<std::size_t()> sizes;
+        sizes.add<&decoded_size>("/sizes/{[^/]+}");
+
+        std::string endpoint{ "/sizes/" };
+
+        for (std::size_t i{ 0 }; i < 200; ++i) {
+            endpoint += "%41";
+        }
+
+        REQUIRE(sizes.route(endpoint) == 200);
+
+        sizes.enable_conversion_check();
+        REQUIRE(sizes.route(endpoint) == 200);
+    }
+
+    SECTION("only fields taking decoded data are decoded") {
+        router::table<std::string()> escaped;
+        escaped.add<&escaped_name>("/names/{[^/]+}/{[^/]+}");
+
+        REQUIRE(escaped.route("/names/a%20b/c%2Fd") == "a%20b|c/d");
+        REQUIRE(*escaped.try_route("/names/%41/%42") == "%41|B");
+    }
+
+    SECTION("decoding a slug again gives the same data") {
+        router::table<std::string()> twice;
+        twice.add<&twice_name>("/names/{[^/]+}/{[^/]+}");
+
+        std::string endpoint{ "/names/" };
+
+        for (std::size_t i{ 0 }; i < 100; ++i) {
+            endpoint += "%41";
+        }
+
+        REQUIRE(twice.route(endpoint + "/%42%43") == std::string(200, 'A') + "|BCBC");
+        REQUIRE(twice.route("/names/%41/%42") == "AA|BB");
+    }
+
+    SECTION("numbers are decoded before they are converted") {
+        router::table<int()> numbers;
+        numbers.add<&decoded_number>("/numbers/{[^/]+}");
+
+        REQUIRE(numbers.route("/numbers/%34%32") == 42);
+        REQUIRE(numbers.try_route("/numbers/%34x").error() == router::status::conversion_failed);
+    }
+}
@@ -35,3 +35,147 @@ TEST_CASE("slugs should parse correctly into structs") {
         REQUIRE(std::get<2>(output) == "def");
     }
 }
+
+namespace {
+
+    // a field that can be set without throwing
+    struct identifier {
+        std::string value;
+    };
+
+    // the number of times the non-throwing customization was used
+    std::size_t parsed_identifiers{ 0 };
+
+    void process_field(std::string_view input, identifier& output) {
+        if (input.size() > 3) {
+            throw std::range_error{ "Identifier too long" };
+        }
+
+        output.value.assign(input);
+    }
+
+    bool parse_field(std::string_view input, identifier& output) {
+        ++parsed_identifiers;
+
+        if (input.size() > 3) {
+            return false;
+        }
+
+        output.value.assign(input);
+        return true;
+    }
+
+}
+
+TEST_CASE("slugs can be parsed without exceptions") {
+    SECTION("parse slugs into struct") {
+        struct dto_struct {
+            std::string field1;
+            std::size_t field2;
+
+            using dto =
+                router::dto<dto_struct>::bind<&dto_struct::field1>::bind<
+                    &dto_struct::field2>;
+        };
+
+        dto_struct output{};
+
+        REQUIRE(router::try_to_dto(std::vector<std::string_view>{"abc", "10"}, output) == true);
+        REQUIRE(output.field1 == "abc");
+        REQUIRE(output.field2 == 10);
+
+        // invalid numbers and a wrong number of slugs fail
+        REQUIRE(router::try_to_dto(std::vector<std::string_view>{"abc", "10x"}, output) == false);
+        REQUIRE(router::try_to_dto(std::vector<std::string_view>{"abc", "-1"}, output) == false);
+        REQUIRE(router::try_to_dto(std::vector<std::string_view>{"abc"}, output) == false);
+    }
+
+    SECTION("parse slugs with a custom field") {
+        std::tuple<identifier, int> output{};
+
+        REQUIRE(router::try_to_dto(std::vector<std::string_view>{"abc", "5"}, output) == true);
+        REQUIRE(std::get<0>(output).value == "abc");
+        REQUIRE(std::get<1>(output) == 5);
+
+        REQUIRE(router::try_to_dto(std::vector<std::string_view>{"abcd", "5"}, output) == false);
+        REQUIRE(parsed_identifiers == 2);
+
+        // the throwing conversion still uses process_field
+        REQUIRE_THROWS_AS(router::to_dto(std::vector<std::string_view>{"abcd", "5"}, output), std::range_error);
+    }
+}
+
+TEST_CASE("query parameters can be read", "[query]") {
+    SECTION("split the query from an endpoint") {
+        auto [path, parameters] = router::query::split("/items?page=2&sort");
+
+        REQUIRE(path == "/items");
+        REQUIRE(parameters.data() == "page=2&sort");
+
+        auto [plain, empty] = router::query::split("/items");
+
+        REQUIRE(plain == "/items");
+        REQUIRE(empty.empty() == true);
+    }
+
+    SECTION("iterate over the parameters") {
+        router::query parameters{ "a=1&&b=&c&a=2" };
+        std::vector<std::pair<std::string_view, std::string_view>> found{ parameters.begin(), parameters.end() };
+
+        REQUIRE(found.size() == 4);
+        REQUIRE(found[0] == std::pair<std::string_view, std::string_view>{ "a", "1" });
+        REQUIRE(found[1] == std::pair<std::string_view, std::string_view>{ "b", "" });
+        REQUIRE(found[2] == std::pair<std::string_view, std::string_view>{ "c", "" });
+        REQUIRE(found[3] == std::pair<std::string_view, std::string_view>{ "a", "2" });
+        REQUIRE(router::query{ "&&" }.empty() == true);
+    }
+
+    SECTION("find a parameter") {
+        router::query parameters{ "a=1&b=x%20y&a=2" };
+
+        REQUIRE(parameters.find("a") == "1");
+        REQUIRE(parameters.find("b") == "x%20y");
+        REQUIRE(parameters.find("c").has_value() == false);
+        REQUIRE(parameters.contains("b") == true);
+    }
+}
+
+namespace names {
+    constexpr char page[]   = "page";
+    constexpr char filter[] = "filter";
+}
+
+TEST_CASE("query parameters should parse correctly into structs", "[query]") {
+    struct query_struct {
+        std::size_t         page{ 1 };
+        std::string_view    filter;
+
+        using query_dto = router::query_dto<query_struct>
+            ::bind<&query_struct::page, names::page>
+            ::bind<&query_struct::filter, names::filter>;
+    };
+
+    SECTION("parse the parameters") {
+        query_struct output{};
+
+        router::to_query(router::query{ "filter=new&page=3" }, output);
+
+        REQUIRE(output.page == 3);
+        REQUIRE(output.filter == "new");
+    }
+
+    SECTION("missing parameters are left alone") {
+        query_struct output{};
+
+        REQUIRE(router::try_to_query(router::query{ "other=1" }, output) == true);
+        REQUIRE(output.page == 1);
+        REQUIRE(output.filter.empty());
+    }
+
+    SECTION("invalid parameters fail") {
+        query_struct output{};
+
+        REQUIRE(router::try_to_query(router::query{ "page=x" }, output) == false);
+        REQUIRE_THROWS(router::to_query(router::query{ "page=x" }, output));
+    }
+}